@@ -0,0 +1,204 @@
+/**
+ * @file BinaryRecordFile.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "BinaryRecordFile.h"
+
+using namespace std;
+using namespace MobileRGBD;
+
+const char BinaryRecordFile::Magic[8] = { 'M', 'R', 'G', 'B', 'D', 'R', 'E', 'C' };	/*!< @brief Magic value at the beginning of the file ("MRGBDREC"). */
+const uint32_t BinaryRecordFile::CurrentVersion = 1;									/*!< @brief Version of the format written by this code (1). */
+
+/** @brief Constructor. No file is opened.
+ */
+BinaryRecordFile::BinaryRecordFile()
+{
+	memset( &Header, 0, sizeof(Header) );
+	Records = nullptr;
+}
+
+/** @brief Open (map) a binary record file and check its header.
+ *
+ * @param FileName [in] Name of the binary file.
+ * @param ExpectedDataSize [in] Size of the data structure of the records.
+ * @return True if the file is opened and contains records of the expected size.
+ */
+bool BinaryRecordFile::Open( const string& FileName, size_t ExpectedDataSize )
+{
+	Close();
+
+	if ( Mapping.Open( FileName ) == false )
+	{
+		return false;
+	}
+
+	if ( Mapping.GetSize() < (int64_t)sizeof(BinaryRecordFileHeader) )
+	{
+		fprintf( stderr, "'%s' is not a binary record file.\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	memcpy( &Header, Mapping.GetData(), sizeof(Header) );
+
+	if ( memcmp( Header.Magic, Magic, sizeof(Magic) ) != 0 || Header.Version != CurrentVersion )
+	{
+		fprintf( stderr, "'%s' is not a binary record file (or has an unsupported version).\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	if ( Header.DataSize != (uint32_t)ExpectedDataSize || Header.RecordSize != ComputeRecordSize(ExpectedDataSize) )
+	{
+		fprintf( stderr, "Records of '%s' do not match the requested data structure.\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	if ( (int64_t)Header.HeaderSize + (int64_t)Header.NumberOfRecords*(int64_t)Header.RecordSize > Mapping.GetSize() )
+	{
+		fprintf( stderr, "'%s' is truncated.\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	Records = Mapping.GetData() + Header.HeaderSize;
+
+	return true;
+}
+
+/** @brief Close the file.
+ */
+void BinaryRecordFile::Close()
+{
+	Mapping.Close();
+	Records = nullptr;
+	memset( &Header, 0, sizeof(Header) );
+}
+
+/** @brief Search for the record matching a timestamp.
+ *
+ * @param RequestedTimestamp [in] Timestamp to search for.
+ * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+ * @param ToleranceInNs [in] Maximum distance between the requested and the found timestamps in nanoseconds (negative for unbounded).
+ * @return The record number or -1 if no record matches.
+ */
+int BinaryRecordFile::Find( const HighResTimestamp &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, int64_t ToleranceInNs ) const
+{
+	if ( IsOpen() == false )
+	{
+		return -1;
+	}
+
+	return TimestampIndex::FindTimestamp( RecordTimestamp(this), Size(), RequestedTimestamp, Policy, ToleranceInNs );
+}
+
+/** @brief Constructor. No file is opened.
+ */
+BinaryRecordFileWriter::BinaryRecordFileWriter()
+{
+	memset( &Header, 0, sizeof(Header) );
+}
+
+/** @brief Virtual destructor, always. Close the file if needed.
+ */
+BinaryRecordFileWriter::~BinaryRecordFileWriter()
+{
+	Close();
+}
+
+/** @brief Create a new binary record file.
+ *
+ * @param FileName [in] Name of the binary file.
+ * @param DataSize [in] Size of the data structure of the records.
+ * @param NumberOfFields [in] Number of fields in the schema (information only, default=0).
+ * @return True if the file has been created.
+ */
+bool BinaryRecordFileWriter::Create( const string& FileName, size_t DataSize, uint32_t NumberOfFields /* = 0 */ )
+{
+	Close();
+
+	memset( &Header, 0, sizeof(Header) );
+	memcpy( Header.Magic, BinaryRecordFile::Magic, sizeof(Header.Magic) );
+	Header.Version = BinaryRecordFile::CurrentVersion;
+	Header.HeaderSize = (uint32_t)sizeof(BinaryRecordFileHeader);
+	Header.RecordSize = BinaryRecordFile::ComputeRecordSize( DataSize );
+	Header.DataSize = (uint32_t)DataSize;
+	Header.NumberOfFields = NumberOfFields;
+
+	Record.assign( Header.RecordSize, 0 );
+
+	if ( fOut.Open( FileName.c_str(), DataFile::WRITE_MODE ) == false )
+	{
+		return false;
+	}
+
+	// Write a first header, completed when closing
+	if ( fOut.Write( &Header, sizeof(Header), 1 ) != 1 )
+	{
+		fOut.Close();
+		return false;
+	}
+
+	return true;
+}
+
+/** @brief Append a record at the end of the file.
+ *
+ * @param Timestamp [in] Timestamp of the record, must not be before the previous one.
+ * @param Data [in] Pointer on the data structure (DataSize bytes).
+ * @return True if the record has been written.
+ */
+bool BinaryRecordFileWriter::Append( const HighResTimestamp &Timestamp, const void * Data )
+{
+	if ( fOut.IsOpen() == false )
+	{
+		return false;
+	}
+
+	if ( Header.NumberOfRecords > 0 && Timestamp.Nanoseconds < Header.LastTimestamp )
+	{
+		fprintf( stderr, "Records must be ordered by timestamp.\n" );
+		return false;
+	}
+
+	// Timestamp followed by data (padding stays to 0)
+	memcpy( &Record[0], &Timestamp.Nanoseconds, sizeof(int64_t) );
+	memcpy( &Record[sizeof(int64_t)], Data, Header.DataSize );
+
+	if ( fOut.Write( &Record[0], Header.RecordSize, 1 ) != 1 )
+	{
+		return false;
+	}
+
+	if ( Header.NumberOfRecords == 0 )
+	{
+		Header.FirstTimestamp = Timestamp.Nanoseconds;
+	}
+	Header.LastTimestamp = Timestamp.Nanoseconds;
+	Header.NumberOfRecords++;
+
+	return true;
+}
+
+/** @brief Write the final header and close the file.
+ *
+ * @return True if the file is complete.
+ */
+bool BinaryRecordFileWriter::Close()
+{
+	if ( fOut.IsOpen() == false )
+	{
+		return false;
+	}
+
+	bool Result = (fOut.Seek( 0, SEEK_SET ) == 0 && fOut.Write( &Header, sizeof(Header), 1 ) == 1);
+
+	fOut.Close();
+
+	return Result;
+}
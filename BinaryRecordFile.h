@@ -0,0 +1,252 @@
+/**
+ * @file BinaryRecordFile.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __BINARY_RECORD_FILE_H__
+#define __BINARY_RECORD_FILE_H__
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <string>
+
+#include "DataFile.h"
+#include "MappedFile.h"
+#include "TimestampIndex.h"
+#include "ReadTimestampFile.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct BinaryRecordFileHeader BinaryRecordFile.h
+ * @brief Header (64 bytes) at the beginning of a binary record file. Values are stored in the native
+ *		  byte order of the machine which created the file.
+ */
+struct BinaryRecordFileHeader
+{
+	char Magic[8];					/*!< @brief Always "MRGBDREC". */
+	uint32_t Version;				/*!< @brief Version of the format (1). */
+	uint32_t HeaderSize;			/*!< @brief Size of this header, i.e. offset of the first record. */
+	uint32_t RecordSize;			/*!< @brief Size of a record: 8 bytes of timestamp followed by data padded to 8 bytes. */
+	uint32_t DataSize;				/*!< @brief Size of the data structure in each record. */
+	uint64_t NumberOfRecords;		/*!< @brief Number of records in the file. */
+	int64_t FirstTimestamp;			/*!< @brief Timestamp of the first record in nanoseconds. */
+	int64_t LastTimestamp;			/*!< @brief Timestamp of the last record in nanoseconds. */
+	uint32_t NumberOfFields;		/*!< @brief Number of fields in the schema used to create the file. */
+	uint32_t Reserved[3];			/*!< @brief Reserved for future use, set to 0. */
+};
+
+/**
+ * @class BinaryRecordFile BinaryRecordFile.cpp BinaryRecordFile.h
+ * @brief Binary file of fixed size records, each record being a timestamp (int64_t nanoseconds) followed
+ *		  by a plain data structure. Records are ordered by timestamp. The file is mapped in memory
+ *		  and records are directly accessed by number, no text parsing is done.
+ *		  Binary files are created by the BinaryRecordFileWriter class or from a textual timestamped
+ *		  file using ConvertToBinaryRecordFile.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class BinaryRecordFile
+{
+public:
+	static const char Magic[8];				/*!< @brief Magic value at the beginning of the file ("MRGBDREC"). */
+	static const uint32_t CurrentVersion;	/*!< @brief Version of the format written by this code (1). */
+
+	/** @brief Compute the size of a record for a data structure.
+	 *
+	 * @param DataSize [in] Size of the data structure.
+	 * @return 8 bytes for the timestamp plus DataSize rounded up to 8 bytes.
+	 */
+	static uint32_t ComputeRecordSize( size_t DataSize ) { return (uint32_t)(sizeof(int64_t) + ((DataSize+7) & ~(size_t)7)); }
+
+	/** @brief Constructor. No file is opened.
+	 */
+	BinaryRecordFile();
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~BinaryRecordFile() {}
+
+	/** @brief Open (map) a binary record file and check its header.
+	 *
+	 * @param FileName [in] Name of the binary file.
+	 * @param ExpectedDataSize [in] Size of the data structure of the records.
+	 * @return True if the file is opened and contains records of the expected size.
+	 */
+	bool Open( const std::string& FileName, size_t ExpectedDataSize );
+
+	/** @brief Close the file.
+	 */
+	void Close();
+
+	/** @brief Return true if the file is opened.
+	 */
+	bool IsOpen() const { return Records != nullptr; }
+
+	/** @brief Number of records in the file.
+	 */
+	size_t Size() const { return (size_t)Header.NumberOfRecords; }
+
+	/** @brief Timestamp of a record.
+	 *
+	 * @param Record [in] Record number (zero based, not checked).
+	 */
+	HighResTimestamp GetTimestamp( size_t Record ) const
+	{
+		return HighResTimestamp( *(const int64_t*)(Records + Record*(size_t)Header.RecordSize) );
+	}
+
+	/** @brief Data of a record.
+	 *
+	 * @param Record [in] Record number (zero based, not checked).
+	 */
+	const void * GetData( size_t Record ) const
+	{
+		return (const void*)(Records + Record*(size_t)Header.RecordSize + sizeof(int64_t));
+	}
+
+	/** @brief Search for the record matching a timestamp.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInNs [in] Maximum distance between the requested and the found timestamps in nanoseconds (negative for unbounded).
+	 * @return The record number or -1 if no record matches.
+	 */
+	int Find( const HighResTimestamp &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, int64_t ToleranceInNs ) const;
+
+	BinaryRecordFileHeader Header;		/*!< @brief Header of the opened file. */
+
+protected:
+	/**
+	 * @struct BinaryRecordFile::RecordTimestamp BinaryRecordFile.h
+	 * @brief Functor to access timestamps of the records in the search functions.
+	 */
+	struct RecordTimestamp
+	{
+		RecordTimestamp( const BinaryRecordFile * eFile ) : File(eFile) {}
+		HighResTimestamp operator()( size_t Record ) const { return File->GetTimestamp( Record ); }
+		const BinaryRecordFile * File;
+	};
+
+	MappedFile Mapping;					/*!< @brief Mapping of the whole file. */
+	const unsigned char * Records;		/*!< @brief Address of the first record in the mapping. */
+};
+
+/**
+ * @class BinaryRecordFileWriter BinaryRecordFile.cpp BinaryRecordFile.h
+ * @brief Write a binary record file (see BinaryRecordFile). Records must be appended ordered by timestamp.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class BinaryRecordFileWriter
+{
+public:
+	/** @brief Constructor. No file is opened.
+	 */
+	BinaryRecordFileWriter();
+
+	/** @brief Virtual destructor, always. Close the file if needed.
+	 */
+	virtual ~BinaryRecordFileWriter();
+
+	/** @brief Create a new binary record file.
+	 *
+	 * @param FileName [in] Name of the binary file.
+	 * @param DataSize [in] Size of the data structure of the records.
+	 * @param NumberOfFields [in] Number of fields in the schema (information only, default=0).
+	 * @return True if the file has been created.
+	 */
+	bool Create( const std::string& FileName, size_t DataSize, uint32_t NumberOfFields = 0 );
+
+	/** @brief Append a record at the end of the file.
+	 *
+	 * @param Timestamp [in] Timestamp of the record, must not be before the previous one.
+	 * @param Data [in] Pointer on the data structure (DataSize bytes).
+	 * @return True if the record has been written.
+	 */
+	bool Append( const HighResTimestamp &Timestamp, const void * Data );
+
+	/** @brief Write the final header and close the file.
+	 *
+	 * @return True if the file is complete.
+	 */
+	bool Close();
+
+protected:
+	DataFile fOut;						/*!< @brief Output file. */
+	BinaryRecordFileHeader Header;		/*!< @brief Header, written again when closing. */
+	std::vector<unsigned char> Record;	/*!< @brief Buffer to build a record. */
+};
+
+/** @brief Convert a textual timestamped file (read using ReadTimestampFile) to a binary record file using
+ *		   a DataSchema to parse the data part of the lines. Lines which do not match the schema are ignored.
+ *
+ * @param TextFileName [in] Name of the textual timestamped file (usual or compressed).
+ * @param BinaryFileName [in] Name of the binary file to create.
+ * @return Number of converted lines or -1 if an error occured.
+ */
+template<typename Schema>
+long long int ConvertToBinaryRecordFile( const std::string& TextFileName, const std::string& BinaryFileName )
+{
+	typedef typename Schema::StructType Struct;
+
+	ReadTimestampFile TextFile( TextFileName );
+	BinaryRecordFileWriter BinaryFile;
+	long long int NumberOfRecords = 0;
+
+	if ( BinaryFile.Create( BinaryFileName, sizeof(Struct), (uint32_t)Schema::NumberOfFields ) == false )
+	{
+		return -1;
+	}
+
+	// Lines are read through the index, GetNextTimestamp keeps the last line at the end of the file
+	if ( TextFile.BuildIndex() == false )
+	{
+		// No line or no file: an empty text file gives an empty binary file
+		DataFile Check;
+		if ( Check.Open( TextFile.GetFileName().c_str(), DataFile::READ_MODE ) == false )
+		{
+			BinaryFile.Close();
+			remove( BinaryFileName.c_str() );
+			return -1;
+		}
+		Check.Close();
+	}
+
+	for( size_t Entry = 0; Entry < TextFile.Index.Size(); Entry++ )
+	{
+		Struct Values;
+
+		if ( TextFile.GoToIndexEntry( (int)Entry ) == false )
+		{
+			BinaryFile.Close();
+			return -1;
+		}
+
+		if ( Schema::Parse( &TextFile.LineBuffer[TextFile.EndOfTimestampPosition], Values ) == false )
+		{
+			continue;
+		}
+
+		if ( BinaryFile.Append( TextFile.CurrentHighResTimestamp, &Values ) == false )
+		{
+			BinaryFile.Close();
+			return -1;
+		}
+		NumberOfRecords++;
+	}
+
+	if ( BinaryFile.Close() == false )
+	{
+		return -1;
+	}
+
+	return NumberOfRecords;
+}
+
+} // namespace MobileRGBD
+
+#endif // __BINARY_RECORD_FILE_H__
@@ -0,0 +1,750 @@
+/**
+ * @file CompressedRawFile.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "CompressedRawFile.h"
+
+#include <string.h>
+
+#if defined _MSC_VER
+	#include <stdlib.h>
+	#include <intrin.h>
+#endif
+
+using namespace std;
+using namespace MobileRGBD;
+
+const char CompressedRawFile::Magic[8] = { 'M', 'R', 'G', 'B', 'D', 'C', 'R', 'F' };	/*!< @brief Magic value at the beginning of the file ("MRGBDCRF"). */
+const uint32_t CompressedRawFile::CurrentVersion = 1;									/*!< @brief Version of the format written by this code (1). */
+
+namespace {
+
+	const size_t RiceBlockSize = 32;		/*!< @brief Number of values sharing the same Rice parameter. */
+	const uint32_t RiceEscapeLength = 24;	/*!< @brief Quotients from this value are escaped, the value is written with 16 bits. */
+	const size_t FramesPerTask = 4;			/*!< @brief Number of frames compressed by a task of the writer. */
+
+	/** @brief Swap bytes of a 64 bits value (files are read as big endian bit streams).
+	 */
+	inline uint64_t ByteSwap64( uint64_t Value )
+	{
+#if defined _MSC_VER
+		return _byteswap_uint64( Value );
+#else
+		return __builtin_bswap64( Value );
+#endif
+	}
+
+	/** @brief Number of leading 1 bits of a value (at most 63).
+	 */
+	inline uint32_t CountLeadingOnes( uint64_t Value )
+	{
+#if defined _MSC_VER
+		unsigned long Position;
+		_BitScanReverse64( &Position, ~Value | 1 );
+		return (uint32_t)(63 - Position);
+#else
+		return (uint32_t)__builtin_clzll( ~Value | 1 );
+#endif
+	}
+
+	/** @brief Median edge detector of LOCO-I: the gradient prediction clamped between the left and up values.
+	 */
+	inline int MedianPredictor( int Left, int Up, int UpLeft )
+	{
+		int Max = Left > Up ? Left : Up;
+		int Min = Left < Up ? Left : Up;
+		int Gradient = Left + Up - UpLeft;
+
+		// Branchless, the result is unpredictable on real data
+		Gradient = Gradient < Min ? Min : Gradient;
+		return Gradient > Max ? Max : Gradient;
+	}
+
+	/** @brief Predict a 16 bits value from its already known neighbours.
+	 *
+	 * @param Values [in] Values of the frame.
+	 * @param i [in] Index of the value to predict.
+	 * @param x [in] Column of the value.
+	 * @param Width [in] Width of the frame (0 if unknown, the previous value is used).
+	 */
+	inline int Predict( const uint16_t * Values, size_t i, size_t x, size_t Width )
+	{
+		if ( i == 0 )
+		{
+			return 0;
+		}
+		if ( Width == 0 || i < Width )
+		{
+			return Values[i-1];
+		}
+		if ( x == 0 )
+		{
+			return Values[i-Width];
+		}
+		return MedianPredictor( Values[i-1], Values[i-Width], Values[i-Width-1] );
+	}
+
+	/** @brief Replace zigzag coded residuals by the values, same prediction as Predict but row by row
+	 *		   to keep neighbours in registers.
+	 *
+	 * @param Values [in,out] Residuals, replaced by the values.
+	 * @param NumberOfValues [in] Number of values.
+	 * @param Width [in] Width of the frame (0 if unknown).
+	 */
+	inline void UndoPrediction( uint16_t * Values, size_t NumberOfValues, size_t Width )
+	{
+		size_t FirstRowSize = (Width == 0 || Width > NumberOfValues) ? NumberOfValues : Width;
+		int Left = 0;
+
+		for( size_t i = 0; i < FirstRowSize; i++ )
+		{
+			int Residual = Values[i];
+			Left = (uint16_t)(Left + ((Residual >> 1) ^ -(Residual & 1)));
+			Values[i] = (uint16_t)Left;
+		}
+
+		for( size_t RowStart = FirstRowSize; RowStart < NumberOfValues; RowStart += Width )
+		{
+			uint16_t * Row = Values + RowStart;
+			const uint16_t * PreviousRow = Row - Width;
+			size_t RowSize = NumberOfValues - RowStart < Width ? NumberOfValues - RowStart : Width;
+
+			int Residual = Row[0];
+			Left = (uint16_t)(PreviousRow[0] + ((Residual >> 1) ^ -(Residual & 1)));
+			Row[0] = (uint16_t)Left;
+
+			for( size_t x = 1; x < RowSize; x++ )
+			{
+				Residual = Row[x];
+				Left = (uint16_t)(MedianPredictor( Left, PreviousRow[x], PreviousRow[x-1] ) + ((Residual >> 1) ^ -(Residual & 1)));
+				Row[x] = (uint16_t)Left;
+			}
+		}
+	}
+
+	/**
+	 * @class BitWriter CompressedRawFile.cpp
+	 * @brief Write a bit stream, most significant bits first.
+	 */
+	class BitWriter
+	{
+	public:
+		BitWriter( vector<unsigned char> &eOutput ) : Output(eOutput), Accumulator(0), NumberOfBits(0) {}
+
+		/** @brief Write the NumberOfBitsToWrite (at most 32) lower bits of Value.
+		 */
+		void Put( uint32_t Value, uint32_t NumberOfBitsToWrite )
+		{
+			Accumulator = (Accumulator << NumberOfBitsToWrite) | Value;
+			NumberOfBits += NumberOfBitsToWrite;
+			while( NumberOfBits >= 8 )
+			{
+				NumberOfBits -= 8;
+				Output.push_back( (unsigned char)(Accumulator >> NumberOfBits) );
+			}
+		}
+
+		/** @brief Write the last incomplete byte.
+		 */
+		void Flush()
+		{
+			if ( NumberOfBits > 0 )
+			{
+				Output.push_back( (unsigned char)(Accumulator << (8 - NumberOfBits)) );
+				NumberOfBits = 0;
+			}
+		}
+
+	protected:
+		vector<unsigned char> &Output;
+		uint64_t Accumulator;
+		uint32_t NumberOfBits;
+	};
+
+	/**
+	 * @class BitReader CompressedRawFile.cpp
+	 * @brief Read a bit stream written by BitWriter. Bits are kept in a 64 bits buffer refilled
+	 *		  without branch, reading a value does not wait for a memory load.
+	 */
+	class BitReader
+	{
+	public:
+		BitReader( const unsigned char * eStream, size_t eSize ) : Stream(eStream), Size(eSize), Position(0), Buffer(0), NumberOfBits(0) {}
+
+		/** @brief Make at least 56 bits available. Reading after the end of the stream gives 0 bits.
+		 */
+		void Refill()
+		{
+			uint64_t Next = 0;
+
+			if ( Position + sizeof(Next) <= Size )
+			{
+				memcpy( &Next, Stream + Position, sizeof(Next) );
+			}
+			else if ( Position < Size )
+			{
+				memcpy( &Next, Stream + Position, Size - Position );
+			}
+
+			Buffer |= ByteSwap64( Next ) >> NumberOfBits;
+			Position += (63 - NumberOfBits) >> 3;
+			NumberOfBits |= 56;
+		}
+
+		/** @brief Next bits, most significant bit first.
+		 */
+		uint64_t Peek() const { return Buffer; }
+
+		/** @brief Consume bits (at most the number of available bits).
+		 */
+		void Skip( uint32_t NumberOfBitsToSkip )
+		{
+			Buffer <<= NumberOfBitsToSkip;
+			NumberOfBits -= NumberOfBitsToSkip;
+		}
+
+		/** @brief Number of bits consumed since the beginning of the stream.
+		 */
+		size_t GetConsumedBits() const { return Position*8 - NumberOfBits; }
+
+	protected:
+		const unsigned char * Stream;
+		size_t Size;
+		size_t Position;
+		uint64_t Buffer;
+		uint32_t NumberOfBits;
+	};
+
+} // namespace
+
+/** @brief Constructor. No file is opened.
+ */
+CompressedRawFile::CompressedRawFile()
+{
+	memset( &Header, 0, sizeof(Header) );
+	Offsets = nullptr;
+	NumberOfThreads = 0;
+}
+
+/** @brief Check if a file is a compressed raw file, i.e. starts with the magic value.
+ *
+ * @param FileName [in] Name of the file.
+ */
+bool CompressedRawFile::IsCompressedRawFile( const string& FileName )
+{
+	char FileMagic[sizeof(Magic)];
+	bool Result = false;
+
+	FILE * fIn = fopen( FileName.c_str(), "rb" );
+	if ( fIn != nullptr )
+	{
+		Result = (fread( FileMagic, sizeof(FileMagic), 1, fIn ) == 1 && memcmp( FileMagic, Magic, sizeof(Magic) ) == 0);
+		fclose( fIn );
+	}
+
+	return Result;
+}
+
+/** @brief Open (map) a compressed raw file and check its header.
+ *
+ * @param FileName [in] Name of the compressed raw file.
+ * @param ExpectedFrameSize [in] Size of uncompressed frames expected by the caller.
+ * @return True if the file is opened.
+ */
+bool CompressedRawFile::Open( const string& FileName, int ExpectedFrameSize )
+{
+	Close();
+
+	if ( Mapping.Open( FileName ) == false )
+	{
+		return false;
+	}
+
+	if ( Mapping.GetSize() < (int64_t)sizeof(CompressedRawFileHeader) )
+	{
+		fprintf( stderr, "'%s' is not a compressed raw file.\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	memcpy( &Header, Mapping.GetData(), sizeof(Header) );
+
+	if ( memcmp( Header.Magic, Magic, sizeof(Magic) ) != 0 || Header.Version != CurrentVersion )
+	{
+		fprintf( stderr, "'%s' is not a compressed raw file (or has an unsupported version).\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	if ( Header.FrameSize != (uint32_t)ExpectedFrameSize )
+	{
+		fprintf( stderr, "Frames of '%s' do not have the requested size.\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	// The table is aligned, it is accessed directly in the mapping
+	if ( Header.TableOffset < sizeof(CompressedRawFileHeader) || (Header.TableOffset % sizeof(int64_t)) != 0 ||
+		 (int64_t)Header.TableOffset + (int64_t)(Header.NumberOfFrames+1)*(int64_t)sizeof(int64_t) > Mapping.GetSize() )
+	{
+		fprintf( stderr, "'%s' is truncated.\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	Offsets = (const int64_t*)(Mapping.GetData() + Header.TableOffset);
+
+	return true;
+}
+
+/** @brief Close the file.
+ */
+void CompressedRawFile::Close()
+{
+	Mapping.Close();
+	Offsets = nullptr;
+	memset( &Header, 0, sizeof(Header) );
+}
+
+/** @brief Use worker threads to decode several frames at once (see DecodeFrames).
+ *
+ * @param eNumberOfThreads [in] Number of threads, 0 for the number of hardware threads (default), 1 to decode in the calling thread.
+ */
+void CompressedRawFile::SetNumberOfThreads( unsigned int eNumberOfThreads )
+{
+	Workers.reset();
+	NumberOfThreads = eNumberOfThreads;
+}
+
+/** @brief Decode consecutive frames.
+ *
+ * @param FirstFrame [in] Zero based index of the first frame.
+ * @param NumberOfFrames [in] Number of frames.
+ * @param Output [out] Buffer of NumberOfFrames*FrameSize bytes.
+ * @return True if all frames were decoded.
+ */
+bool CompressedRawFile::DecodeFrames( int64_t FirstFrame, int64_t NumberOfFrames, unsigned char * Output )
+{
+	if ( IsOpen() == false || FirstFrame < 0 || NumberOfFrames < 0 || FirstFrame + NumberOfFrames > (int64_t)Header.NumberOfFrames )
+	{
+		return false;
+	}
+
+	if ( NumberOfFrames <= 1 || NumberOfThreads == 1 )
+	{
+		for( int64_t i = 0; i < NumberOfFrames; i++ )
+		{
+			if ( DecodeFrame( FirstFrame + i, Output + i*(int64_t)Header.FrameSize ) == false )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Frames are independent, decode them in parallel
+	if ( Workers == nullptr )
+	{
+		Workers.reset( new ThreadPool( NumberOfThreads ) );
+	}
+
+	vector< future<bool> > Results;
+	for( int64_t i = 0; i < NumberOfFrames; i++ )
+	{
+		int64_t Frame = FirstFrame + i;
+		unsigned char * FrameOutput = Output + i*(int64_t)Header.FrameSize;
+
+		Results.push_back( Workers->Submit( [=]() { return DecodeFrame( Frame, FrameOutput ); } ) );
+	}
+
+	bool Result = true;
+	for( size_t i = 0; i < Results.size(); i++ )
+	{
+		Result = Results[i].get() && Result;
+	}
+
+	return Result;
+}
+
+/** @brief Decode a frame of the file.
+ *
+ * @param Frame [in] Zero based index of the frame.
+ * @param Output [out] Buffer of FrameSize bytes.
+ * @return True if the frame was decoded.
+ */
+bool CompressedRawFile::DecodeFrame( int64_t Frame, unsigned char * Output )
+{
+	int64_t Start = Offsets[Frame];
+	int64_t End = Offsets[Frame+1];
+
+	// The offset table follows the frames, at least 8 bytes are readable after each frame
+	if ( Start < (int64_t)sizeof(CompressedRawFileHeader) || End < Start || End > (int64_t)Header.TableOffset )
+	{
+		return false;
+	}
+
+	return DecodeFrame( Mapping.GetData() + Start, (size_t)(End - Start), Header.FrameSize, Header.Width, Output );
+}
+
+/** @brief Compress a frame.
+ *
+ * @param Frame [in] Uncompressed frame.
+ * @param FrameSize [in] Size of the frame.
+ * @param Width [in] Width of the frame for 16 bits values (0 if unknown).
+ * @param Compressed [out] Compressed frame.
+ */
+void CompressedRawFile::EncodeFrame( const unsigned char * Frame, size_t FrameSize, unsigned int Width, vector<unsigned char> &Compressed )
+{
+	Compressed.clear();
+
+	if ( (FrameSize % sizeof(uint16_t)) == 0 )
+	{
+		const uint16_t * Values = (const uint16_t*)Frame;
+		size_t NumberOfValues = FrameSize/sizeof(uint16_t);
+		uint16_t Residuals[RiceBlockSize];
+		size_t x = 0;
+
+		Compressed.reserve( FrameSize/2 );
+		Compressed.push_back( (unsigned char)Delta16RiceFrame );
+		BitWriter Bits( Compressed );
+
+		for( size_t BlockStart = 0; BlockStart < NumberOfValues; BlockStart += RiceBlockSize )
+		{
+			size_t BlockSize = NumberOfValues - BlockStart < RiceBlockSize ? NumberOfValues - BlockStart : RiceBlockSize;
+			uint64_t Sum = 0;
+
+			// Prediction residuals, zigzag coded (small negative values become small positive ones)
+			for( size_t j = 0; j < BlockSize; j++ )
+			{
+				size_t i = BlockStart + j;
+				int16_t Residual = (int16_t)(uint16_t)((int)Values[i] - Predict( Values, i, x, Width ));
+
+				Residuals[j] = (uint16_t)(((uint32_t)(int32_t)Residual << 1) ^ (uint32_t)(Residual >> 15));
+				Sum += Residuals[j];
+
+				if ( ++x == Width )
+				{
+					x = 0;
+				}
+			}
+
+			// Rice parameter close to log2 of the mean residual
+			uint32_t k = 0;
+			while( k < 15 && ((uint64_t)BlockSize << (k+1)) <= Sum )
+			{
+				k++;
+			}
+			Bits.Put( k, 4 );
+
+			for( size_t j = 0; j < BlockSize; j++ )
+			{
+				uint32_t Quotient = (uint32_t)Residuals[j] >> k;
+
+				if ( Quotient < RiceEscapeLength )
+				{
+					// Quotient in unary (1s ended by a 0), then k bits of remainder
+					Bits.Put( ((1u << Quotient) - 1) << 1, Quotient + 1 );
+					Bits.Put( (uint32_t)Residuals[j] & ((1u << k) - 1), k );
+				}
+				else
+				{
+					Bits.Put( (1u << RiceEscapeLength) - 1, RiceEscapeLength );
+					Bits.Put( Residuals[j], 16 );
+				}
+			}
+		}
+		Bits.Flush();
+
+		if ( Compressed.size() <= FrameSize )
+		{
+			return;
+		}
+	}
+
+	// Not 16 bits values or not compressible
+	Compressed.resize( FrameSize + 1 );
+	Compressed[0] = (unsigned char)StoredFrame;
+	memcpy( &Compressed[1], Frame, FrameSize );
+}
+
+/** @brief Decode a compressed frame.
+ *
+ * @param Compressed [in] Compressed frame.
+ * @param CompressedSize [in] Size of the compressed frame.
+ * @param FrameSize [in] Size of the uncompressed frame.
+ * @param Width [in] Width of the frame for 16 bits values (0 if unknown).
+ * @param Frame [out] Uncompressed frame.
+ * @return True if the frame was decoded.
+ */
+bool CompressedRawFile::DecodeFrame( const unsigned char * Compressed, size_t CompressedSize, size_t FrameSize, unsigned int Width, unsigned char * Frame )
+{
+	if ( CompressedSize < 1 )
+	{
+		return false;
+	}
+
+	if ( Compressed[0] == (unsigned char)StoredFrame )
+	{
+		if ( CompressedSize != FrameSize + 1 )
+		{
+			return false;
+		}
+		memcpy( Frame, Compressed + 1, FrameSize );
+		return true;
+	}
+
+	if ( Compressed[0] != (unsigned char)Delta16RiceFrame || (FrameSize % sizeof(uint16_t)) != 0 )
+	{
+		return false;
+	}
+
+	uint16_t * Values = (uint16_t*)Frame;
+	size_t NumberOfValues = FrameSize/sizeof(uint16_t);
+	BitReader Bits( Compressed + 1, CompressedSize - 1 );
+
+	for( size_t BlockStart = 0; BlockStart < NumberOfValues; BlockStart += RiceBlockSize )
+	{
+		size_t BlockEnd = NumberOfValues - BlockStart < RiceBlockSize ? NumberOfValues : BlockStart + RiceBlockSize;
+
+		Bits.Refill();
+		uint32_t k = (uint32_t)(Bits.Peek() >> 60);
+		Bits.Skip( 4 );
+
+		for( size_t i = BlockStart; i < BlockEnd; i++ )
+		{
+			// A value uses at most 40 bits
+			Bits.Refill();
+			uint64_t Next = Bits.Peek();
+
+			uint32_t Quotient = CountLeadingOnes( Next );
+			if ( Quotient < RiceEscapeLength )
+			{
+				Values[i] = (uint16_t)((Quotient << k) | (uint32_t)(((Next << (Quotient+1)) >> 1) >> (63-k)));
+				Bits.Skip( Quotient + 1 + k );
+			}
+			else
+			{
+				Values[i] = (uint16_t)((Next << RiceEscapeLength) >> 48);
+				Bits.Skip( RiceEscapeLength + 16 );
+			}
+		}
+	}
+
+	if ( Bits.GetConsumedBits() > (CompressedSize - 1)*8 )
+	{
+		// Corrupted frame
+		return false;
+	}
+
+	// Residuals are decoded, now the values
+	UndoPrediction( Values, NumberOfValues, Width );
+
+	return true;
+}
+
+/** @brief Constructor. No file is opened.
+ */
+CompressedRawFileWriter::CompressedRawFileWriter()
+{
+	memset( &Header, 0, sizeof(Header) );
+	NumberOfPending = 0;
+}
+
+/** @brief Virtual destructor, always. Close the file if needed.
+ */
+CompressedRawFileWriter::~CompressedRawFileWriter()
+{
+	Close();
+}
+
+/** @brief Create a new compressed raw file.
+ *
+ * @param FileName [in] Name of the file.
+ * @param FrameSize [in] Size of the frames (or subframes).
+ * @param Width [in] Width of the frames for 16 bits values, improves compression (0 if unknown, default=0).
+ * @param NumberOfThreads [in] Number of threads compressing frames, 0 for the number of hardware threads (default=0).
+ * @return True if the file has been created.
+ */
+bool CompressedRawFileWriter::Create( const string& FileName, int FrameSize, unsigned int Width /* = 0 */, unsigned int NumberOfThreads /* = 0 */ )
+{
+	Close();
+
+	if ( FrameSize <= 0 )
+	{
+		return false;
+	}
+
+	memset( &Header, 0, sizeof(Header) );
+	memcpy( Header.Magic, CompressedRawFile::Magic, sizeof(Header.Magic) );
+	Header.Version = CompressedRawFile::CurrentVersion;
+	Header.FrameSize = (uint32_t)FrameSize;
+	Header.Width = Width;
+
+	Workers.reset( new ThreadPool( NumberOfThreads ) );
+	Pending.resize( Workers->GetNumberOfThreads()*FramesPerTask );
+	Compressed.resize( Pending.size() );
+	NumberOfPending = 0;
+	Offsets.clear();
+
+	if ( fOut.Open( FileName.c_str(), DataFile::WRITE_MODE ) == false )
+	{
+		return false;
+	}
+
+	// Write a first header, completed when closing
+	if ( fOut.Write( &Header, sizeof(Header), 1 ) != 1 )
+	{
+		fOut.Close();
+		return false;
+	}
+	Offsets.push_back( (int64_t)sizeof(Header) );
+
+	return true;
+}
+
+/** @brief Append a frame at the end of the file.
+ *
+ * @param Frame [in] Pointer on the frame (FrameSize bytes).
+ * @return True if the frame has been added.
+ */
+bool CompressedRawFileWriter::Append( const void * Frame )
+{
+	if ( fOut.IsOpen() == false )
+	{
+		return false;
+	}
+
+	Pending[NumberOfPending].assign( (const unsigned char*)Frame, (const unsigned char*)Frame + Header.FrameSize );
+	NumberOfPending++;
+
+	if ( NumberOfPending == Pending.size() )
+	{
+		return Flush();
+	}
+
+	return true;
+}
+
+/** @brief Compress and write the pending frames.
+ *
+ * @return True if the frames have been written.
+ */
+bool CompressedRawFileWriter::Flush()
+{
+	vector< future<void> > Results;
+
+	for( size_t Task = 0; Task*FramesPerTask < NumberOfPending; Task++ )
+	{
+		size_t First = Task*FramesPerTask;
+		size_t Last = First + FramesPerTask < NumberOfPending ? First + FramesPerTask : NumberOfPending;
+
+		Results.push_back( Workers->Submit( [=]() {
+			for( size_t i = First; i < Last; i++ )
+			{
+				CompressedRawFile::EncodeFrame( &Pending[i][0], Header.FrameSize, Header.Width, Compressed[i] );
+			}
+		} ) );
+	}
+
+	for( size_t i = 0; i < Results.size(); i++ )
+	{
+		Results[i].get();
+	}
+
+	// Write frames in order
+	bool Result = true;
+	for( size_t i = 0; i < NumberOfPending && Result == true; i++ )
+	{
+		Result = (fOut.Write( &Compressed[i][0], Compressed[i].size(), 1 ) == 1);
+		Offsets.push_back( Offsets.back() + (int64_t)Compressed[i].size() );
+	}
+	NumberOfPending = 0;
+
+	return Result;
+}
+
+/** @brief Write the pending frames, the offset table and the final header and close the file.
+ *
+ * @return True if the file is complete.
+ */
+bool CompressedRawFileWriter::Close()
+{
+	if ( fOut.IsOpen() == false )
+	{
+		return false;
+	}
+
+	bool Result = Flush();
+
+	// Aligned offset table after the frames
+	int64_t EndOfFrames = Offsets.back();
+	int64_t Padding = (int64_t)(sizeof(int64_t) - EndOfFrames % sizeof(int64_t)) % (int64_t)sizeof(int64_t);
+	int64_t Zero = 0;
+
+	Header.NumberOfFrames = (uint64_t)(Offsets.size()-1);
+	Header.TableOffset = (uint64_t)(EndOfFrames + Padding);
+
+	if ( Result == true && Padding > 0 )
+	{
+		Result = (fOut.Write( &Zero, (size_t)Padding, 1 ) == 1);
+	}
+	if ( Result == true )
+	{
+		Result = (fOut.Write( &Offsets[0], sizeof(int64_t), Offsets.size() ) == Offsets.size());
+	}
+	if ( Result == true )
+	{
+		Result = (fOut.Seek( 0, SEEK_SET ) == 0 && fOut.Write( &Header, sizeof(Header), 1 ) == 1);
+	}
+
+	fOut.Close();
+	Workers.reset();
+
+	return Result;
+}
+
+/** @brief Convert a raw file (usual or compressed with 7z) to a compressed raw file.
+ *
+ * @param RawFileName [in] Name of the raw file.
+ * @param CompressedFileName [in] Name of the compressed raw file to create.
+ * @param FrameSize [in] Size of the frames (or subframes).
+ * @param Width [in] Width of the frames for 16 bits values, improves compression (0 if unknown, default=0).
+ * @return Number of converted frames or -1 if an error occured.
+ */
+long long int MobileRGBD::ConvertToCompressedRawFile( const string& RawFileName, const string& CompressedFileName, int FrameSize, unsigned int Width /* = 0 */ )
+{
+	DataFile fRaw;
+	CompressedRawFileWriter CompressedFile;
+	long long int NumberOfFrames = 0;
+
+	if ( FrameSize <= 0 || fRaw.Open( RawFileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return -1;
+	}
+
+	if ( CompressedFile.Create( CompressedFileName, FrameSize, Width ) == false )
+	{
+		return -1;
+	}
+
+	vector<unsigned char> Frame( (size_t)FrameSize );
+	while( fRaw.Read( &Frame[0], Frame.size(), 1 ) == 1 )
+	{
+		if ( CompressedFile.Append( &Frame[0] ) == false )
+		{
+			CompressedFile.Close();
+			return -1;
+		}
+		NumberOfFrames++;
+	}
+
+	if ( CompressedFile.Close() == false )
+	{
+		return -1;
+	}
+
+	return NumberOfFrames;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file CompressedRawFile.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __COMPRESSED_RAW_FILE_H__
+#define __COMPRESSED_RAW_FILE_H__
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "DataFile.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct CompressedRawFileHeader CompressedRawFile.h
+ * @brief Header (48 bytes) at the beginning of a compressed raw file. Values are stored in the native
+ *		  byte order of the machine which created the file.
+ */
+struct CompressedRawFileHeader
+{
+	char Magic[8];					/*!< @brief Always "MRGBDCRF". */
+	uint32_t Version;				/*!< @brief Version of the format (1). */
+	uint32_t FrameSize;				/*!< @brief Size of an uncompressed frame (or subframe). */
+	uint32_t Width;					/*!< @brief Width of the frames for 16 bits values (0 if unknown, prediction uses the previous value only). */
+	uint32_t Reserved;				/*!< @brief Reserved for future use, set to 0. */
+	uint64_t NumberOfFrames;		/*!< @brief Number of frames (or subframes) in the file. */
+	uint64_t TableOffset;			/*!< @brief Position of the frame offset table (NumberOfFrames+1 int64_t values) at the end of the file. */
+};
+
+/**
+ * @class CompressedRawFile CompressedRawFile.cpp CompressedRawFile.h
+ * @brief Raw file where each frame is compressed independently, with a table giving the position of each
+ *		  frame. Any frame can be decoded alone and several frames can be decoded in parallel.
+ *		  Frames of 16 bits values (depth, infrared) are predicted from their neighbours and residuals are
+ *		  written with adaptive Rice codes (lossless). Other frames, or frames which do not compress,
+ *		  are stored as is. The file is mapped in memory.
+ *		  ReadTimestampRawFile reads compressed raw files transparently. They are created
+ *		  by CompressedRawFileWriter or from a raw file using ConvertToCompressedRawFile.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class CompressedRawFile
+{
+public:
+	static const char Magic[8];				/*!< @brief Magic value at the beginning of the file ("MRGBDCRF"). */
+	static const uint32_t CurrentVersion;	/*!< @brief Version of the format written by this code (1). */
+
+	/** @enum CompressedRawFile::FrameCodec
+	 *  @brief Codec of a frame, first byte of each compressed frame.
+	 */
+	enum FrameCodec
+	{
+		StoredFrame = 0,			/*!< @brief Frame stored without compression. */
+		Delta16RiceFrame = 1		/*!< @brief 16 bits values, prediction residuals coded with adaptive Rice codes. */
+	};
+
+	/** @brief Constructor. No file is opened.
+	 */
+	CompressedRawFile();
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~CompressedRawFile() {}
+
+	/** @brief Check if a file is a compressed raw file, i.e. starts with the magic value.
+	 *
+	 * @param FileName [in] Name of the file.
+	 */
+	static bool IsCompressedRawFile( const std::string& FileName );
+
+	/** @brief Open (map) a compressed raw file and check its header.
+	 *
+	 * @param FileName [in] Name of the compressed raw file.
+	 * @param ExpectedFrameSize [in] Size of uncompressed frames expected by the caller.
+	 * @return True if the file is opened.
+	 */
+	bool Open( const std::string& FileName, int ExpectedFrameSize );
+
+	/** @brief Close the file.
+	 */
+	void Close();
+
+	/** @brief Return true if the file is opened.
+	 */
+	bool IsOpen() const { return Offsets != nullptr; }
+
+	/** @brief Number of frames (or subframes) in the file.
+	 */
+	size_t GetNumberOfFrames() const { return (size_t)Header.NumberOfFrames; }
+
+	/** @brief Use worker threads to decode several frames at once (see DecodeFrames).
+	 *
+	 * @param eNumberOfThreads [in] Number of threads, 0 for the number of hardware threads (default), 1 to decode in the calling thread.
+	 */
+	void SetNumberOfThreads( unsigned int eNumberOfThreads );
+
+	/** @brief Decode consecutive frames.
+	 *
+	 * @param FirstFrame [in] Zero based index of the first frame.
+	 * @param NumberOfFrames [in] Number of frames.
+	 * @param Output [out] Buffer of NumberOfFrames*FrameSize bytes.
+	 * @return True if all frames were decoded.
+	 */
+	bool DecodeFrames( int64_t FirstFrame, int64_t NumberOfFrames, unsigned char * Output );
+
+	/** @brief Compress a frame.
+	 *
+	 * @param Frame [in] Uncompressed frame.
+	 * @param FrameSize [in] Size of the frame.
+	 * @param Width [in] Width of the frame for 16 bits values (0 if unknown).
+	 * @param Compressed [out] Compressed frame.
+	 */
+	static void EncodeFrame( const unsigned char * Frame, size_t FrameSize, unsigned int Width, std::vector<unsigned char> &Compressed );
+
+	/** @brief Decode a compressed frame.
+	 *
+	 * @param Compressed [in] Compressed frame.
+	 * @param CompressedSize [in] Size of the compressed frame.
+	 * @param FrameSize [in] Size of the uncompressed frame.
+	 * @param Width [in] Width of the frame for 16 bits values (0 if unknown).
+	 * @param Frame [out] Uncompressed frame.
+	 * @return True if the frame was decoded.
+	 */
+	static bool DecodeFrame( const unsigned char * Compressed, size_t CompressedSize, size_t FrameSize, unsigned int Width, unsigned char * Frame );
+
+	CompressedRawFileHeader Header;		/*!< @brief Header of the opened file. */
+
+protected:
+	/** @brief Decode a frame of the file.
+	 *
+	 * @param Frame [in] Zero based index of the frame.
+	 * @param Output [out] Buffer of FrameSize bytes.
+	 * @return True if the frame was decoded.
+	 */
+	bool DecodeFrame( int64_t Frame, unsigned char * Output );
+
+	MappedFile Mapping;							/*!< @brief Mapping of the whole file. */
+	const int64_t * Offsets;					/*!< @brief Frame offset table in the mapping. */
+	unsigned int NumberOfThreads;				/*!< @brief Number of threads decoding frames (see SetNumberOfThreads). */
+	std::unique_ptr<ThreadPool> Workers;		/*!< @brief Threads decoding frames in parallel, created when needed. */
+};
+
+/**
+ * @class CompressedRawFileWriter CompressedRawFile.cpp CompressedRawFile.h
+ * @brief Write a compressed raw file (see CompressedRawFile). Frames are compressed in parallel
+ *		  by batches.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class CompressedRawFileWriter
+{
+public:
+	/** @brief Constructor. No file is opened.
+	 */
+	CompressedRawFileWriter();
+
+	/** @brief Virtual destructor, always. Close the file if needed.
+	 */
+	virtual ~CompressedRawFileWriter();
+
+	/** @brief Create a new compressed raw file.
+	 *
+	 * @param FileName [in] Name of the file.
+	 * @param FrameSize [in] Size of the frames (or subframes).
+	 * @param Width [in] Width of the frames for 16 bits values, improves compression (0 if unknown, default=0).
+	 * @param NumberOfThreads [in] Number of threads compressing frames, 0 for the number of hardware threads (default=0).
+	 * @return True if the file has been created.
+	 */
+	bool Create( const std::string& FileName, int FrameSize, unsigned int Width = 0, unsigned int NumberOfThreads = 0 );
+
+	/** @brief Append a frame at the end of the file.
+	 *
+	 * @param Frame [in] Pointer on the frame (FrameSize bytes).
+	 * @return True if the frame has been added.
+	 */
+	bool Append( const void * Frame );
+
+	/** @brief Write the pending frames, the offset table and the final header and close the file.
+	 *
+	 * @return True if the file is complete.
+	 */
+	bool Close();
+
+protected:
+	/** @brief Compress and write the pending frames.
+	 *
+	 * @return True if the frames have been written.
+	 */
+	bool Flush();
+
+	DataFile fOut;										/*!< @brief Output file. */
+	CompressedRawFileHeader Header;						/*!< @brief Header, written again when closing. */
+	std::vector<int64_t> Offsets;						/*!< @brief Position of each frame written. */
+	std::vector< std::vector<unsigned char> > Pending;	/*!< @brief Frames waiting for compression. */
+	std::vector< std::vector<unsigned char> > Compressed;	/*!< @brief Compressed pending frames. */
+	size_t NumberOfPending;								/*!< @brief Number of frames in Pending. */
+	std::unique_ptr<ThreadPool> Workers;				/*!< @brief Threads compressing frames. */
+};
+
+/** @brief Convert a raw file (usual or compressed with 7z) to a compressed raw file.
+ *
+ * @param RawFileName [in] Name of the raw file.
+ * @param CompressedFileName [in] Name of the compressed raw file to create.
+ * @param FrameSize [in] Size of the frames (or subframes).
+ * @param Width [in] Width of the frames for 16 bits values, improves compression (0 if unknown, default=0).
+ * @return Number of converted frames or -1 if an error occured.
+ */
+long long int ConvertToCompressedRawFile( const std::string& RawFileName, const std::string& CompressedFileName, int FrameSize, unsigned int Width = 0 );
+
+} // namespace MobileRGBD
+
+#endif // __COMPRESSED_RAW_FILE_H__
@@ -12,59 +12,96 @@
 
 namespace MobileRGBD {
 
+/**
+ * @class ConstantFpsTimestampFromFile ConstantFpsTimestampFromFile.h
+ * @brief Generate timestamps at a constant frame rate between the first and the last timestamps of a file.
+ *		  Time range is retrieved without reading the whole file (see ReadTimestamp::GetTimeRange) and
+ *		  timestamps are computed on demand from the first one, without accumulating rounding errors.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
 class ConstantFpsTimestampFromFile : public ReadTimestamp
 {
 public :
+	/** @brief Constructor. Create a ConstantFpsTimestampFromFile object using specific file.
+	 *
+	 * @param FileName [in] Name of the timestamp file giving the time range.
+	 * @param FrameRate [in] Frame rate of the generated timestamps (default=30.0).
+	 */
 	ConstantFpsTimestampFromFile( const std::string& FileName, float FrameRate = 30.0f )
 			: ReadTimestamp( FileName )
 	{
+		HighResTimestamp FirstTimestamp, LastTimestamp;
+
 		FirstTimeStamp = true;
-		if ( FrameRate <= 0.0f || ReadTimestamp::GetNextTimestamp() == false )
+		FrameNumber = 0;
+		if ( FrameRate <= 0.0f || GetTimeRange( FirstTimestamp, LastTimestamp ) == false )
 		{
 			InitTime.time = InitTime.millitm = 0;
 			TimeStep = 1;
 			EndTime.time = EndTime.millitm = 0;
+			FrameDurationInNs = 0;
+			HighResInitTime = HighResEndTime = HighResTimestamp();
 		}
 		else
 		{
-			InitTime = CurrentTimestamp;
+			HighResInitTime = FirstTimestamp;
+			HighResEndTime = LastTimestamp;
+			InitTime = HighResInitTime.ToTimeB();
+			EndTime = HighResEndTime.ToTimeB();
 			TimeStep = (int)((1.0f/FrameRate)*1000.0f);
-			// go to get last frame time
-			while( ReadTimestamp::GetNextTimestamp() == true )
-			{
-				EndTime = CurrentTimestamp;
-			}
+			FrameDurationInNs = (int64_t)(1.0e9/(double)FrameRate);
 		}
 	}
 
+	/** @brief Get the next timestamp at the requested frame rate.
+	 *
+	 * @return True is the next timestamp is in the time range of the file.
+	 */
 	bool GetNextTimestamp()
 	{
+		if ( FrameDurationInNs <= 0 )
+		{
+			// No time range
+			return false;
+		}
+
 		if ( FirstTimeStamp == true )
 		{
 			FirstTimeStamp = false;
-			CurrentTimestamp = InitTime;
-			return true;
+			FrameNumber = 0;
+		}
+		else
+		{
+			FrameNumber++;
 		}
 
-		TimeB TimeTmp = CurrentTimestamp;
-
-		TimeTmp += (int)TimeStep;
-		if ( CompareTime(TimeTmp, EndTime) > 0 )
+		// Compute from the first timestamp, no drift
+		HighResTimestamp TimeTmp = HighResInitTime + FrameNumber*FrameDurationInNs;
+		if ( TimeTmp > HighResEndTime )
 		{
 			// ok, out of scope
+			FrameNumber--;
 			return false;
 		}
 
-		CurrentTimestamp = TimeTmp;
+		CurrentHighResTimestamp = TimeTmp;
+		CurrentTimestamp = TimeTmp.ToTimeB();
+		CurrentTimestampIsInitialized = true;
 		return true;
 	}
 
 protected:
-	TimeB InitTime;
-	int TimeStep;
-	TimeB EndTime;
+	TimeB InitTime;						/*!< @brief First timestamp of the file. */
+	int TimeStep;						/*!< @brief Time between 2 timestamps in ms (rounded, information only). */
+	TimeB EndTime;						/*!< @brief Last timestamp of the file. */
+
+	HighResTimestamp HighResInitTime;	/*!< @brief First timestamp of the file (full precision). */
+	HighResTimestamp HighResEndTime;	/*!< @brief Last timestamp of the file (full precision). */
+	int64_t FrameDurationInNs;			/*!< @brief Time between 2 timestamps in ns, 0 if there is no time range. */
+	int64_t FrameNumber;				/*!< @brief Number of the current generated timestamp. */
 
-	bool FirstTimeStamp;
+	bool FirstTimeStamp;				/*!< @brief No timestamp was generated yet. */
 };
 
 } // namespace MobileRGBD
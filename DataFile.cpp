@@ -12,6 +12,14 @@
 
 #include <algorithm>
 
+#include <vector>
+
+#if !defined WIN32 && !defined WIN64
+	#include <unistd.h>
+	#include <limits.h>
+	#include <sys/uio.h>
+#endif
+
 using namespace MobileRGBD;
 
 // static
@@ -243,6 +251,33 @@ bool DataFile::Open( const char *Filename, int eMode /* = READ_MODE */ )
 	return InternalOpenCompressedVersion( Filename, eMode );
 }
 
+/** @brief Open directly the 7zip version of a file (its name followed by '.7z'), in read mode,
+	*         without trying the usual file first (the file is known to be compressed).
+	*
+	* @param Filename [in] The file name (without '.7z').
+	* @param eMode [in] The opening mode (only READ_MODE).
+	* @return true if the 7z version is opened.
+	*/
+bool DataFile::OpenCompressedVersion( const char *Filename, int eMode /* = READ_MODE */ )
+{
+	// prior checks
+	if ( InternalFile != nullptr )
+	{
+		fprintf( stderr, "Could not reopen file, please call DataFile::Close() before.\n" );
+		return false;
+	}
+
+	if ( Filename == nullptr )
+	{
+		fprintf( stderr, "File name is null.\n" );
+		return false;
+	}
+
+	IsPipe = false;
+
+	return InternalOpenCompressedVersion( Filename, eMode );
+}
+
 /** @brief Read bytes from a the file (or pipe). Identical to fread.
 	*
 	* @param ptr [in,out] Pointer to buffer.
@@ -264,6 +299,176 @@ size_t DataFile::Read( void *ptr, size_t size, size_t nmemb )
 	return RetCode;
 }
 
+/** @brief Read bytes at a given position of the file in one call. Identical to pread for usual files:
+	*         the current position is not changed. For pipes, seek (forward only) then read.
+	*
+	* @param ptr [in,out] Pointer to buffer.
+	* @param size [in] Number of bytes to read.
+	* @param Position [in] Position of the first byte to read.
+	* @return Number of bytes read.
+	*/
+size_t DataFile::ReadAt( void *ptr, size_t size, int64_t Position )
+{
+	if ( InternalFile == nullptr )
+	{
+		return (size_t)0;
+	}
+
+#if !defined WIN32 && !defined WIN64
+	if ( IsPipe == false )
+	{
+		// Read only, the stdio buffer stays consistent with the file
+		size_t NbRead = 0;
+		while( NbRead < size )
+		{
+			ssize_t RetCode = pread( fileno(InternalFile), (char*)ptr + NbRead, size - NbRead, (off_t)(Position + (int64_t)NbRead) );
+			if ( RetCode <= 0 )
+			{
+				break;
+			}
+			NbRead += (size_t)RetCode;
+		}
+		return NbRead;
+	}
+#else
+	if ( IsPipe == false )
+	{
+		// No pread, restore current position after reading
+		int64_t CurrentPosition = Tell();
+		size_t NbRead = 0;
+		if ( Seek( Position, SEEK_SET ) == 0 )
+		{
+			NbRead = Read( ptr, 1, size );
+		}
+		Seek( CurrentPosition, SEEK_SET );
+		return NbRead;
+	}
+#endif
+
+	// Pipe, current position moves after the data
+	if ( Seek( Position, SEEK_SET ) != 0 )
+	{
+		return (size_t)0;
+	}
+	return Read( ptr, 1, size );
+}
+
+/** @brief Read segments of the file separated by a constant stride (rows of a region of a frame) packed
+	*         in a buffer. For usual files, segments are read with vectored positional reads (preadv), the
+	*         current position is not changed. For pipes, seek (forward only) and read each segment.
+	*
+	* @param ptr [in,out] Pointer to buffer of SegmentSize*NumberOfSegments bytes.
+	* @param SegmentSize [in] Size of each segment.
+	* @param NumberOfSegments [in] Number of segments.
+	* @param Position [in] Position of the first segment.
+	* @param Stride [in] Distance between the beginnings of 2 segments in the file (at least SegmentSize).
+	* @return Number of bytes read in ptr.
+	*/
+size_t DataFile::ReadSegmentsAt( void *ptr, size_t SegmentSize, size_t NumberOfSegments, int64_t Position, int64_t Stride )
+{
+	if ( InternalFile == nullptr || Stride < (int64_t)SegmentSize )
+	{
+		return (size_t)0;
+	}
+
+	if ( Stride == (int64_t)SegmentSize || NumberOfSegments <= 1 )
+	{
+		// Contiguous segments
+		return ReadAt( ptr, SegmentSize*NumberOfSegments, Position );
+	}
+
+	size_t NbRead = 0;
+
+#if !defined WIN32 && !defined WIN64
+	if ( IsPipe == false )
+	{
+		// Bytes between segments are in the same pages, read them in a scratch buffer instead of
+		// issuing one call per segment. Each call reads whole segments.
+		size_t GapSize = (size_t)Stride - SegmentSize;
+		std::vector<char> Gap( GapSize );
+		size_t SegmentsPerCall = (size_t)(IOV_MAX+1)/2;
+		std::vector<struct iovec> Vectors;
+		Vectors.reserve( 2*SegmentsPerCall );
+
+		for( size_t First = 0; First < NumberOfSegments; First += SegmentsPerCall )
+		{
+			size_t Count = std::min( SegmentsPerCall, NumberOfSegments - First );
+			size_t Expected = Count*SegmentSize + (Count-1)*GapSize;
+
+			Vectors.clear();
+			for( size_t i = 0; i < Count; i++ )
+			{
+				if ( i > 0 )
+				{
+					struct iovec GapVector = { &Gap[0], GapSize };
+					Vectors.push_back( GapVector );
+				}
+				struct iovec SegmentVector = { (char*)ptr + (First+i)*SegmentSize, SegmentSize };
+				Vectors.push_back( SegmentVector );
+			}
+
+			ssize_t RetCode = preadv( fileno(InternalFile), &Vectors[0], (int)Vectors.size(), (off_t)(Position + (int64_t)First*Stride) );
+			if ( RetCode == (ssize_t)Expected )
+			{
+				NbRead += Count*SegmentSize;
+				continue;
+			}
+
+			// Short read (end of file, signal), finish segment by segment
+			for( size_t i = 0; i < Count; i++ )
+			{
+				size_t SegmentRead = ReadAt( (char*)ptr + (First+i)*SegmentSize, SegmentSize, Position + (int64_t)(First+i)*Stride );
+				NbRead += SegmentRead;
+				if ( SegmentRead != SegmentSize )
+				{
+					return NbRead;
+				}
+			}
+		}
+
+		return NbRead;
+	}
+#endif
+
+	// Pipes (forward seeks) or no preadv, one read per segment
+	for( size_t i = 0; i < NumberOfSegments; i++ )
+	{
+		size_t SegmentRead = ReadAt( (char*)ptr + i*SegmentSize, SegmentSize, Position + (int64_t)i*Stride );
+		NbRead += SegmentRead;
+		if ( SegmentRead != SegmentSize )
+		{
+			break;
+		}
+	}
+
+	return NbRead;
+}
+
+/** @brief Read a line from the file (or pipe). Identical to fgets but keep track of the
+	*         position in the file, even for pipes.
+	*
+	* @param Buffer [in,out] Pointer to buffer.
+	* @param BufferSize [in] Size of the buffer.
+	* @return Buffer or nullptr if nothing could be read (same as fgets).
+	*/
+char * DataFile::ReadLine( char * Buffer, int BufferSize )
+{
+	if ( InternalFile == nullptr )
+	{
+		return nullptr;
+	}
+
+	if ( fgets( Buffer, BufferSize, InternalFile ) == nullptr )
+	{
+		return nullptr;
+	}
+
+	// Compute new pos value
+	Pos += (int64_t)strlen( Buffer );
+
+	return Buffer;
+}
+
 /** @brief Write bytes to a the file (or pipe). Identical to fwrite.
 	*
 	* @param ptr [in] Pointer to buffer.
@@ -281,7 +486,21 @@ size_t DataFile::Write(const void *ptr, size_t size, size_t nmemb )
 		Pos += (int64_t)size*(int64_t)RetCode;
 	}
 
-	return (size_t)0;
+	return RetCode;
+}
+
+/** @brief Write buffered data to the file (or pipe). Identical to fflush.
+	*
+	* @return error code, same as fflush.
+	*/
+int DataFile::Flush()
+{
+	if ( InternalFile == nullptr )
+	{
+		return EOF;
+	}
+
+	return fflush( InternalFile );
 }
 
 /** @brief Close file (or pipe). Identical to fclose/pclose.
@@ -384,7 +603,13 @@ int64_t DataFile::Tell()
 		return -1;
 	}
 
-	// Return current pos file
+	// Usual file, ask the system (position may have changed using Seek)
+	if ( IsPipe == false )
+	{
+		return (int64_t)ftello( InternalFile );
+	}
+
+	// Return current pos in pipe
 	return Pos;
 }
 
@@ -48,6 +48,15 @@ public:
 	 */
 	bool Open( const char * Filename, int eMode = READ_MODE );
 
+	/** @brief Open directly the 7zip version of a file (its name followed by '.7z'), in read mode,
+	 *         without trying the usual file first (the file is known to be compressed).
+	 *
+	 * @param Filename [in] The file name (without '.7z').
+	 * @param eMode [in] The opening mode (only READ_MODE).
+	 * @return true if the 7z version is opened.
+	 */
+	bool OpenCompressedVersion( const char * Filename, int eMode = READ_MODE );
+
 	/** @brief Read bytes from a the file (or pipe). Identical to fread.
 	 *
 	 * @param ptr [in,out] Pointer to buffer.
@@ -57,6 +66,38 @@ public:
 	 */
 	size_t Read( void *ptr, size_t size, size_t nmemb );
 
+	/** @brief Read bytes at a given position of the file in one call. Identical to pread for usual files:
+	 *         the current position is not changed. For pipes, seek (forward only) then read.
+	 *
+	 * @param ptr [in,out] Pointer to buffer.
+	 * @param size [in] Number of bytes to read.
+	 * @param Position [in] Position of the first byte to read.
+	 * @return Number of bytes read.
+	 */
+	size_t ReadAt( void *ptr, size_t size, int64_t Position );
+
+	/** @brief Read segments of the file separated by a constant stride (rows of a region of a frame) packed
+	 *         in a buffer. For usual files, segments are read with vectored positional reads (preadv), the
+	 *         current position is not changed. For pipes, seek (forward only) and read each segment.
+	 *
+	 * @param ptr [in,out] Pointer to buffer of SegmentSize*NumberOfSegments bytes.
+	 * @param SegmentSize [in] Size of each segment.
+	 * @param NumberOfSegments [in] Number of segments.
+	 * @param Position [in] Position of the first segment.
+	 * @param Stride [in] Distance between the beginnings of 2 segments in the file (at least SegmentSize).
+	 * @return Number of bytes read in ptr.
+	 */
+	size_t ReadSegmentsAt( void *ptr, size_t SegmentSize, size_t NumberOfSegments, int64_t Position, int64_t Stride );
+
+	/** @brief Read a line from the file (or pipe). Identical to fgets but keep track of the
+	 *         position in the file, even for pipes.
+	 *
+	 * @param Buffer [in,out] Pointer to buffer.
+	 * @param BufferSize [in] Size of the buffer.
+	 * @return Buffer or nullptr if nothing could be read (same as fgets).
+	 */
+	char * ReadLine( char * Buffer, int BufferSize );
+
 	/** @brief Write bytes to a the file (or pipe). Identical to fwrite.
 	 *
 	 * @param ptr [in] Pointer to buffer.
@@ -66,6 +107,12 @@ public:
 	 */
 	size_t Write(const void *ptr, size_t size, size_t nmemb );
 
+	/** @brief Write buffered data to the file (or pipe). Identical to fflush.
+	 *
+	 * @return error code, same as fflush.
+	 */
+	int Flush();
+
 	/** @brief Close file (or pipe). Identical to fclose/pclose.
 	 *
 	 */
@@ -108,6 +155,11 @@ public:
 	 */
 	bool IsOpen() { return (InternalFile != nullptr); }
 
+	/** @brief Return true if data are read from a pipe (i.e. from a compressed version of the file).
+	 * @return True is data come from a pipe.
+	 */
+	bool IsPipeOpened() { return (InternalFile != nullptr && IsPipe == true); }
+
 	/** @brief Check if a file exists
 	 *
 	 * @param FileName [in] File name.
@@ -0,0 +1,9 @@
+/**
+ * @file DataSchema.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+// Only for Makefile
+#include "DataSchema.h"
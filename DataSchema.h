@@ -0,0 +1,392 @@
+/**
+ * @file DataSchema.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DATA_SCHEMA_H__
+#define __DATA_SCHEMA_H__
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include <tuple>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include "ReadTimestampFile.h"
+
+namespace MobileRGBD {
+
+/** @brief Parse a number at Cursor and move Cursor after it. No allocation, no locale, no errno.
+ *		   Real values are not correctly rounded at the last bit, which is far enough for sensor data.
+ *
+ * @param Cursor [in,out] Current position in the data.
+ * @param Value [out] The parsed value.
+ * @return True if a number was found.
+ */
+template<typename NumberType>
+inline bool ParseNumber( const char *&Cursor, NumberType &Value )
+{
+	const char * Current = Cursor;
+	bool Negative = false;
+
+	if ( *Current == '-' || *Current == '+' )
+	{
+		Negative = (*Current == '-');
+		Current++;
+	}
+
+	// Integer part
+	uint64_t IntegerPart = 0;
+	const char * StartOfDigits = Current;
+	while( *Current >= '0' && *Current <= '9' )
+	{
+		IntegerPart = IntegerPart*10 + (uint64_t)(*Current - '0');
+		Current++;
+	}
+	bool HasDigits = (Current != StartOfDigits);
+
+	if ( std::is_floating_point<NumberType>::value == false )
+	{
+		if ( HasDigits == false )
+		{
+			return false;
+		}
+		Value = (NumberType)(Negative ? -(int64_t)IntegerPart : (int64_t)IntegerPart);
+		Cursor = Current;
+		return true;
+	}
+
+	// Fraction part
+	static const double NegativePowersOf10[] = { 1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9,
+		1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18 };
+	double Result = (double)IntegerPart;
+	if ( *Current == '.' )
+	{
+		uint64_t FractionPart = 0;
+		int NumberOfDigits = 0;
+
+		Current++;
+		while( *Current >= '0' && *Current <= '9' )
+		{
+			// Digits beyond double precision are ignored
+			if ( NumberOfDigits < 18 )
+			{
+				FractionPart = FractionPart*10 + (uint64_t)(*Current - '0');
+				NumberOfDigits++;
+			}
+			HasDigits = true;
+			Current++;
+		}
+		Result += (double)FractionPart*NegativePowersOf10[NumberOfDigits];
+	}
+
+	if ( HasDigits == false )
+	{
+		return false;
+	}
+
+	// Exponent, if any
+	if ( *Current == 'e' || *Current == 'E' )
+	{
+		const char * Exponent = Current+1;
+		int ExponentValue;
+
+		if ( ParseNumber( Exponent, ExponentValue ) == true )
+		{
+			Current = Exponent;
+			for( ; ExponentValue > 0; ExponentValue-- ) { Result *= 10.0; }
+			for( ; ExponentValue < 0; ExponentValue++ ) { Result /= 10.0; }
+		}
+	}
+
+	Value = (NumberType)(Negative ? -Result : Result);
+	Cursor = Current;
+	return true;
+}
+
+/** @brief Skip separators (spaces, tabs, commas, semicolons) and an optional field name ("x=", "o:")
+ *		   in front of a value.
+ *
+ * @param Cursor [in,out] Current position in the data.
+ */
+inline void SkipToFieldValue( const char *&Cursor )
+{
+	while( *Cursor == ' ' || *Cursor == '\t' || *Cursor == ',' || *Cursor == ';' )
+	{
+		Cursor++;
+	}
+
+	// Optional name
+	const char * Current = Cursor;
+	while( (*Current >= 'a' && *Current <= 'z') || (*Current >= 'A' && *Current <= 'Z') || *Current == '_' ||
+		   (Current != Cursor && *Current >= '0' && *Current <= '9') )
+	{
+		Current++;
+	}
+	if ( Current != Cursor && (*Current == '=' || *Current == ':') )
+	{
+		Cursor = Current+1;
+	}
+}
+
+/**
+ * @struct SchemaField DataSchema.h
+ * @brief Compile-time description of one field of a schema: the member of the struct receiving the value.
+ *		  Use the DATA_SCHEMA_FIELD macro to declare it.
+ */
+template<typename Struct, typename FieldType, FieldType Struct::*Member>
+struct SchemaField
+{
+	typedef FieldType Type;		/*!< @brief Type of the field. */
+
+	/** @brief Parse the field at Cursor in the Out structure.
+	 */
+	static bool Parse( const char *&Cursor, Struct &Out )
+	{
+		SkipToFieldValue( Cursor );
+		return ParseNumber( Cursor, Out.*Member );
+	}
+
+	/** @brief Retrieve value of the field from a structure.
+	 */
+	static const FieldType& Get( const Struct &In ) { return In.*Member; }
+};
+
+/** @brief Declare a field of a schema from a structure and one of its members. */
+#define DATA_SCHEMA_FIELD( Struct, Member ) MobileRGBD::SchemaField<Struct, decltype(Struct::Member), &Struct::Member>
+
+/**
+ * @class DataSchema DataSchema.h
+ * @brief Compile-time schema of the data part of the lines of a timestamp file. The schema is declared
+ *		  once per stream type, the parser is generated at compile time, fields are parsed in order
+ *		  with no allocation. Field names in the file ("x=") are skipped. Example for the robot localisation
+ *		  file of ReadTimestampFile:
+ *		  @code
+		  struct RobotPose { float x; float y; float o; int Odometry; };
+		  typedef DataSchema<RobotPose, DATA_SCHEMA_FIELD(RobotPose, x), DATA_SCHEMA_FIELD(RobotPose, y),
+							 DATA_SCHEMA_FIELD(RobotPose, o), DATA_SCHEMA_FIELD(RobotPose, Odometry)> RobotPoseSchema;
+
+		  RobotPose Pose;
+		  if ( PoseFile.GetDataForTimestamp( Timestamp ) && RobotPoseSchema::Parse( PoseFile.DataBuffer, Pose ) ) { ... }
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<typename Struct, typename... Fields>
+class DataSchema
+{
+public:
+	typedef Struct StructType;		/*!< @brief Type of the structure filled by the schema. */
+	static constexpr size_t NumberOfFields = sizeof...(Fields);		/*!< @brief Number of fields in the schema. */
+
+	/**
+	 * @class DataSchema::Columns DataSchema.h
+	 * @brief Struct of arrays for bulk decoding: one vector of timestamps and one vector per field.
+	 */
+	class Columns
+	{
+	public:
+		/** @brief Reserve space for NumberOfLines lines in all columns.
+		 */
+		void Reserve( size_t NumberOfLines )
+		{
+			Timestamps.reserve( NumberOfLines );
+			ReserveFields<0>( NumberOfLines );
+		}
+
+		/** @brief Empty all columns.
+		 */
+		void Clear()
+		{
+			Timestamps.clear();
+			ClearFields<0>();
+		}
+
+		/** @brief Number of decoded lines.
+		 */
+		size_t Size() const { return Timestamps.size(); }
+
+		/** @brief Add a decoded line.
+		 */
+		void PushBack( const HighResTimestamp &Timestamp, const Struct &Values )
+		{
+			Timestamps.push_back( Timestamp );
+			PushBackFields<0>( Values );
+		}
+
+		/** @brief Access to the column of the field number FieldNumber (in schema order).
+		 */
+		template<size_t FieldNumber>
+		std::vector<typename std::tuple_element<FieldNumber, std::tuple<Fields...> >::type::Type>& Column()
+		{
+			return std::get<FieldNumber>( Data );
+		}
+
+		std::vector<HighResTimestamp> Timestamps;	/*!< @brief Timestamp of each line. */
+
+	protected:
+		std::tuple< std::vector<typename Fields::Type>... > Data;	/*!< @brief One vector per field. */
+
+		template<size_t Field> typename std::enable_if<(Field == sizeof...(Fields))>::type ReserveFields( size_t ) {}
+		template<size_t Field> typename std::enable_if<(Field < sizeof...(Fields))>::type ReserveFields( size_t NumberOfLines )
+		{
+			std::get<Field>( Data ).reserve( NumberOfLines );
+			ReserveFields<Field+1>( NumberOfLines );
+		}
+
+		template<size_t Field> typename std::enable_if<(Field == sizeof...(Fields))>::type ClearFields() {}
+		template<size_t Field> typename std::enable_if<(Field < sizeof...(Fields))>::type ClearFields()
+		{
+			std::get<Field>( Data ).clear();
+			ClearFields<Field+1>();
+		}
+
+		template<size_t Field> typename std::enable_if<(Field == sizeof...(Fields))>::type PushBackFields( const Struct & ) {}
+		template<size_t Field> typename std::enable_if<(Field < sizeof...(Fields))>::type PushBackFields( const Struct &Values )
+		{
+			typedef typename std::tuple_element<Field, std::tuple<Fields...> >::type CurrentField;
+			std::get<Field>( Data ).push_back( CurrentField::Get( Values ) );
+			PushBackFields<Field+1>( Values );
+		}
+	};
+
+	/** @brief Parse the data part of a line (for instance ReadTimestampFile::DataBuffer).
+	 *
+	 * @param Data [in] Pointer to the data.
+	 * @param Out [out] Structure to fill.
+	 * @param EndOfData [out] If not null, position after the last parsed field (default=nullptr).
+	 * @return True if all fields have been parsed.
+	 */
+	static bool Parse( const char * Data, Struct &Out, const char ** EndOfData = nullptr )
+	{
+		if ( Data == nullptr )
+		{
+			return false;
+		}
+
+		const char * Cursor = Data;
+		bool Result = ParseFields<Fields...>( Cursor, Out );
+
+		if ( EndOfData != nullptr )
+		{
+			*EndOfData = Cursor;
+		}
+		return Result;
+	}
+
+	/** @brief Bulk decode a buffer containing many lines (timestamp + data). Lines without
+	 *		   timestamp or with incomplete data are ignored. The buffer may end without an end of line.
+	 *
+	 * @param Begin [in] First character of the buffer.
+	 * @param End [in] Position after the last character of the buffer.
+	 * @param Out [in,out] Columns to fill (decoded lines are added).
+	 * @return Number of decoded lines.
+	 */
+	static size_t DecodeLines( const char * Begin, const char * End, Columns &Out )
+	{
+		size_t NumberOfLines = 0;
+		const char * Line = Begin;
+
+		while( Line < End )
+		{
+			HighResTimestamp Timestamp;
+			int EndOfTimestampPosition;
+			Struct Values;
+
+			const char * EndOfLine = Line;
+			while( EndOfLine < End && *EndOfLine != '\n' )
+			{
+				EndOfLine++;
+			}
+
+			// Parsers stop on the first unexpected character, '\n' included. A last line without
+			// end of line is parsed from a terminated copy, parsers never read after End
+			const char * LineToParse = Line;
+			std::string LastLine;
+			if ( EndOfLine == End )
+			{
+				LastLine.assign( Line, EndOfLine );
+				LineToParse = LastLine.c_str();
+			}
+
+			if ( HighResTimestamp::Parse( LineToParse, Timestamp, EndOfTimestampPosition ) == true &&
+				 Parse( LineToParse + EndOfTimestampPosition, Values ) == true )
+			{
+				Out.PushBack( Timestamp, Values );
+				NumberOfLines++;
+			}
+
+			Line = EndOfLine+1;
+		}
+
+		return NumberOfLines;
+	}
+
+	/** @brief Bulk decode all remaining lines of a timestamp file.
+	 *
+	 * @param File [in] The timestamp file, read from its current position to its end.
+	 * @param Out [in,out] Columns to fill (decoded lines are added).
+	 * @return Number of decoded lines.
+	 */
+	static size_t DecodeFile( ReadTimestampFile &File, Columns &Out )
+	{
+		size_t NumberOfLines = 0;
+
+		// Lines are read through the index, GetNextTimestamp keeps the last line at the end of the file
+		if ( File.BuildIndex() == false )
+		{
+			return 0;
+		}
+
+		// First line after the current one (the current entry may not be known yet)
+		if ( File.CurrentTimestampIsInitialized == true && File.CurrentIndexEntry < 0 )
+		{
+			File.UpdateCurrentIndexEntry();
+		}
+		size_t FirstEntry = File.CurrentTimestampIsInitialized == true && File.CurrentIndexEntry >= 0 ? (size_t)File.CurrentIndexEntry+1 : 0;
+
+		if ( FirstEntry < File.Index.Size() )
+		{
+			Out.Reserve( Out.Size() + File.Index.Size() - FirstEntry );
+		}
+
+		for( size_t Entry = FirstEntry; Entry < File.Index.Size(); Entry++ )
+		{
+			Struct Values;
+
+			if ( File.GoToIndexEntry( (int)Entry ) == false )
+			{
+				break;
+			}
+
+			if ( Parse( &File.LineBuffer[File.EndOfTimestampPosition], Values ) == true )
+			{
+				Out.PushBack( File.CurrentHighResTimestamp, Values );
+				NumberOfLines++;
+			}
+		}
+
+		return NumberOfLines;
+	}
+
+protected:
+	template<typename... NoField>
+	static typename std::enable_if<(sizeof...(NoField) == 0), bool>::type ParseFields( const char *&, Struct & )
+	{
+		return true;
+	}
+
+	template<typename FirstField, typename... OtherFields>
+	static bool ParseFields( const char *&Cursor, Struct &Out )
+	{
+		return FirstField::Parse( Cursor, Out ) && ParseFields<OtherFields...>( Cursor, Out );
+	}
+};
+
+} // namespace MobileRGBD
+
+#endif // __DATA_SCHEMA_H__
@@ -0,0 +1,176 @@
+/**
+ * @file FileWatcher.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "FileWatcher.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <thread>
+
+#if defined __linux__
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace MobileRGBD;
+
+const unsigned int FileWatcher::PollingPeriodInMs = 5;	/*!< @brief Period to check the file when inotify is not available (5 ms). */
+
+/** @brief Constructor. No file is watched.
+ */
+FileWatcher::FileWatcher()
+{
+	InotifyDescriptor = -1;
+	LastSize = -1;
+	LastModificationTime = -1;
+}
+
+/** @brief Virtual destructor, always. Stop watching.
+ */
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+/** @brief Start watching a file. The file may not exist yet.
+ *
+ * @param FileName [in] Name of the file.
+ * @return True if the file is watched.
+ */
+bool FileWatcher::Watch( const string& FileName )
+{
+	Stop();
+
+	WatchedFile = FileName;
+	CheckSignature();
+
+#if defined __linux__
+	InotifyDescriptor = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if ( InotifyDescriptor != -1 && inotify_add_watch( InotifyDescriptor, FileName.c_str(), IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE ) == -1 )
+	{
+		// File does not exist yet (or no more inotify watch available), poll it
+		close( InotifyDescriptor );
+		InotifyDescriptor = -1;
+	}
+#endif
+
+	return true;
+}
+
+/** @brief Stop watching.
+ */
+void FileWatcher::Stop()
+{
+#if defined __linux__
+	if ( InotifyDescriptor != -1 )
+	{
+		close( InotifyDescriptor );
+	}
+#endif
+	InotifyDescriptor = -1;
+	WatchedFile.clear();
+	LastSize = -1;
+	LastModificationTime = -1;
+}
+
+/** @brief Wait for a modification of the file. Modifications done since the previous
+ *		   call (or since Watch) are not lost. Spurious returns may happen.
+ *
+ * @param Deadline [in] Do not wait after this time.
+ * @return False if the file was not modified before the deadline.
+ */
+bool FileWatcher::WaitForChange( const chrono::steady_clock::time_point& Deadline )
+{
+	if ( IsWatching() == false )
+	{
+		return false;
+	}
+
+#if defined __linux__
+	if ( InotifyDescriptor != -1 )
+	{
+		chrono::steady_clock::duration Remaining = Deadline - chrono::steady_clock::now();
+		int TimeoutInMs = (int)chrono::duration_cast<chrono::milliseconds>( Remaining + chrono::microseconds(999) ).count();
+
+		struct pollfd Event;
+		Event.fd = InotifyDescriptor;
+		Event.events = POLLIN;
+		Event.revents = 0;
+
+		if ( poll( &Event, 1, TimeoutInMs > 0 ? TimeoutInMs : 0 ) <= 0 )
+		{
+			return false;
+		}
+
+		// Drop pending events, we only want to know that something happened
+		char Events[4096];
+		while( read( InotifyDescriptor, Events, sizeof(Events) ) > 0 );
+
+		return true;
+	}
+#endif
+
+	// Polling mode
+	for(;;)
+	{
+		if ( CheckSignature() == true )
+		{
+			return true;
+		}
+
+		chrono::steady_clock::time_point Now = chrono::steady_clock::now();
+		if ( Now >= Deadline )
+		{
+			return false;
+		}
+
+		chrono::steady_clock::duration Period = chrono::milliseconds(PollingPeriodInMs);
+		this_thread::sleep_for( Deadline - Now < Period ? Deadline - Now : Period );
+	}
+}
+
+/** @brief Get size of a usual file.
+ *
+ * @param FileName [in] Name of the file.
+ * @return The size of the file or -1 if it does not exist.
+ */
+int64_t FileWatcher::GetFileSize( const string& FileName )
+{
+	struct stat FileStat;
+
+	if ( stat( FileName.c_str(), &FileStat ) != 0 )
+	{
+		return -1;
+	}
+
+	return (int64_t)FileStat.st_size;
+}
+
+/** @brief Check if size or modification time of the file changed since the last call.
+ */
+bool FileWatcher::CheckSignature()
+{
+	struct stat FileStat;
+	int64_t Size = -1;
+	int64_t ModificationTime = -1;
+
+	if ( stat( WatchedFile.c_str(), &FileStat ) == 0 )
+	{
+		Size = (int64_t)FileStat.st_size;
+		ModificationTime = (int64_t)FileStat.st_mtime;
+	}
+
+	bool Changed = (Size != LastSize || ModificationTime != LastModificationTime);
+
+	LastSize = Size;
+	LastModificationTime = ModificationTime;
+
+	return Changed;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file FileWatcher.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __FILE_WATCHER_H__
+#define __FILE_WATCHER_H__
+
+#include <inttypes.h>
+
+#include <string>
+#include <chrono>
+
+namespace MobileRGBD {
+
+/**
+ * @class FileWatcher FileWatcher.cpp FileWatcher.h
+ * @brief Wait for modifications of a file being written by another process (i.e. a recorder).
+ *		  Use inotify under Linux, check size and modification time of the file periodically
+ *		  otherwise (or if inotify is not available).
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class FileWatcher
+{
+public:
+	static const unsigned int PollingPeriodInMs;	/*!< @brief Period to check the file when inotify is not available (5 ms). */
+
+	/** @brief Constructor. No file is watched.
+	 */
+	FileWatcher();
+
+	/** @brief Virtual destructor, always. Stop watching.
+	 */
+	virtual ~FileWatcher();
+
+	/** @brief Start watching a file. The file may not exist yet.
+	 *
+	 * @param FileName [in] Name of the file.
+	 * @return True if the file is watched.
+	 */
+	bool Watch( const std::string& FileName );
+
+	/** @brief Stop watching.
+	 */
+	void Stop();
+
+	/** @brief Return true if a file is watched.
+	 */
+	bool IsWatching() const { return (WatchedFile.empty() == false); }
+
+	/** @brief Wait for a modification of the file. Modifications done since the previous
+	 *		   call (or since Watch) are not lost. Spurious returns may happen.
+	 *
+	 * @param Deadline [in] Do not wait after this time.
+	 * @return False if the file was not modified before the deadline.
+	 */
+	bool WaitForChange( const std::chrono::steady_clock::time_point& Deadline );
+
+	/** @brief Wait for a modification of the file. See WaitForChange( Deadline ).
+	 *
+	 * @param TimeoutInMs [in] Maximum waiting time.
+	 * @return False if the file was not modified in time.
+	 */
+	bool WaitForChange( unsigned int TimeoutInMs )
+	{
+		return WaitForChange( std::chrono::steady_clock::now() + std::chrono::milliseconds(TimeoutInMs) );
+	}
+
+	/** @brief Get size of a usual file.
+	 *
+	 * @param FileName [in] Name of the file.
+	 * @return The size of the file or -1 if it does not exist.
+	 */
+	static int64_t GetFileSize( const std::string& FileName );
+
+protected:
+	/** @brief Check if size or modification time of the file changed since the last call.
+	 */
+	bool CheckSignature();
+
+	std::string WatchedFile;		/*!< @brief Name of the watched file, empty if none. */
+	int InotifyDescriptor;			/*!< @brief inotify instance, -1 when polling. */
+	int64_t LastSize;				/*!< @brief Size of the file at the last check (polling). */
+	int64_t LastModificationTime;	/*!< @brief Modification time of the file at the last check (polling). */
+};
+
+} // namespace MobileRGBD
+
+#endif // __FILE_WATCHER_H__
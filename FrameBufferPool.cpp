@@ -0,0 +1,104 @@
+/**
+ * @file FrameBufferPool.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "FrameBufferPool.h"
+
+using namespace std;
+using namespace MobileRGBD;
+
+const size_t FrameBufferPool::DefaultMaxNumberOfFreeBuffers = 16;	/*!< @brief Default number of free buffers kept in a pool (16). */
+
+/** @brief Constructor.
+ *
+ * @param eMaxNumberOfFreeBuffers [in] Maximum number of free buffers kept, others are deleted (default=DefaultMaxNumberOfFreeBuffers).
+ */
+FrameBufferPool::FrameBufferPool( size_t eMaxNumberOfFreeBuffers /* = DefaultMaxNumberOfFreeBuffers */ )
+{
+	MaxNumberOfFreeBuffers = eMaxNumberOfFreeBuffers;
+	NumberOfAllocations = 0;
+}
+
+/** @brief Get a buffer from the pool (or a new one if none is free).
+ *
+ * @param Size [in] Size of the buffer.
+ * @return A buffer of Size bytes, back in the pool when released.
+ */
+shared_ptr< vector<unsigned char> > FrameBufferPool::Acquire( size_t Size )
+{
+	unique_ptr< vector<unsigned char> > Buffer;
+
+	{
+		lock_guard<mutex> Lock( Protect );
+
+		if ( FreeBuffers.empty() == false )
+		{
+			Buffer = std::move( FreeBuffers.back() );
+			FreeBuffers.pop_back();
+		}
+		else
+		{
+			NumberOfAllocations++;
+		}
+	}
+
+	if ( Buffer == nullptr )
+	{
+		Buffer.reset( new vector<unsigned char> );
+	}
+
+	// Reused buffers keep their capacity, no allocation for frames of the same size
+	Buffer->resize( Size );
+
+	// Released buffers go back to the pool, if it still exists
+	weak_ptr<FrameBufferPool> Pool = shared_from_this();
+	return shared_ptr< vector<unsigned char> >( Buffer.release(), [Pool]( vector<unsigned char> * ReleasedBuffer )
+	{
+		shared_ptr<FrameBufferPool> CurrentPool = Pool.lock();
+		if ( CurrentPool != nullptr )
+		{
+			CurrentPool->Release( ReleasedBuffer );
+		}
+		else
+		{
+			delete ReleasedBuffer;
+		}
+	} );
+}
+
+/** @brief Put back a buffer in the pool, or delete it if the pool is full.
+ *
+ * @param Buffer [in] The released buffer.
+ */
+void FrameBufferPool::Release( vector<unsigned char> * Buffer )
+{
+	unique_ptr< vector<unsigned char> > ReleasedBuffer( Buffer );
+
+	lock_guard<mutex> Lock( Protect );
+
+	if ( FreeBuffers.size() < MaxNumberOfFreeBuffers )
+	{
+		FreeBuffers.push_back( std::move( ReleasedBuffer ) );
+	}
+}
+
+/** @brief Number of free buffers in the pool.
+ */
+size_t FrameBufferPool::GetNumberOfFreeBuffers()
+{
+	lock_guard<mutex> Lock( Protect );
+
+	return FreeBuffers.size();
+}
+
+/** @brief Number of buffers allocated by the pool since its creation, i.e. not reused.
+ */
+uint64_t FrameBufferPool::GetNumberOfAllocations()
+{
+	lock_guard<mutex> Lock( Protect );
+
+	return NumberOfAllocations;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file FrameBufferPool.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __FRAME_BUFFER_POOL_H__
+#define __FRAME_BUFFER_POOL_H__
+
+#include <inttypes.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace MobileRGBD {
+
+/**
+ * @class FrameBufferPool FrameBufferPool.cpp FrameBufferPool.h
+ * @brief Pool of frame buffers shared between threads. A buffer returns to the pool when its last
+ *		  reference is released, later frames reuse it instead of allocating memory. The pool must be
+ *		  created with std::make_shared, buffers may outlive it. Example:
+ *		  @code
+		  std::shared_ptr<FrameBufferPool> Pool = std::make_shared<FrameBufferPool>();
+		  std::shared_ptr< std::vector<unsigned char> > Buffer = Pool->Acquire( FrameSize );
+		  ...
+		  Buffer.reset();	// Back in the pool
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class FrameBufferPool : public std::enable_shared_from_this<FrameBufferPool>
+{
+public:
+	static const size_t DefaultMaxNumberOfFreeBuffers;	/*!< @brief Default number of free buffers kept in a pool (16). */
+
+	/** @brief Constructor.
+	 *
+	 * @param eMaxNumberOfFreeBuffers [in] Maximum number of free buffers kept, others are deleted (default=DefaultMaxNumberOfFreeBuffers).
+	 */
+	FrameBufferPool( size_t eMaxNumberOfFreeBuffers = DefaultMaxNumberOfFreeBuffers );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~FrameBufferPool() {}
+
+	/** @brief Get a buffer from the pool (or a new one if none is free).
+	 *
+	 * @param Size [in] Size of the buffer.
+	 * @return A buffer of Size bytes, back in the pool when released.
+	 */
+	std::shared_ptr< std::vector<unsigned char> > Acquire( size_t Size );
+
+	/** @brief Number of free buffers in the pool.
+	 */
+	size_t GetNumberOfFreeBuffers();
+
+	/** @brief Number of buffers allocated by the pool since its creation, i.e. not reused.
+	 */
+	uint64_t GetNumberOfAllocations();
+
+protected:
+	/** @brief Put back a buffer in the pool, or delete it if the pool is full.
+	 *
+	 * @param Buffer [in] The released buffer.
+	 */
+	void Release( std::vector<unsigned char> * Buffer );
+
+	std::vector< std::unique_ptr< std::vector<unsigned char> > > FreeBuffers;	/*!< @brief Buffers ready to be reused. */
+	size_t MaxNumberOfFreeBuffers;												/*!< @brief Maximum number of buffers in FreeBuffers. */
+	uint64_t NumberOfAllocations;												/*!< @brief Number of buffers allocated. */
+	std::mutex Protect;															/*!< @brief Protect access from several threads. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __FRAME_BUFFER_POOL_H__
@@ -0,0 +1,187 @@
+/**
+ * @file FrameCache.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "FrameCache.h"
+
+using namespace std;
+using namespace MobileRGBD;
+
+const size_t FrameCache::DefaultBudgetInBytes = 256*1024*1024;	/*!< @brief Default budget of a cache (256 MiB). */
+
+/** @brief Constructor.
+ *
+ * @param BudgetInBytes [in] Maximum size of the cached frames (default=DefaultBudgetInBytes).
+ */
+FrameCache::FrameCache( size_t BudgetInBytes /* = DefaultBudgetInBytes */ )
+{
+	Budget = BudgetInBytes;
+	UsedSize = 0;
+	Hits = 0;
+	Misses = 0;
+}
+
+/** @brief Get an identifier for a raw file, the same for all readers of this file.
+ *
+ * @param FileName [in] Name of the raw file.
+ * @return Identifier of the file in this cache.
+ */
+unsigned int FrameCache::RegisterFile( const string& FileName )
+{
+	lock_guard<mutex> Lock( Protect );
+
+	map<string, unsigned int>::iterator It = Files.find( FileName );
+	if ( It != Files.end() )
+	{
+		return It->second;
+	}
+
+	unsigned int FileId = (unsigned int)Files.size();
+	Files[FileName] = FileId;
+
+	return FileId;
+}
+
+/** @brief Search for a frame in the cache. Count a hit or a miss.
+ *
+ * @param FileId [in] Identifier of the raw file (see RegisterFile).
+ * @param FrameIndex [in] Zero based index of the frame in the raw file.
+ * @return The frame or an empty pointer if the frame is not in the cache.
+ */
+shared_ptr<const CachedFrame> FrameCache::Find( unsigned int FileId, int FrameIndex )
+{
+	lock_guard<mutex> Lock( Protect );
+
+	unordered_map<uint64_t, Entry>::iterator It = Frames.find( Key(FileId, FrameIndex) );
+	if ( It == Frames.end() )
+	{
+		Misses++;
+		return shared_ptr<const CachedFrame>();
+	}
+
+	// Now the most recently used
+	UsageOrder.splice( UsageOrder.begin(), UsageOrder, It->second.Usage );
+	Hits++;
+
+	return It->second.Frame;
+}
+
+/** @brief Add a frame in the cache. Least recently used frames are removed to stay
+ *		   within the budget. Frames larger than the budget are not cached.
+ *
+ * @param FileId [in] Identifier of the raw file (see RegisterFile).
+ * @param FrameIndex [in] Zero based index of the frame in the raw file.
+ * @param Frame [in] The frame.
+ */
+void FrameCache::Insert( unsigned int FileId, int FrameIndex, const shared_ptr<const CachedFrame>& Frame )
+{
+	if ( Frame == nullptr )
+	{
+		return;
+	}
+
+	lock_guard<mutex> Lock( Protect );
+
+	size_t FrameSize = Frame->Data.size();
+	if ( FrameSize > Budget )
+	{
+		return;
+	}
+
+	uint64_t FrameKey = Key( FileId, FrameIndex );
+	unordered_map<uint64_t, Entry>::iterator It = Frames.find( FrameKey );
+	if ( It != Frames.end() )
+	{
+		// Replace previous version
+		UsedSize -= It->second.Frame->Data.size();
+		UsageOrder.erase( It->second.Usage );
+		Frames.erase( It );
+	}
+
+	Evict( Budget - FrameSize );
+
+	UsageOrder.push_front( FrameKey );
+	Entry& NewEntry = Frames[FrameKey];
+	NewEntry.Frame = Frame;
+	NewEntry.Usage = UsageOrder.begin();
+	UsedSize += FrameSize;
+}
+
+/** @brief Change the budget of the cache, removing frames if needed.
+ *
+ * @param BudgetInBytes [in] Maximum size of the cached frames.
+ */
+void FrameCache::SetBudget( size_t BudgetInBytes )
+{
+	lock_guard<mutex> Lock( Protect );
+
+	Budget = BudgetInBytes;
+	Evict( Budget );
+}
+
+/** @brief Budget of the cache in bytes.
+ */
+size_t FrameCache::GetBudget()
+{
+	lock_guard<mutex> Lock( Protect );
+	return Budget;
+}
+
+/** @brief Size of the cached frames in bytes.
+ */
+size_t FrameCache::GetUsedSize()
+{
+	lock_guard<mutex> Lock( Protect );
+	return UsedSize;
+}
+
+/** @brief Number of frames found in the cache since creation (or ResetCounters).
+ */
+uint64_t FrameCache::GetHits()
+{
+	lock_guard<mutex> Lock( Protect );
+	return Hits;
+}
+
+/** @brief Number of frames not found in the cache since creation (or ResetCounters).
+ */
+uint64_t FrameCache::GetMisses()
+{
+	lock_guard<mutex> Lock( Protect );
+	return Misses;
+}
+
+/** @brief Reset hit and miss counters.
+ */
+void FrameCache::ResetCounters()
+{
+	lock_guard<mutex> Lock( Protect );
+	Hits = 0;
+	Misses = 0;
+}
+
+/** @brief Remove all frames from the cache.
+ */
+void FrameCache::Clear()
+{
+	lock_guard<mutex> Lock( Protect );
+	Evict( 0 );
+}
+
+/** @brief Remove least recently used frames until the used size is within the budget. Protect must be locked.
+ *
+ * @param BudgetInBytes [in] Size to reach.
+ */
+void FrameCache::Evict( size_t BudgetInBytes )
+{
+	while( UsedSize > BudgetInBytes && UsageOrder.empty() == false )
+	{
+		unordered_map<uint64_t, Entry>::iterator It = Frames.find( UsageOrder.back() );
+		UsedSize -= It->second.Frame->Data.size();
+		Frames.erase( It );
+		UsageOrder.pop_back();
+	}
+}
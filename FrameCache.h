@@ -0,0 +1,150 @@
+/**
+ * @file FrameCache.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __FRAME_CACHE_H__
+#define __FRAME_CACHE_H__
+
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+namespace MobileRGBD {
+
+/**
+ * @struct CachedFrame FrameCache.h
+ * @brief A frame (or all subframes of a timestamp) stored in a FrameCache.
+ */
+struct CachedFrame
+{
+	int NumberOfSubFrames;				/*!< @brief Number of subframes in Data (1 in single frame mode). */
+	std::vector<unsigned char> Data;	/*!< @brief Content of the frame(s). */
+};
+
+/**
+ * @class FrameCache FrameCache.cpp FrameCache.h
+ * @brief Least recently used cache of frames read from raw files, keyed by file and frame index.
+ *		  The cache keeps at most BudgetInBytes bytes of frames. A cache can be shared by several
+ *		  readers (of the same or different raw files), even from different threads. Example:
+ *		  @code
+		  std::shared_ptr<FrameCache> Cache = std::make_shared<FrameCache>( 1024*1024*1024 );	// 1 GiB
+		  Depth.SetFrameCache( Cache );
+		  Color.SetFrameCache( Cache );
+		  ...
+		  printf( "%.1f %% hits\n", 100.0*Cache->GetHits()/(Cache->GetHits()+Cache->GetMisses()) );
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class FrameCache
+{
+public:
+	static const size_t DefaultBudgetInBytes;	/*!< @brief Default budget of a cache (256 MiB). */
+
+	/** @brief Constructor.
+	 *
+	 * @param BudgetInBytes [in] Maximum size of the cached frames (default=DefaultBudgetInBytes).
+	 */
+	FrameCache( size_t BudgetInBytes = DefaultBudgetInBytes );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~FrameCache() {}
+
+	/** @brief Get an identifier for a raw file, the same for all readers of this file.
+	 *
+	 * @param FileName [in] Name of the raw file.
+	 * @return Identifier of the file in this cache.
+	 */
+	unsigned int RegisterFile( const std::string& FileName );
+
+	/** @brief Search for a frame in the cache. Count a hit or a miss.
+	 *
+	 * @param FileId [in] Identifier of the raw file (see RegisterFile).
+	 * @param FrameIndex [in] Zero based index of the frame in the raw file.
+	 * @return The frame or an empty pointer if the frame is not in the cache.
+	 */
+	std::shared_ptr<const CachedFrame> Find( unsigned int FileId, int FrameIndex );
+
+	/** @brief Add a frame in the cache. Least recently used frames are removed to stay
+	 *		   within the budget. Frames larger than the budget are not cached.
+	 *
+	 * @param FileId [in] Identifier of the raw file (see RegisterFile).
+	 * @param FrameIndex [in] Zero based index of the frame in the raw file.
+	 * @param Frame [in] The frame.
+	 */
+	void Insert( unsigned int FileId, int FrameIndex, const std::shared_ptr<const CachedFrame>& Frame );
+
+	/** @brief Change the budget of the cache, removing frames if needed.
+	 *
+	 * @param BudgetInBytes [in] Maximum size of the cached frames.
+	 */
+	void SetBudget( size_t BudgetInBytes );
+
+	/** @brief Budget of the cache in bytes.
+	 */
+	size_t GetBudget();
+
+	/** @brief Size of the cached frames in bytes.
+	 */
+	size_t GetUsedSize();
+
+	/** @brief Number of frames found in the cache since creation (or ResetCounters).
+	 */
+	uint64_t GetHits();
+
+	/** @brief Number of frames not found in the cache since creation (or ResetCounters).
+	 */
+	uint64_t GetMisses();
+
+	/** @brief Reset hit and miss counters.
+	 */
+	void ResetCounters();
+
+	/** @brief Remove all frames from the cache.
+	 */
+	void Clear();
+
+protected:
+	/** @brief Remove least recently used frames until the used size is within the budget. Protect must be locked.
+	 *
+	 * @param BudgetInBytes [in] Size to reach.
+	 */
+	void Evict( size_t BudgetInBytes );
+
+	/** @brief Compute the key of a frame.
+	 */
+	static uint64_t Key( unsigned int FileId, int FrameIndex ) { return ((uint64_t)FileId << 32) | (uint64_t)(uint32_t)FrameIndex; }
+
+	/**
+	 * @struct FrameCache::Entry FrameCache.h
+	 * @brief A frame in the cache and its position in the LRU list.
+	 */
+	struct Entry
+	{
+		std::shared_ptr<const CachedFrame> Frame;		/*!< @brief The cached frame. */
+		std::list<uint64_t>::iterator Usage;			/*!< @brief Position of the key in UsageOrder. */
+	};
+
+	std::unordered_map<uint64_t, Entry> Frames;			/*!< @brief Cached frames by key. */
+	std::list<uint64_t> UsageOrder;						/*!< @brief Keys from the most to the least recently used. */
+	std::map<std::string, unsigned int> Files;			/*!< @brief Identifiers of registered raw files. */
+	size_t Budget;										/*!< @brief Maximum size of the cached frames. */
+	size_t UsedSize;									/*!< @brief Current size of the cached frames. */
+	uint64_t Hits;										/*!< @brief Number of frames found in the cache. */
+	uint64_t Misses;									/*!< @brief Number of frames not found in the cache. */
+	std::mutex Protect;									/*!< @brief Protect access from several threads. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __FRAME_CACHE_H__
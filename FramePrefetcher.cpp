@@ -0,0 +1,377 @@
+/**
+ * @file FramePrefetcher.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "FramePrefetcher.h"
+#include "TimestampIndex.h"
+
+using namespace std;
+using namespace MobileRGBD;
+
+/** @brief Constructor. Allocate the ring, the I/O thread is not started.
+ *
+ * @param eTimestampFileName [in] Name of the timestamp file.
+ * @param eRawFileName [in] Name of the raw file.
+ * @param SizeOfFrame [in] Size of each frame (or subframe) in the raw file.
+ * @param FirstFrame [in] Number of the first frame of the raw file.
+ * @param SubFrames [in] Lines contain a number of subframes after the frame number (see ReadTimestampRawFile::SubFramesMode).
+ * @param NumberOfSlots [in] Number of frames read in advance.
+ * @param SizeOfLineBuffer [in] Size of buffer to read each line of the timestamp file.
+ */
+FramePrefetcher::FramePrefetcher( const string& eTimestampFileName, const string& eRawFileName, int SizeOfFrame, int FirstFrame, bool SubFrames,
+	unsigned int NumberOfSlots, size_t SizeOfLineBuffer )
+	: LineBuffer( SizeOfLineBuffer )
+{
+	TimestampFileName = eTimestampFileName;
+	RawFileName = eRawFileName;
+	FrameSize = SizeOfFrame;
+	StartingFrame = FirstFrame;
+	SubFramesMode = SubFrames;
+	RawPosition = 0;
+	NextSubFrame = 0;
+	DecimationStep = 1;
+	DecimationPeriodInNs = 0;
+	SkippedLines = 0;
+
+	// Preallocate buffers for one frame, they may grow in subframes mode
+	Ring.resize( NumberOfSlots > 0 ? NumberOfSlots : 1 );
+	for( size_t i = 0; i < Ring.size(); i++ )
+	{
+		Ring[i].Index = -1;
+		Ring[i].NumberOfSubFrames = 0;
+		Ring[i].Ready = false;
+		Ring[i].Data.resize( (size_t)FrameSize );
+	}
+
+	First = 0;
+	Used = 0;
+	LastIndex = -1;
+	IndexSpacing = 1;
+	Held = false;
+	EndOfFile = true;
+	Stopping = false;
+}
+
+/** @brief Virtual destructor, always. Stop the I/O thread.
+ */
+FramePrefetcher::~FramePrefetcher()
+{
+	Stop();
+}
+
+/** @brief (Re)start prefetching from a line of the timestamp file. Frames loaded in advance are dropped.
+ *
+ * @param Position [in] Position of a line in the timestamp file.
+ * @param FirstSubFrame [in] In subframes mode, number of subframes in the raw file before the ones of this line (default=0).
+ * @param LinesToSkip [in] With a decimation step, number of frame lines to skip before the first prefetched one (default=0).
+ * @param NextTimestamp [in] With a decimation period, minimal timestamp of the first prefetched line (default=0).
+ */
+void FramePrefetcher::Start( int64_t Position, int64_t FirstSubFrame /* = 0 */, unsigned int LinesToSkip /* = 0 */,
+	const HighResTimestamp& NextTimestamp /* = HighResTimestamp() */ )
+{
+	Stop();
+
+	if ( fTimestamps.IsOpen() == false && fTimestamps.Open( TimestampFileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return;
+	}
+	if ( fRaw.IsOpen() == false && fRaw.Open( RawFileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return;
+	}
+
+	if ( fTimestamps.Seek( Position, SEEK_SET ) != 0 )
+	{
+		// We can not go backward in pipes, restart from the beginning
+		fTimestamps.Rewind();
+		if ( fTimestamps.Seek( Position, SEEK_SET ) != 0 )
+		{
+			return;
+		}
+	}
+	RawPosition = fRaw.Tell();
+	NextSubFrame = FirstSubFrame;
+	SkippedLines = LinesToSkip;
+	NextDecimationTimestamp = NextTimestamp;
+
+	// Until 2 frames are queued, expect one prefetched frame per decimation step
+	IndexSpacing = (int)DecimationStep;
+
+	EndOfFile = false;
+	IOThread = thread( &FramePrefetcher::Run, this );
+}
+
+/** @brief Only prefetch frames read by a decimated reader (see ReadTimestampRawFile::SetDecimation),
+ *		   taken into account by the next call to Start.
+ *
+ * @param Step [in] Prefetch one frame line out of Step (1 for all lines).
+ * @param PeriodInNs [in] If not 0, prefetch the first frame line at or after each period instead.
+ */
+void FramePrefetcher::SetDecimation( unsigned int Step, int64_t PeriodInNs )
+{
+	Stop();
+
+	DecimationStep = Step > 0 ? Step : 1;
+	DecimationPeriodInNs = PeriodInNs > 0 ? PeriodInNs : 0;
+}
+
+/** @brief Stop the I/O thread. Frames loaded in advance are dropped.
+ */
+void FramePrefetcher::Stop()
+{
+	{
+		lock_guard<mutex> Lock( Protect );
+		Stopping = true;
+	}
+	Changed.notify_all();
+
+	if ( IOThread.joinable() )
+	{
+		IOThread.join();
+	}
+
+	First = 0;
+	Used = 0;
+	LastIndex = -1;
+	Held = false;
+	EndOfFile = true;
+	Stopping = false;
+}
+
+/** @brief Get a prefetched frame, waiting for it if it is being loaded. Frames before it are dropped
+ *		   and the frame given by the previous call is released.
+ *
+ * @param Index [in] Zero based index of the frame.
+ * @param NumberOfSubFrames [out] Number of subframes of the frame.
+ * @return A pointer on the frame data, or nullptr if the frame is not on the way (the caller must read it).
+ */
+const unsigned char * FramePrefetcher::Acquire( int Index, int &NumberOfSubFrames )
+{
+	unique_lock<mutex> Lock( Protect );
+
+	// Release previous frame
+	if ( Held == true )
+	{
+		First = (First+1)%Ring.size();
+		Used--;
+		Held = false;
+		Changed.notify_all();
+	}
+
+	for(;;)
+	{
+		if ( Used > 0 )
+		{
+			Slot& Oldest = Ring[First];
+
+			if ( Oldest.Ready == true && Oldest.Index < Index )
+			{
+				// Skipped frame, drop it
+				First = (First+1)%Ring.size();
+				Used--;
+				Changed.notify_all();
+				continue;
+			}
+
+			if ( Oldest.Index > Index )
+			{
+				// Requested frame is behind us
+				return nullptr;
+			}
+
+			if ( Oldest.Ready == true )
+			{
+				// Oldest.Index == Index, hand it off
+				Held = true;
+				NumberOfSubFrames = Oldest.NumberOfSubFrames;
+				return &Oldest.Data[0];
+			}
+		}
+		else if ( EndOfFile == true || (LastIndex >= 0 && Index > LastIndex + (int)Ring.size()*IndexSpacing) )
+		{
+			// Nothing more will come or requested frame is more than a ring of prefetched frames away
+			// (in frame lines, decimation included), let the caller read it. Before the first queued
+			// frame, the I/O thread is reading the next lines of the caller, wait for it.
+			return nullptr;
+		}
+
+		// Wait for the I/O thread
+		Changed.wait( Lock );
+	}
+}
+
+/** @brief Main loop of the I/O thread.
+ */
+void FramePrefetcher::Run()
+{
+	for(;;)
+	{
+		int Index, NumberOfSubFrames;
+		int64_t FirstSubFrame;
+		Slot * NewSlot;
+
+		bool NewFrame = ReadNextFrameLine( Index, NumberOfSubFrames, FirstSubFrame );
+
+		{
+			unique_lock<mutex> Lock( Protect );
+
+			if ( NewFrame == false )
+			{
+				EndOfFile = true;
+				Changed.notify_all();
+				return;
+			}
+
+			// Wait for a free slot
+			while( Stopping == false && Used == Ring.size() )
+			{
+				Changed.wait( Lock );
+			}
+			if ( Stopping == true )
+			{
+				return;
+			}
+
+			NewSlot = &Ring[(First+Used)%Ring.size()];
+			NewSlot->Index = Index;
+			NewSlot->NumberOfSubFrames = NumberOfSubFrames;
+			NewSlot->Ready = false;
+			if ( LastIndex >= 0 && Index > LastIndex )
+			{
+				IndexSpacing = Index - LastIndex;
+			}
+			LastIndex = Index;
+			Used++;
+		}
+		Changed.notify_all();
+
+		// Load the frame, the consumer does not access slots being loaded
+		size_t LoadSize = (size_t)FrameSize*(size_t)NumberOfSubFrames;
+		if ( NewSlot->Data.size() < LoadSize )
+		{
+			NewSlot->Data.resize( LoadSize );
+		}
+
+		int64_t NewPos = FirstSubFrame*(int64_t)FrameSize;
+		bool Loaded = true;
+		if ( NewPos != RawPosition && fRaw.Seek( NewPos, SEEK_SET ) != 0 )
+		{
+			Loaded = false;
+		}
+		if ( Loaded == true && fRaw.Read( &NewSlot->Data[0], LoadSize, 1 ) != 1 )
+		{
+			Loaded = false;
+		}
+		RawPosition = Loaded ? NewPos + (int64_t)LoadSize : -1;
+
+		{
+			lock_guard<mutex> Lock( Protect );
+
+			if ( Loaded == false )
+			{
+				// Remove the slot (the last one) and stop here
+				Used--;
+				EndOfFile = true;
+				Changed.notify_all();
+				return;
+			}
+
+			NewSlot->Ready = true;
+		}
+		Changed.notify_all();
+	}
+}
+
+/** @brief Read the next line with frames in the timestamp file.
+ *
+ * @param Index [out] Zero based index of the frame.
+ * @param NumberOfSubFrames [out] Number of subframes.
+ * @param FirstSubFrame [out] Position of the frame in the raw file, in number of (sub)frames.
+ * @return False at end of the timestamp file.
+ */
+bool FramePrefetcher::ReadNextFrameLine( int &Index, int &NumberOfSubFrames, int64_t &FirstSubFrame )
+{
+	for(;;)
+	{
+		HighResTimestamp Timestamp;
+		int EndOfTimestampPosition;
+
+		if ( fTimestamps.ReadLine( &LineBuffer[0], (int)LineBuffer.size()-1 ) == nullptr )
+		{
+			return false;
+		}
+
+		// Same parsing as the index (see TimestampIndex::ParseFrameFields)
+		if ( HighResTimestamp::Parse( &LineBuffer[0], Timestamp, EndOfTimestampPosition ) == false )
+		{
+			continue;
+		}
+
+		TimestampIndexEntry Fields;
+		TimestampIndex::ParseFrameFields( &LineBuffer[EndOfTimestampPosition], Fields );
+		if ( Fields.FrameNumber < 0 )
+		{
+			continue;
+		}
+
+		Index = Fields.FrameNumber - StartingFrame;
+		NumberOfSubFrames = 1;
+		FirstSubFrame = (int64_t)Index;
+
+		if ( SubFramesMode == true )
+		{
+			// Subframes of the lines are stored one after the other, skipped lines included
+			NumberOfSubFrames = Fields.NumberOfSubFrames;
+			FirstSubFrame = NextSubFrame;
+			if ( NumberOfSubFrames > 0 )
+			{
+				NextSubFrame += (int64_t)NumberOfSubFrames;
+			}
+		}
+
+		if ( KeepLine( Timestamp ) == false || NumberOfSubFrames <= 0 )
+		{
+			// Not read by the consumer or no data to load
+			continue;
+		}
+
+		return true;
+	}
+}
+
+/** @brief With decimation, check if a frame line must be prefetched and update the decimation state.
+ *		   Lines are kept as in ReadTimestampRawFile::GetNextFrame.
+ *
+ * @param Timestamp [in] Timestamp of the line.
+ * @return True if the line is kept.
+ */
+bool FramePrefetcher::KeepLine( const HighResTimestamp& Timestamp )
+{
+	if ( DecimationPeriodInNs > 0 )
+	{
+		if ( Timestamp < NextDecimationTimestamp )
+		{
+			return false;
+		}
+
+		// Next period, or one period after this line if we are late (gap in the recording)
+		NextDecimationTimestamp = NextDecimationTimestamp + DecimationPeriodInNs;
+		if ( NextDecimationTimestamp <= Timestamp )
+		{
+			NextDecimationTimestamp = Timestamp + DecimationPeriodInNs;
+		}
+		return true;
+	}
+
+	if ( SkippedLines > 0 )
+	{
+		SkippedLines--;
+		return false;
+	}
+
+	SkippedLines = DecimationStep - 1;
+	return true;
+}
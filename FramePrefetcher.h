@@ -0,0 +1,149 @@
+/**
+ * @file FramePrefetcher.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __FRAME_PREFETCHER_H__
+#define __FRAME_PREFETCHER_H__
+
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "DataFile.h"
+#include "TimestampTools.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class FramePrefetcher FramePrefetcher.cpp FramePrefetcher.h
+ * @brief Read frames of a raw file in advance. An I/O thread reads the next lines of the timestamp
+ *		  file, retrieves their frame numbers and loads the frames into a ring of preallocated
+ *		  buffers. The consumer gets a pointer on a loaded frame, valid until its next call to Acquire.
+ *		  The prefetcher uses its own files, it does not change the position of the reader using it.
+ *		  Frame numbers are read as in ReadTimestampRawFile::GetFrameNumber.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class FramePrefetcher
+{
+public:
+	/** @brief Constructor. Allocate the ring, the I/O thread is not started.
+	 *
+	 * @param TimestampFileName [in] Name of the timestamp file.
+	 * @param RawFileName [in] Name of the raw file.
+	 * @param SizeOfFrame [in] Size of each frame (or subframe) in the raw file.
+	 * @param FirstFrame [in] Number of the first frame of the raw file.
+	 * @param SubFrames [in] Lines contain a number of subframes after the frame number (see ReadTimestampRawFile::SubFramesMode).
+	 * @param NumberOfSlots [in] Number of frames read in advance.
+	 * @param SizeOfLineBuffer [in] Size of buffer to read each line of the timestamp file.
+	 */
+	FramePrefetcher( const std::string& TimestampFileName, const std::string& RawFileName, int SizeOfFrame, int FirstFrame, bool SubFrames,
+		unsigned int NumberOfSlots, size_t SizeOfLineBuffer );
+
+	/** @brief Virtual destructor, always. Stop the I/O thread.
+	 */
+	virtual ~FramePrefetcher();
+
+	/** @brief (Re)start prefetching from a line of the timestamp file. Frames loaded in advance are dropped.
+	 *
+	 * @param Position [in] Position of a line in the timestamp file.
+	 * @param FirstSubFrame [in] In subframes mode, number of subframes in the raw file before the ones of this line (default=0).
+	 * @param LinesToSkip [in] With a decimation step, number of frame lines to skip before the first prefetched one (default=0).
+	 * @param NextTimestamp [in] With a decimation period, minimal timestamp of the first prefetched line (default=0).
+	 */
+	void Start( int64_t Position, int64_t FirstSubFrame = 0, unsigned int LinesToSkip = 0, const HighResTimestamp& NextTimestamp = HighResTimestamp() );
+
+	/** @brief Only prefetch frames read by a decimated reader (see ReadTimestampRawFile::SetDecimation),
+	 *		   taken into account by the next call to Start.
+	 *
+	 * @param Step [in] Prefetch one frame line out of Step (1 for all lines).
+	 * @param PeriodInNs [in] If not 0, prefetch the first frame line at or after each period instead.
+	 */
+	void SetDecimation( unsigned int Step, int64_t PeriodInNs );
+
+	/** @brief Stop the I/O thread. Frames loaded in advance are dropped.
+	 */
+	void Stop();
+
+	/** @brief Get a prefetched frame, waiting for it if it is being loaded. Frames before it are dropped
+	 *		   and the frame given by the previous call is released.
+	 *
+	 * @param Index [in] Zero based index of the frame.
+	 * @param NumberOfSubFrames [out] Number of subframes of the frame.
+	 * @return A pointer on the frame data, or nullptr if the frame is not on the way (the caller must read it).
+	 */
+	const unsigned char * Acquire( int Index, int &NumberOfSubFrames );
+
+protected:
+	/**
+	 * @struct FramePrefetcher::Slot FramePrefetcher.h
+	 * @brief A buffer of the ring.
+	 */
+	struct Slot
+	{
+		int Index;									/*!< @brief Zero based index of the frame. */
+		int NumberOfSubFrames;						/*!< @brief Number of subframes. */
+		bool Ready;									/*!< @brief Data are loaded. */
+		std::vector<unsigned char> Data;			/*!< @brief Frame data. */
+	};
+
+	/** @brief Main loop of the I/O thread.
+	 */
+	void Run();
+
+	/** @brief Read the next line with frames in the timestamp file.
+	 *
+	 * @param Index [out] Zero based index of the frame.
+	 * @param NumberOfSubFrames [out] Number of subframes.
+	 * @param FirstSubFrame [out] Position of the frame in the raw file, in number of (sub)frames.
+	 * @return False at end of the timestamp file.
+	 */
+	bool ReadNextFrameLine( int &Index, int &NumberOfSubFrames, int64_t &FirstSubFrame );
+
+	/** @brief With decimation, check if a frame line must be prefetched and update the decimation state.
+	 *
+	 * @param Timestamp [in] Timestamp of the line.
+	 * @return True if the line is kept.
+	 */
+	bool KeepLine( const HighResTimestamp& Timestamp );
+
+	std::string TimestampFileName;				/*!< @brief Name of the timestamp file. */
+	std::string RawFileName;					/*!< @brief Name of the raw file. */
+	int FrameSize;								/*!< @brief Size of each frame (or subframe). */
+	int StartingFrame;							/*!< @brief Number of the first frame of the raw file. */
+	bool SubFramesMode;							/*!< @brief Lines contain a number of subframes. */
+
+	DataFile fTimestamps;						/*!< @brief Timestamp file read by the I/O thread. */
+	DataFile fRaw;								/*!< @brief Raw file read by the I/O thread. */
+	int64_t RawPosition;						/*!< @brief Position in fRaw. */
+	int64_t NextSubFrame;						/*!< @brief In subframes mode, position of the subframes of the next line (in number of subframes). */
+	std::vector<char> LineBuffer;				/*!< @brief Buffer to read lines of the timestamp file. */
+	unsigned int DecimationStep;				/*!< @brief Prefetch one frame line out of DecimationStep. */
+	int64_t DecimationPeriodInNs;				/*!< @brief If not 0, prefetch one frame line per period. */
+	unsigned int SkippedLines;					/*!< @brief Number of frame lines still to skip (decimation step). */
+	HighResTimestamp NextDecimationTimestamp;	/*!< @brief Minimal timestamp of the next prefetched line (decimation period). */
+
+	std::vector<Slot> Ring;						/*!< @brief Ring of preallocated frame buffers. */
+	size_t First;								/*!< @brief Oldest slot in use. */
+	size_t Used;								/*!< @brief Number of slots in use (loaded, being loaded or held by the consumer). */
+	int LastIndex;								/*!< @brief Index of the last frame queued by the I/O thread. */
+	int IndexSpacing;							/*!< @brief Distance between the indexes of the last 2 queued frames (frame lines from one prefetched frame to the next one). */
+	bool Held;									/*!< @brief The oldest slot is held by the consumer. */
+	bool EndOfFile;								/*!< @brief The I/O thread reached the end of the files (or an error). */
+	bool Stopping;								/*!< @brief Ask the I/O thread to stop. */
+
+	std::thread IOThread;						/*!< @brief The I/O thread. */
+	std::mutex Protect;							/*!< @brief Protect ring state. */
+	std::condition_variable Changed;			/*!< @brief Signal changes of the ring state. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __FRAME_PREFETCHER_H__
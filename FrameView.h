@@ -0,0 +1,70 @@
+/**
+ * @file FrameView.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __FRAME_VIEW_H__
+#define __FRAME_VIEW_H__
+
+#include <stddef.h>
+
+#include <memory>
+
+#include "TimestampTools.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct FrameView FrameView.h
+ * @brief Read only view on a frame (or on all subframes of a timestamp), usually directly in the
+ *		  mapping of the raw file. Data stay valid as long as the view (or a copy of it) exists,
+ *		  even if the reader is closed or reads other frames.
+ */
+struct FrameView
+{
+	const unsigned char * Data;				/*!< @brief Pointer on the frame data, nullptr if the view is empty. */
+	size_t Size;							/*!< @brief Size of the data in bytes. */
+	int FrameIndex;							/*!< @brief Zero based index of the frame in the raw file. */
+	int NumberOfSubFrames;					/*!< @brief Number of subframes (1 in single frame mode). */
+	HighResTimestamp Timestamp;				/*!< @brief Timestamp of the frame. */
+	std::shared_ptr<const void> Holder;		/*!< @brief Keep the memory of the data alive. */
+
+	/** @brief Constructor. Create an empty view.
+	 */
+	FrameView() : Data(nullptr), Size(0), FrameIndex(-1), NumberOfSubFrames(0) {}
+
+	/** @brief Return true if the view contains data.
+	 */
+	bool IsValid() const { return (Data != nullptr); }
+
+	/** @brief Release the data.
+	 */
+	void Reset() { *this = FrameView(); }
+};
+
+/**
+ * @struct FrameROI FrameView.h
+ * @brief Region of interest in a frame, in pixels.
+ */
+struct FrameROI
+{
+	int x;									/*!< @brief First column. */
+	int y;									/*!< @brief First row. */
+	int Width;								/*!< @brief Number of columns. */
+	int Height;								/*!< @brief Number of rows. */
+
+	/** @brief Constructor.
+	 *
+	 * @param ex [in] First column (default=0).
+	 * @param ey [in] First row (default=0).
+	 * @param eWidth [in] Number of columns (default=0).
+	 * @param eHeight [in] Number of rows (default=0).
+	 */
+	FrameROI( int ex = 0, int ey = 0, int eWidth = 0, int eHeight = 0 ) : x(ex), y(ey), Width(eWidth), Height(eHeight) {}
+};
+
+} // namespace MobileRGBD
+
+#endif // __FRAME_VIEW_H__
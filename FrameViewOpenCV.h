@@ -0,0 +1,125 @@
+/**
+ * @file FrameViewOpenCV.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __FRAME_VIEW_OPENCV_H__
+#define __FRAME_VIEW_OPENCV_H__
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "FrameView.h"
+#include "VariableSizeRawFile.h"
+
+namespace MobileRGBD {
+
+	static const int Kinect2DepthWidth = 512;		/*!< @brief Width of Kinect2 depth and infrared frames. */
+	static const int Kinect2DepthHeight = 424;		/*!< @brief Height of Kinect2 depth and infrared frames. */
+	static const int Kinect2ColorWidth = 1920;		/*!< @brief Width of Kinect2 color frames. */
+	static const int Kinect2ColorHeight = 1080;		/*!< @brief Height of Kinect2 color frames. */
+
+	/** @brief Wrap a frame view in a cv::Mat header without copying data. The cv::Mat must only be read
+	 *		   and must not be used after the destruction of the view (clone it if needed).
+	 *
+	 * @param View [in] The frame view.
+	 * @param Width [in] Width of the frame.
+	 * @param Height [in] Height of the frame.
+	 * @param Type [in] OpenCV type of the frame (CV_16UC1, CV_8UC4, ...).
+	 * @return The cv::Mat header or an empty cv::Mat if the view is too small.
+	 */
+	inline cv::Mat WrapFrame( const FrameView& View, int Width, int Height, int Type )
+	{
+		if ( View.IsValid() == false || View.Size < (size_t)Width*(size_t)Height*CV_ELEM_SIZE(Type) )
+		{
+			return cv::Mat();
+		}
+
+		return cv::Mat( Height, Width, Type, const_cast<unsigned char*>(View.Data) );
+	}
+
+	/** @brief Wrap a depth frame view (16 bits per pixel) in a cv::Mat header without copying data.
+	 *
+	 * @param View [in] The frame view.
+	 * @param Width [in] Width of the frame (default=Kinect2DepthWidth).
+	 * @param Height [in] Height of the frame (default=Kinect2DepthHeight).
+	 */
+	inline cv::Mat WrapDepthFrame( const FrameView& View, int Width = Kinect2DepthWidth, int Height = Kinect2DepthHeight )
+	{
+		return WrapFrame( View, Width, Height, CV_16UC1 );
+	}
+
+	/** @brief Wrap an infrared frame view (16 bits per pixel) in a cv::Mat header without copying data.
+	 *
+	 * @param View [in] The frame view.
+	 * @param Width [in] Width of the frame (default=Kinect2DepthWidth).
+	 * @param Height [in] Height of the frame (default=Kinect2DepthHeight).
+	 */
+	inline cv::Mat WrapInfraredFrame( const FrameView& View, int Width = Kinect2DepthWidth, int Height = Kinect2DepthHeight )
+	{
+		return WrapFrame( View, Width, Height, CV_16UC1 );
+	}
+
+	/** @brief Wrap a color frame view (BGRA, 4 bytes per pixel) in a cv::Mat header without copying data.
+	 *
+	 * @param View [in] The frame view.
+	 * @param Width [in] Width of the frame (default=Kinect2ColorWidth).
+	 * @param Height [in] Height of the frame (default=Kinect2ColorHeight).
+	 */
+	inline cv::Mat WrapColorFrame( const FrameView& View, int Width = Kinect2ColorWidth, int Height = Kinect2ColorHeight )
+	{
+		return WrapFrame( View, Width, Height, CV_8UC4 );
+	}
+
+	/** @brief Decoder of frames stored as encoded images (JPEG, PNG, ...) in variable size raw files
+	 *		   (see VariableSizeRawFile). Images without alpha channel are converted to BGRA if needed.
+	 *
+	 * @param Width [in] Width of the frames (default=Kinect2ColorWidth).
+	 * @param Height [in] Height of the frames (default=Kinect2ColorHeight).
+	 * @param Type [in] OpenCV type of the decoded frames (default=CV_8UC4).
+	 */
+	inline FrameDecoder MakeImageFrameDecoder( int Width = Kinect2ColorWidth, int Height = Kinect2ColorHeight, int Type = CV_8UC4 )
+	{
+		return [Width, Height, Type]( const unsigned char * Payload, size_t PayloadSize, unsigned char * Frame, size_t FrameSize )
+		{
+			if ( PayloadSize == 0 || FrameSize != (size_t)Width*(size_t)Height*CV_ELEM_SIZE(Type) )
+			{
+				return false;
+			}
+
+			cv::Mat Encoded( 1, (int)PayloadSize, CV_8UC1, const_cast<unsigned char*>(Payload) );
+			cv::Mat Decoded = cv::imdecode( Encoded, cv::IMREAD_UNCHANGED );
+			if ( Decoded.cols != Width || Decoded.rows != Height )
+			{
+				return false;
+			}
+
+			// Decoded directly in the frame, the header does not own the data
+			cv::Mat Output( Height, Width, Type, Frame );
+			if ( Decoded.type() == Type )
+			{
+				Decoded.copyTo( Output );
+			}
+			else if ( Decoded.type() == CV_8UC3 && Type == CV_8UC4 )
+			{
+				cv::cvtColor( Decoded, Output, cv::COLOR_BGR2BGRA );
+			}
+			else if ( Decoded.type() == CV_8UC1 && Type == CV_8UC4 )
+			{
+				cv::cvtColor( Decoded, Output, cv::COLOR_GRAY2BGRA );
+			}
+			else
+			{
+				return false;
+			}
+
+			return (Output.data == Frame);
+		};
+	}
+
+} // namespace MobileRGBD
+
+#endif // __FRAME_VIEW_OPENCV_H__
@@ -0,0 +1,160 @@
+/**
+ * @file MappedFile.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "MappedFile.h"
+
+#if !defined WIN32 && !defined WIN64
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+using namespace MobileRGBD;
+
+/** @brief Constructor. Nothing is mapped.
+ */
+MappedFile::MappedFile()
+{
+	Data = nullptr;
+	Size = 0;
+#if defined WIN32 || defined WIN64
+	FileHandle = INVALID_HANDLE_VALUE;
+	MappingHandle = NULL;
+#endif
+}
+
+/** @brief Virtual destructor, always. Unmap file if needed.
+ */
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/** @brief Map a file in memory (read only).
+ *
+ * @param FileName [in] Name of the file to map.
+ * @return True if the file has been mapped.
+ */
+bool MappedFile::Open( const std::string& FileName )
+{
+	Close();
+
+#if defined WIN32 || defined WIN64
+	FileHandle = CreateFileA( FileName.c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( FileHandle == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+	if ( GetFileSizeEx( FileHandle, &FileSize ) == FALSE || FileSize.QuadPart == 0 )
+	{
+		Close();
+		return false;
+	}
+
+	MappingHandle = CreateFileMapping( FileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( MappingHandle == NULL )
+	{
+		Close();
+		return false;
+	}
+
+	Data = (const unsigned char *)MapViewOfFile( MappingHandle, FILE_MAP_READ, 0, 0, 0 );
+	if ( Data == nullptr )
+	{
+		Close();
+		return false;
+	}
+	Size = (int64_t)FileSize.QuadPart;
+#else
+	int fd = open( FileName.c_str(), O_RDONLY );
+	if ( fd < 0 )
+	{
+		return false;
+	}
+
+	struct stat FileStat;
+	if ( fstat( fd, &FileStat ) != 0 || FileStat.st_size == 0 )
+	{
+		close( fd );
+		return false;
+	}
+
+	void * Mapping = mmap( nullptr, (size_t)FileStat.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+
+	// Mapping stays valid after closing the file descriptor
+	close( fd );
+
+	if ( Mapping == MAP_FAILED )
+	{
+		return false;
+	}
+
+	Data = (const unsigned char *)Mapping;
+	Size = (int64_t)FileStat.st_size;
+#endif
+
+	return true;
+}
+
+/** @brief Unmap the file.
+ */
+void MappedFile::Close()
+{
+#if defined WIN32 || defined WIN64
+	if ( Data != nullptr )
+	{
+		UnmapViewOfFile( Data );
+	}
+	if ( MappingHandle != NULL )
+	{
+		CloseHandle( MappingHandle );
+		MappingHandle = NULL;
+	}
+	if ( FileHandle != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( FileHandle );
+		FileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if ( Data != nullptr )
+	{
+		munmap( (void*)Data, (size_t)Size );
+	}
+#endif
+
+	Data = nullptr;
+	Size = 0;
+}
+
+/** @brief Give a hint to the system that a part of the file will be read soon.
+ *
+ * @param Offset [in] Start of the part in the file.
+ * @param Length [in] Length of the part.
+ */
+void MappedFile::WillNeed( int64_t Offset, int64_t Length )
+{
+	if ( Data == nullptr || Offset < 0 || Offset >= Size )
+	{
+		return;
+	}
+
+#if !defined WIN32 && !defined WIN64
+	// madvise needs an address aligned on a page
+	int64_t PageSize = (int64_t)sysconf( _SC_PAGESIZE );
+	int64_t AlignedOffset = Offset - (Offset % PageSize);
+
+	if ( Offset + Length > Size )
+	{
+		Length = Size - Offset;
+	}
+
+	madvise( (void*)(Data + AlignedOffset), (size_t)(Length + (Offset - AlignedOffset)), MADV_WILLNEED );
+#endif
+}
@@ -0,0 +1,83 @@
+/**
+ * @file MappedFile.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <string>
+
+#if defined WIN32 || defined WIN64
+#define _WINSOCKAPI_   /* Prevent inclusion of winsock.h in windows.h */
+#include <Windows.h>
+#endif
+
+namespace MobileRGBD {
+
+/**
+ * @class MappedFile MappedFile.cpp MappedFile.h
+ * @brief Map a whole usual file in memory in read only mode (mmap under Linux/MacOSX,
+ *		  file mapping under Windows). Compressed (7z) files can not be mapped.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class MappedFile
+{
+public:
+	/** @brief Constructor. Nothing is mapped.
+	 */
+	MappedFile();
+
+	/** @brief Virtual destructor, always. Unmap file if needed.
+	 */
+	virtual ~MappedFile();
+
+	/** @brief Map a file in memory (read only).
+	 *
+	 * @param FileName [in] Name of the file to map.
+	 * @return True if the file has been mapped.
+	 */
+	bool Open( const std::string& FileName );
+
+	/** @brief Unmap the file.
+	 */
+	void Close();
+
+	/** @brief Return true if a file is mapped.
+	 */
+	bool IsOpen() const { return (Data != nullptr); }
+
+	/** @brief Pointer to the first byte of the file (nullptr if not mapped).
+	 */
+	const unsigned char * GetData() const { return Data; }
+
+	/** @brief Size of the mapped file.
+	 */
+	int64_t GetSize() const { return Size; }
+
+	/** @brief Give a hint to the system that a part of the file will be read soon.
+	 *
+	 * @param Offset [in] Start of the part in the file.
+	 * @param Length [in] Length of the part.
+	 */
+	void WillNeed( int64_t Offset, int64_t Length );
+
+protected:
+	const unsigned char * Data;		/*!< @brief Address of the mapping. */
+	int64_t Size;					/*!< @brief Size of the mapping. */
+
+#if defined WIN32 || defined WIN64
+	HANDLE FileHandle;				/*!< @brief Handle on the file. */
+	HANDLE MappingHandle;			/*!< @brief Handle on the file mapping. */
+#endif
+};
+
+} // namespace MobileRGBD
+
+#endif // __MAPPED_FILE_H__
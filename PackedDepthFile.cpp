@@ -0,0 +1,548 @@
+/**
+ * @file PackedDepthFile.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "PackedDepthFile.h"
+
+#include <string.h>
+
+#if defined __x86_64__ || defined __i386__ || defined _M_X64 || defined _M_IX86
+	#define PACKED_DEPTH_USE_SIMD
+	#include <immintrin.h>
+	#if defined _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
+
+// gcc and clang compile SIMD functions for their target only, other functions stay generic
+#if defined __GNUC__
+	#define PACKED_DEPTH_TARGET(Target) __attribute__((target(Target)))
+#else
+	#define PACKED_DEPTH_TARGET(Target)
+#endif
+
+using namespace std;
+using namespace MobileRGBD;
+
+const char PackedDepthFile::Magic[8] = { 'M', 'R', 'G', 'B', 'D', 'P', '1', '3' };	/*!< @brief Magic value at the beginning of the file ("MRGBDP13"). */
+const uint32_t PackedDepthFile::CurrentVersion = 1;									/*!< @brief Version of the format written by this code (1). */
+
+namespace {
+
+	const uint32_t DepthBits = 13;						/*!< @brief Number of bits of a packed value. */
+	const uint32_t DepthMask = (1u << DepthBits) - 1;	/*!< @brief Mask of a packed value. */
+
+	/** @brief Unpack values one by one, reading only the needed bytes.
+	 *
+	 * @param Packed [in] Packed values.
+	 * @param NumberOfValues [in] Number of values.
+	 * @param Depth [out] Values, converted to OutputType and multiplied by Scale.
+	 * @param Scale [in] Scale of the values.
+	 */
+	template<typename OutputType>
+	void UnpackDepthScalar( const unsigned char * Packed, size_t NumberOfValues, OutputType * Depth, float Scale )
+	{
+		uint32_t Accumulator = 0;
+		uint32_t NumberOfBits = 0;
+
+		for( size_t i = 0; i < NumberOfValues; i++ )
+		{
+			while( NumberOfBits < DepthBits )
+			{
+				Accumulator |= (uint32_t)(*Packed++) << NumberOfBits;
+				NumberOfBits += 8;
+			}
+
+			uint32_t Value = Accumulator & DepthMask;
+			Accumulator >>= DepthBits;
+			NumberOfBits -= DepthBits;
+
+			if ( sizeof(OutputType) == sizeof(uint16_t) )
+			{
+				Depth[i] = (OutputType)Value;
+			}
+			else
+			{
+				Depth[i] = (OutputType)((float)Value*Scale);
+			}
+		}
+	}
+
+#ifdef PACKED_DEPTH_USE_SIMD
+
+	/* 8 values use 13 bytes. Each value is moved in a 32 bits lane with the 3 bytes containing it,
+	 * then shifted by its position in the first byte (0, 5, 2, 7, 4, 1, 6, 3) and masked.
+	 */
+
+	/** @brief Move bytes of values 0 to 3 of a group of 8 values in 32 bits lanes.
+	 */
+	PACKED_DEPTH_TARGET("sse4.1") inline __m128i GetFirstShuffle() { return _mm_setr_epi8( 0, 1, 2, -1, 1, 2, 3, -1, 3, 4, 5, -1, 4, 5, 6, -1 ); }
+
+	/** @brief Move bytes of values 4 to 7 of a group of 8 values in 32 bits lanes.
+	 */
+	PACKED_DEPTH_TARGET("sse4.1") inline __m128i GetSecondShuffle() { return _mm_setr_epi8( 6, 7, 8, -1, 8, 9, 10, -1, 9, 10, 11, -1, 11, 12, 13, -1 ); }
+
+	/** @brief Unpack a group of 8 values in two vectors of 4 values (SSE4.1 has no variable shift, values
+	 *		   are first shifted left by 7 minus their position with a multiplication).
+	 *
+	 * @param Packed [in] Packed values, 16 bytes must be readable.
+	 * @param First [out] Values 0 to 3.
+	 * @param Second [out] Values 4 to 7.
+	 */
+	PACKED_DEPTH_TARGET("sse4.1") inline void UnpackGroupSSE41( const unsigned char * Packed, __m128i& First, __m128i& Second )
+	{
+		const __m128i Mask = _mm_set1_epi32( (int)DepthMask );
+		__m128i Bytes = _mm_loadu_si128( (const __m128i*)Packed );
+
+		First = _mm_mullo_epi32( _mm_shuffle_epi8( Bytes, GetFirstShuffle() ), _mm_setr_epi32( 128, 4, 32, 1 ) );
+		Second = _mm_mullo_epi32( _mm_shuffle_epi8( Bytes, GetSecondShuffle() ), _mm_setr_epi32( 8, 64, 2, 16 ) );
+		First = _mm_and_si128( _mm_srli_epi32( First, 7 ), Mask );
+		Second = _mm_and_si128( _mm_srli_epi32( Second, 7 ), Mask );
+	}
+
+	/** @brief Unpack values with SSE4.1, 8 values at a time.
+	 *
+	 * @return Number of values unpacked, the remaining ones are left to the scalar code.
+	 */
+	PACKED_DEPTH_TARGET("sse4.1") size_t UnpackDepthSSE41( const unsigned char * Packed, size_t NumberOfValues, uint16_t * Depth )
+	{
+		size_t PackedSize = GetPackedDepthSize( NumberOfValues );
+		size_t i = 0;
+
+		for( ; i + 8 <= NumberOfValues && (i/8)*13 + 16 <= PackedSize; i += 8 )
+		{
+			__m128i First, Second;
+			UnpackGroupSSE41( Packed + (i/8)*13, First, Second );
+			_mm_storeu_si128( (__m128i*)(Depth + i), _mm_packus_epi32( First, Second ) );
+		}
+
+		return i;
+	}
+
+	/** @brief Unpack values to floats with SSE4.1, 8 values at a time.
+	 *
+	 * @return Number of values unpacked, the remaining ones are left to the scalar code.
+	 */
+	PACKED_DEPTH_TARGET("sse4.1") size_t UnpackDepthSSE41( const unsigned char * Packed, size_t NumberOfValues, float * Depth, float Scale )
+	{
+		const __m128 ScaleVector = _mm_set1_ps( Scale );
+		size_t PackedSize = GetPackedDepthSize( NumberOfValues );
+		size_t i = 0;
+
+		for( ; i + 8 <= NumberOfValues && (i/8)*13 + 16 <= PackedSize; i += 8 )
+		{
+			__m128i First, Second;
+			UnpackGroupSSE41( Packed + (i/8)*13, First, Second );
+			_mm_storeu_ps( Depth + i, _mm_mul_ps( _mm_cvtepi32_ps( First ), ScaleVector ) );
+			_mm_storeu_ps( Depth + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( Second ), ScaleVector ) );
+		}
+
+		return i;
+	}
+
+	/** @brief Unpack two groups of 8 values with AVX2. Each 128 bits lane gets a group, the first vector
+	 *		   contains values 0-3 and 8-11, the second one values 4-7 and 12-15.
+	 *
+	 * @param Packed [in] Packed values, 29 bytes must be readable.
+	 * @param First [out] Values 0 to 3 and 8 to 11.
+	 * @param Second [out] Values 4 to 7 and 12 to 15.
+	 */
+	PACKED_DEPTH_TARGET("avx2") inline void UnpackGroupsAVX2( const unsigned char * Packed, __m256i& First, __m256i& Second )
+	{
+		const __m256i Mask = _mm256_set1_epi32( (int)DepthMask );
+		__m256i Bytes = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)Packed ) ),
+			_mm_loadu_si128( (const __m128i*)(Packed + 13) ), 1 );
+
+		First = _mm256_shuffle_epi8( Bytes, _mm256_broadcastsi128_si256( GetFirstShuffle() ) );
+		Second = _mm256_shuffle_epi8( Bytes, _mm256_broadcastsi128_si256( GetSecondShuffle() ) );
+		First = _mm256_and_si256( _mm256_srlv_epi32( First, _mm256_setr_epi32( 0, 5, 2, 7, 0, 5, 2, 7 ) ), Mask );
+		Second = _mm256_and_si256( _mm256_srlv_epi32( Second, _mm256_setr_epi32( 4, 1, 6, 3, 4, 1, 6, 3 ) ), Mask );
+	}
+
+	/** @brief Unpack values with AVX2, 16 values at a time.
+	 *
+	 * @return Number of values unpacked, the remaining ones are left to the scalar code.
+	 */
+	PACKED_DEPTH_TARGET("avx2") size_t UnpackDepthAVX2( const unsigned char * Packed, size_t NumberOfValues, uint16_t * Depth )
+	{
+		size_t PackedSize = GetPackedDepthSize( NumberOfValues );
+		size_t i = 0;
+
+		for( ; i + 16 <= NumberOfValues && (i/8)*13 + 29 <= PackedSize; i += 16 )
+		{
+			__m256i First, Second;
+			UnpackGroupsAVX2( Packed + (i/8)*13, First, Second );
+
+			// Packing works in each lane, values are already in order
+			_mm256_storeu_si256( (__m256i*)(Depth + i), _mm256_packus_epi32( First, Second ) );
+		}
+
+		return i;
+	}
+
+	/** @brief Unpack values to floats with AVX2, 16 values at a time.
+	 *
+	 * @return Number of values unpacked, the remaining ones are left to the scalar code.
+	 */
+	PACKED_DEPTH_TARGET("avx2") size_t UnpackDepthAVX2( const unsigned char * Packed, size_t NumberOfValues, float * Depth, float Scale )
+	{
+		const __m256 ScaleVector = _mm256_set1_ps( Scale );
+		size_t PackedSize = GetPackedDepthSize( NumberOfValues );
+		size_t i = 0;
+
+		for( ; i + 16 <= NumberOfValues && (i/8)*13 + 29 <= PackedSize; i += 16 )
+		{
+			__m256i First, Second;
+			UnpackGroupsAVX2( Packed + (i/8)*13, First, Second );
+
+			// Low lanes contain values 0-7, high lanes values 8-15
+			__m256i Low = _mm256_permute2x128_si256( First, Second, 0x20 );
+			__m256i High = _mm256_permute2x128_si256( First, Second, 0x31 );
+			_mm256_storeu_ps( Depth + i, _mm256_mul_ps( _mm256_cvtepi32_ps( Low ), ScaleVector ) );
+			_mm256_storeu_ps( Depth + i + 8, _mm256_mul_ps( _mm256_cvtepi32_ps( High ), ScaleVector ) );
+		}
+
+		return i;
+	}
+
+#endif // PACKED_DEPTH_USE_SIMD
+
+	/** @enum UnpackImplementation
+	 *  @brief Unpacking code used on this processor.
+	 */
+	enum UnpackImplementation
+	{
+		ScalarUnpack = 0,		/*!< @brief Portable code. */
+		SSE41Unpack = 1,		/*!< @brief SSE4.1 code. */
+		AVX2Unpack = 2			/*!< @brief AVX2 code. */
+	};
+
+	/** @brief Check once which unpacking code the processor supports.
+	 */
+	UnpackImplementation GetUnpackImplementation()
+	{
+		static const UnpackImplementation Implementation = []() -> UnpackImplementation
+		{
+#if defined PACKED_DEPTH_USE_SIMD && defined __GNUC__
+			__builtin_cpu_init();
+			if ( __builtin_cpu_supports( "avx2" ) )
+			{
+				return AVX2Unpack;
+			}
+			if ( __builtin_cpu_supports( "sse4.1" ) )
+			{
+				return SSE41Unpack;
+			}
+#elif defined PACKED_DEPTH_USE_SIMD && defined _MSC_VER
+			int Registers[4];
+			__cpuid( Registers, 1 );
+			bool HasSSE41 = (Registers[2] & (1 << 19)) != 0;
+			bool HasAVX = (Registers[2] & (1 << 27)) != 0 && (Registers[2] & (1 << 28)) != 0 && (_xgetbv( 0 ) & 6) == 6;
+			__cpuidex( Registers, 7, 0 );
+			if ( HasAVX == true && (Registers[1] & (1 << 5)) != 0 )
+			{
+				return AVX2Unpack;
+			}
+			if ( HasSSE41 == true )
+			{
+				return SSE41Unpack;
+			}
+#endif
+			return ScalarUnpack;
+		}();
+
+		return Implementation;
+	}
+
+} // namespace
+
+/** @brief Pack depth values on 13 bits (least significant bits first). Kinect2 depth values are below 8192 mm,
+ *		   larger values are clamped to 8191.
+ *
+ * @param Depth [in] Depth values.
+ * @param NumberOfValues [in] Number of values.
+ * @param Packed [out] Packed values (GetPackedDepthSize(NumberOfValues) bytes).
+ */
+void MobileRGBD::PackDepth( const uint16_t * Depth, size_t NumberOfValues, unsigned char * Packed )
+{
+	uint32_t Accumulator = 0;
+	uint32_t NumberOfBits = 0;
+
+	for( size_t i = 0; i < NumberOfValues; i++ )
+	{
+		uint32_t Value = Depth[i] > DepthMask ? DepthMask : Depth[i];
+
+		Accumulator |= Value << NumberOfBits;
+		NumberOfBits += DepthBits;
+		while( NumberOfBits >= 8 )
+		{
+			*Packed++ = (unsigned char)Accumulator;
+			Accumulator >>= 8;
+			NumberOfBits -= 8;
+		}
+	}
+
+	if ( NumberOfBits > 0 )
+	{
+		*Packed = (unsigned char)Accumulator;
+	}
+}
+
+/** @brief Unpack 13 bits depth values (SSE4.1 or AVX2 when the processor supports them).
+ *
+ * @param Packed [in] Packed values (GetPackedDepthSize(NumberOfValues) bytes).
+ * @param NumberOfValues [in] Number of values.
+ * @param Depth [out] Depth values.
+ */
+void MobileRGBD::UnpackDepth( const unsigned char * Packed, size_t NumberOfValues, uint16_t * Depth )
+{
+	size_t Done = 0;
+
+#ifdef PACKED_DEPTH_USE_SIMD
+	switch( GetUnpackImplementation() )
+	{
+		case AVX2Unpack:
+			Done = UnpackDepthAVX2( Packed, NumberOfValues, Depth );
+			break;
+
+		case SSE41Unpack:
+			Done = UnpackDepthSSE41( Packed, NumberOfValues, Depth );
+			break;
+
+		default:
+			break;
+	}
+#endif
+
+	// Done is a multiple of 8, i.e. the remaining values start on a byte
+	UnpackDepthScalar( Packed + (Done/8)*13, NumberOfValues - Done, Depth + Done, 1.0f );
+}
+
+/** @brief Unpack 13 bits depth values to floats (SSE4.1 or AVX2 when the processor supports them).
+ *
+ * @param Packed [in] Packed values (GetPackedDepthSize(NumberOfValues) bytes).
+ * @param NumberOfValues [in] Number of values.
+ * @param Depth [out] Depth values multiplied by Scale.
+ * @param Scale [in] Scale of the values, 0.001 gives meters (default=1).
+ */
+void MobileRGBD::UnpackDepth( const unsigned char * Packed, size_t NumberOfValues, float * Depth, float Scale /* = 1.0f */ )
+{
+	size_t Done = 0;
+
+#ifdef PACKED_DEPTH_USE_SIMD
+	switch( GetUnpackImplementation() )
+	{
+		case AVX2Unpack:
+			Done = UnpackDepthAVX2( Packed, NumberOfValues, Depth, Scale );
+			break;
+
+		case SSE41Unpack:
+			Done = UnpackDepthSSE41( Packed, NumberOfValues, Depth, Scale );
+			break;
+
+		default:
+			break;
+	}
+#endif
+
+	UnpackDepthScalar( Packed + (Done/8)*13, NumberOfValues - Done, Depth + Done, Scale );
+}
+
+/** @brief Name of the unpacking code used on this processor ("avx2", "sse4.1" or "scalar").
+ */
+const char * MobileRGBD::GetUnpackDepthImplementation()
+{
+	switch( GetUnpackImplementation() )
+	{
+		case AVX2Unpack:
+			return "avx2";
+
+		case SSE41Unpack:
+			return "sse4.1";
+
+		default:
+			return "scalar";
+	}
+}
+
+/** @brief Constructor. No file is opened.
+ */
+PackedDepthFile::PackedDepthFile()
+{
+	memset( &Header, 0, sizeof(Header) );
+	NumberOfValues = 0;
+	PackedFrameSize = 0;
+}
+
+/** @brief Check if a file is a packed depth file, i.e. starts with the magic value.
+ *
+ * @param FileName [in] Name of the file.
+ */
+bool PackedDepthFile::IsPackedDepthFile( const string& FileName )
+{
+	char FileMagic[sizeof(Magic)];
+	bool Result = false;
+
+	FILE * fFile = fopen( FileName.c_str(), "rb" );
+	if ( fFile != nullptr )
+	{
+		Result = (fread( FileMagic, sizeof(FileMagic), 1, fFile ) == 1 && memcmp( FileMagic, Magic, sizeof(Magic) ) == 0);
+		fclose( fFile );
+	}
+
+	return Result;
+}
+
+/** @brief Open a packed depth file and check its header.
+ *
+ * @param FileName [in] Name of the packed depth file.
+ * @param ExpectedFrameSize [in] Size of unpacked frames expected by the caller.
+ * @return True if the file is opened.
+ */
+bool PackedDepthFile::Open( const string& FileName, int ExpectedFrameSize )
+{
+	Close();
+
+	if ( fIn.Open( FileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return false;
+	}
+
+	if ( fIn.ReadAt( &Header, sizeof(Header), 0 ) != sizeof(Header) || memcmp( Header.Magic, Magic, sizeof(Magic) ) != 0 || Header.Version != CurrentVersion )
+	{
+		fprintf( stderr, "'%s' is not a packed depth file (or has an unsupported version).\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	if ( Header.FrameSize != (uint32_t)ExpectedFrameSize || (Header.FrameSize % sizeof(uint16_t)) != 0 )
+	{
+		fprintf( stderr, "Frames of '%s' do not have the requested size.\n", FileName.c_str() );
+		Close();
+		return false;
+	}
+
+	NumberOfValues = Header.FrameSize/sizeof(uint16_t);
+	PackedFrameSize = GetPackedDepthSize( NumberOfValues );
+
+	return true;
+}
+
+/** @brief Read packed frames in Packed.
+ *
+ * @param FirstFrame [in] Zero based index of the first frame.
+ * @param NumberOfFrames [in] Number of frames.
+ * @return True if all frames were read.
+ */
+bool PackedDepthFile::ReadPackedFrames( int64_t FirstFrame, int64_t NumberOfFrames )
+{
+	if ( IsOpen() == false || FirstFrame < 0 || NumberOfFrames < 0 )
+	{
+		return false;
+	}
+
+	size_t ReadSize = (size_t)NumberOfFrames*PackedFrameSize;
+	Packed.resize( ReadSize );
+
+	if ( ReadSize == 0 )
+	{
+		return true;
+	}
+
+	return (fIn.ReadAt( &Packed[0], ReadSize, (int64_t)sizeof(Header) + FirstFrame*(int64_t)PackedFrameSize ) == ReadSize);
+}
+
+/** @brief Read and unpack consecutive frames.
+ *
+ * @param FirstFrame [in] Zero based index of the first frame.
+ * @param NumberOfFrames [in] Number of frames.
+ * @param Output [out] Buffer of NumberOfFrames*FrameSize bytes.
+ * @return True if all frames were read.
+ */
+bool PackedDepthFile::ReadFrames( int64_t FirstFrame, int64_t NumberOfFrames, uint16_t * Output )
+{
+	if ( ReadPackedFrames( FirstFrame, NumberOfFrames ) == false )
+	{
+		return false;
+	}
+
+	// Each packed frame starts on a byte
+	for( int64_t i = 0; i < NumberOfFrames; i++ )
+	{
+		UnpackDepth( &Packed[(size_t)i*PackedFrameSize], NumberOfValues, Output + (size_t)i*NumberOfValues );
+	}
+
+	return true;
+}
+
+/** @brief Read and unpack consecutive frames to floats.
+ *
+ * @param FirstFrame [in] Zero based index of the first frame.
+ * @param NumberOfFrames [in] Number of frames.
+ * @param Output [out] Buffer of NumberOfFrames*FrameSize/2 floats.
+ * @param Scale [in] Scale of the values, 0.001 gives meters (default=1).
+ * @return True if all frames were read.
+ */
+bool PackedDepthFile::ReadFrames( int64_t FirstFrame, int64_t NumberOfFrames, float * Output, float Scale /* = 1.0f */ )
+{
+	if ( ReadPackedFrames( FirstFrame, NumberOfFrames ) == false )
+	{
+		return false;
+	}
+
+	for( int64_t i = 0; i < NumberOfFrames; i++ )
+	{
+		UnpackDepth( &Packed[(size_t)i*PackedFrameSize], NumberOfValues, Output + (size_t)i*NumberOfValues, Scale );
+	}
+
+	return true;
+}
+
+/** @brief Convert a depth raw file (usual or compressed with 7z) to a packed depth file.
+ *
+ * @param RawFileName [in] Name of the raw file.
+ * @param PackedFileName [in] Name of the packed depth file to create.
+ * @param FrameSize [in] Size of the frames (or subframes), 2 bytes per value.
+ * @return Number of converted frames or -1 if an error occured.
+ */
+long long int MobileRGBD::ConvertToPackedDepthFile( const string& RawFileName, const string& PackedFileName, int FrameSize )
+{
+	DataFile fRaw;
+	DataFile fOut;
+	PackedDepthFileHeader Header;
+	long long int NumberOfFrames = 0;
+
+	if ( FrameSize <= 0 || (FrameSize % sizeof(uint16_t)) != 0 || fRaw.Open( RawFileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return -1;
+	}
+
+	memset( &Header, 0, sizeof(Header) );
+	memcpy( Header.Magic, PackedDepthFile::Magic, sizeof(Header.Magic) );
+	Header.Version = PackedDepthFile::CurrentVersion;
+	Header.FrameSize = (uint32_t)FrameSize;
+
+	if ( fOut.Open( PackedFileName.c_str(), DataFile::WRITE_MODE ) == false || fOut.Write( &Header, sizeof(Header), 1 ) != 1 )
+	{
+		return -1;
+	}
+
+	size_t NumberOfValues = (size_t)FrameSize/sizeof(uint16_t);
+	vector<uint16_t> Frame( NumberOfValues );
+	vector<unsigned char> PackedFrame( GetPackedDepthSize( NumberOfValues ) );
+
+	while( fRaw.Read( &Frame[0], (size_t)FrameSize, 1 ) == 1 )
+	{
+		PackDepth( &Frame[0], NumberOfValues, &PackedFrame[0] );
+		if ( fOut.Write( &PackedFrame[0], PackedFrame.size(), 1 ) != 1 )
+		{
+			return -1;
+		}
+		NumberOfFrames++;
+	}
+
+	return NumberOfFrames;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file PackedDepthFile.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __PACKED_DEPTH_FILE_H__
+#define __PACKED_DEPTH_FILE_H__
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+
+#include "DataFile.h"
+
+namespace MobileRGBD {
+
+/** @brief Size of NumberOfValues depth values packed on 13 bits.
+ *
+ * @param NumberOfValues [in] Number of depth values.
+ */
+inline size_t GetPackedDepthSize( size_t NumberOfValues ) { return (NumberOfValues*13 + 7)/8; }
+
+/** @brief Pack depth values on 13 bits (least significant bits first). Kinect2 depth values are below 8192 mm,
+ *		   larger values are clamped to 8191.
+ *
+ * @param Depth [in] Depth values.
+ * @param NumberOfValues [in] Number of values.
+ * @param Packed [out] Packed values (GetPackedDepthSize(NumberOfValues) bytes).
+ */
+void PackDepth( const uint16_t * Depth, size_t NumberOfValues, unsigned char * Packed );
+
+/** @brief Unpack 13 bits depth values (SSE4.1 or AVX2 when the processor supports them).
+ *
+ * @param Packed [in] Packed values (GetPackedDepthSize(NumberOfValues) bytes).
+ * @param NumberOfValues [in] Number of values.
+ * @param Depth [out] Depth values.
+ */
+void UnpackDepth( const unsigned char * Packed, size_t NumberOfValues, uint16_t * Depth );
+
+/** @brief Unpack 13 bits depth values to floats (SSE4.1 or AVX2 when the processor supports them).
+ *
+ * @param Packed [in] Packed values (GetPackedDepthSize(NumberOfValues) bytes).
+ * @param NumberOfValues [in] Number of values.
+ * @param Depth [out] Depth values multiplied by Scale.
+ * @param Scale [in] Scale of the values, 0.001 gives meters (default=1).
+ */
+void UnpackDepth( const unsigned char * Packed, size_t NumberOfValues, float * Depth, float Scale = 1.0f );
+
+/** @brief Name of the unpacking code used on this processor ("avx2", "sse4.1" or "scalar").
+ */
+const char * GetUnpackDepthImplementation();
+
+/**
+ * @struct PackedDepthFileHeader PackedDepthFile.h
+ * @brief Header (16 bytes) at the beginning of a packed depth file, followed by the packed frames.
+ */
+struct PackedDepthFileHeader
+{
+	char Magic[8];					/*!< @brief Always "MRGBDP13". */
+	uint32_t Version;				/*!< @brief Version of the format (1). */
+	uint32_t FrameSize;				/*!< @brief Size of an unpacked frame (or subframe), 2 bytes per value. */
+};
+
+/**
+ * @class PackedDepthFile PackedDepthFile.cpp PackedDepthFile.h
+ * @brief Raw depth file where values are packed on 13 bits, i.e. 19% smaller than usual depth raw files.
+ *		  Packed frames keep the same size, a frame is still read at a computed position. Frames are
+ *		  unpacked while reading, directly in the buffer of the caller.
+ *		  ReadTimestampRawFile reads packed depth files transparently. They are created from
+ *		  a raw file using ConvertToPackedDepthFile.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class PackedDepthFile
+{
+public:
+	static const char Magic[8];				/*!< @brief Magic value at the beginning of the file ("MRGBDP13"). */
+	static const uint32_t CurrentVersion;	/*!< @brief Version of the format written by this code (1). */
+
+	/** @brief Constructor. No file is opened.
+	 */
+	PackedDepthFile();
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~PackedDepthFile() {}
+
+	/** @brief Check if a file is a packed depth file, i.e. starts with the magic value.
+	 *
+	 * @param FileName [in] Name of the file.
+	 */
+	static bool IsPackedDepthFile( const std::string& FileName );
+
+	/** @brief Open a packed depth file and check its header.
+	 *
+	 * @param FileName [in] Name of the packed depth file.
+	 * @param ExpectedFrameSize [in] Size of unpacked frames expected by the caller.
+	 * @return True if the file is opened.
+	 */
+	bool Open( const std::string& FileName, int ExpectedFrameSize );
+
+	/** @brief Close the file.
+	 */
+	void Close() { fIn.Close(); }
+
+	/** @brief Return true if the file is opened.
+	 */
+	bool IsOpen() { return fIn.IsOpen(); }
+
+	/** @brief Read and unpack consecutive frames.
+	 *
+	 * @param FirstFrame [in] Zero based index of the first frame.
+	 * @param NumberOfFrames [in] Number of frames.
+	 * @param Output [out] Buffer of NumberOfFrames*FrameSize bytes.
+	 * @return True if all frames were read.
+	 */
+	bool ReadFrames( int64_t FirstFrame, int64_t NumberOfFrames, uint16_t * Output );
+
+	/** @brief Read and unpack consecutive frames to floats.
+	 *
+	 * @param FirstFrame [in] Zero based index of the first frame.
+	 * @param NumberOfFrames [in] Number of frames.
+	 * @param Output [out] Buffer of NumberOfFrames*FrameSize/2 floats.
+	 * @param Scale [in] Scale of the values, 0.001 gives meters (default=1).
+	 * @return True if all frames were read.
+	 */
+	bool ReadFrames( int64_t FirstFrame, int64_t NumberOfFrames, float * Output, float Scale = 1.0f );
+
+	PackedDepthFileHeader Header;		/*!< @brief Header of the opened file. */
+
+protected:
+	/** @brief Read packed frames in Packed.
+	 *
+	 * @param FirstFrame [in] Zero based index of the first frame.
+	 * @param NumberOfFrames [in] Number of frames.
+	 * @return True if all frames were read.
+	 */
+	bool ReadPackedFrames( int64_t FirstFrame, int64_t NumberOfFrames );
+
+	DataFile fIn;							/*!< @brief The packed depth file. */
+	size_t NumberOfValues;					/*!< @brief Number of values in a frame. */
+	size_t PackedFrameSize;					/*!< @brief Size of a packed frame. */
+	std::vector<unsigned char> Packed;		/*!< @brief Buffer for packed frames. */
+};
+
+/** @brief Convert a depth raw file (usual or compressed with 7z) to a packed depth file.
+ *
+ * @param RawFileName [in] Name of the raw file.
+ * @param PackedFileName [in] Name of the packed depth file to create.
+ * @param FrameSize [in] Size of the frames (or subframes), 2 bytes per value.
+ * @return Number of converted frames or -1 if an error occured.
+ */
+long long int ConvertToPackedDepthFile( const std::string& RawFileName, const std::string& PackedFileName, int FrameSize );
+
+} // namespace MobileRGBD
+
+#endif // __PACKED_DEPTH_FILE_H__
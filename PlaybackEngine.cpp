@@ -0,0 +1,448 @@
+/**
+ * @file PlaybackEngine.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "PlaybackEngine.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+using namespace MobileRGBD;
+
+const unsigned int PlaybackEngine::DefaultQueueSize = 8;	/*!< @brief Default number of frames read in advance for each stream (8). */
+
+/** @brief Constructor.
+ *
+ * @param eQueueSize [in] Number of frames read in advance for each stream (default=DefaultQueueSize).
+ */
+PlaybackEngine::PlaybackEngine( unsigned int eQueueSize /* = DefaultQueueSize */ )
+{
+	MasterStream = 0;
+	QueueSize = eQueueSize > 0 ? eQueueSize : 1;
+	Pool = make_shared<FrameBufferPool>();
+	Playing = false;
+	Stopping = false;
+	NumberOfSleepers = 0;
+}
+
+/** @brief Virtual destructor, always. Stop the I/O threads.
+ */
+PlaybackEngine::~PlaybackEngine()
+{
+	Stop();
+}
+
+/** @brief Add a stream read by a PlaybackSource. Streams can not be added while playing.
+ *
+ * @param Source [in] Source of the frames, in time order.
+ * @param ToleranceInMs [in] Maximum distance between a frame of this stream and a master frame in tuples (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return Number of the stream.
+ */
+size_t PlaybackEngine::AddStream( const PlaybackSource& Source, unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	unique_ptr<StreamState> NewStream( new StreamState );
+
+	NewStream->Source = Source;
+	NewStream->ToleranceInNs = (int64_t)ToleranceInMs*HighResTimestamp::NanosecondsPerMillisecond;
+	NewStream->Queue.reset( new SPSCQueue<FrameView>( QueueSize ) );
+	NewStream->Ended = false;
+
+	Streams.push_back( move( NewStream ) );
+
+	return Streams.size()-1;
+}
+
+/** @brief Add a raw stream read with GetNextFrame (decimation, prefetching and decoding of the reader apply),
+ *		   starting after its current line. The reader is not owned by the engine, it must stay alive.
+ *
+ * @param Reader [in] Reader of the raw stream.
+ * @param ToleranceInMs [in] Maximum distance between a frame of this stream and a master frame in tuples (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return Number of the stream.
+ */
+size_t PlaybackEngine::AddRawStream( ReadTimestampRawFile * Reader, unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	shared_ptr<FrameBufferPool> FramePool = Pool;
+
+	return AddStream( [Reader, FramePool]( FrameView& View )
+	{
+		if ( Reader->GetNextFrame() == false )
+		{
+			return false;
+		}
+
+		View.FrameIndex = Reader->Index[(size_t)Reader->CurrentIndexEntry].FrameNumber - Reader->StartingFrame;
+		View.NumberOfSubFrames = Reader->NumberOfSubFrames;
+		View.Timestamp = Reader->CurrentHighResTimestamp;
+
+		size_t LoadSize = (size_t)Reader->FrameSize*(size_t)Reader->NumberOfSubFrames;
+
+		// Never empty, the view of a timestamp with empty data must be valid
+		shared_ptr< vector<unsigned char> > Buffer = FramePool->Acquire( LoadSize > 0 ? LoadSize : 1 );
+		if ( LoadSize > 0 )
+		{
+			// FrameData is reused by the next read
+			memcpy( &(*Buffer)[0], Reader->FrameData, LoadSize );
+		}
+
+		View.Data = &(*Buffer)[0];
+		View.Size = LoadSize;
+		View.Holder = Buffer;
+
+		return true;
+	}, ToleranceInMs );
+}
+
+/** @brief Add a timestamp file stream (robot, ...), starting after its current line. Views contain the data
+ *		   following the timestamp, as a C string. The reader is not owned by the engine, it must stay alive.
+ *
+ * @param Reader [in] Reader of the timestamp file.
+ * @param ToleranceInMs [in] Maximum distance between a line of this stream and a master frame in tuples (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return Number of the stream.
+ */
+size_t PlaybackEngine::AddTimestampStream( ReadTimestampFile * Reader, unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	shared_ptr<FrameBufferPool> FramePool = Pool;
+
+	return AddStream( [Reader, FramePool]( FrameView& View )
+	{
+		if ( Reader->BuildIndex() == false )
+		{
+			return false;
+		}
+
+		// The index tells where the file ends, GetNextTimestamp keeps the last line
+		int Entry = 0;
+		if ( Reader->CurrentTimestampIsInitialized == true && Reader->CurrentIndexEntry >= 0 )
+		{
+			Entry = Reader->CurrentIndexEntry+1;
+		}
+		if ( Entry >= (int)Reader->Index.Size() || Reader->GoToIndexEntry( Entry ) == false )
+		{
+			return false;
+		}
+
+		const char * Data = &Reader->LineBuffer[Reader->EndOfTimestampPosition];
+		size_t DataSize = strlen( Data );
+
+		shared_ptr< vector<unsigned char> > Buffer = FramePool->Acquire( DataSize+1 );
+		memcpy( &(*Buffer)[0], Data, DataSize+1 );
+
+		View.FrameIndex = Entry;
+		View.NumberOfSubFrames = 1;
+		View.Timestamp = Reader->CurrentHighResTimestamp;
+		View.Data = &(*Buffer)[0];
+		View.Size = DataSize;
+		View.Holder = Buffer;
+
+		return true;
+	}, ToleranceInMs );
+}
+
+/** @brief Select the stream giving the timestamps of the tuples (see GetNextTuple).
+ *
+ * @param Stream [in] Number of the stream.
+ * @return True if the stream exists.
+ */
+bool PlaybackEngine::SetMasterStream( size_t Stream )
+{
+	if ( Stream >= Streams.size() )
+	{
+		return false;
+	}
+
+	MasterStream = Stream;
+	return true;
+}
+
+/** @brief Start the I/O threads.
+ *
+ * @return False if there is no stream or if the engine is already playing.
+ */
+bool PlaybackEngine::Start()
+{
+	if ( Playing == true || Streams.empty() )
+	{
+		return false;
+	}
+
+	Stopping = false;
+	for( size_t i = 0; i < Streams.size(); i++ )
+	{
+		StreamState& Stream = *Streams[i];
+
+		Stream.Ended = false;
+		Stream.Current.Reset();
+		Stream.IOThread = thread( &PlaybackEngine::Run, this, ref( Stream ) );
+	}
+
+	Playing = true;
+	return true;
+}
+
+/** @brief Stop the I/O threads (even if they wait for room in their queue) and drop frames read in
+ *		   advance. Called by the consumer, streams can then be played again (dropped frames are not played).
+ */
+void PlaybackEngine::Stop()
+{
+	if ( Playing == false )
+	{
+		return;
+	}
+
+	Stopping = true;
+	{
+		lock_guard<mutex> Lock( Protect );
+	}
+	Changed.notify_all();
+
+	for( size_t i = 0; i < Streams.size(); i++ )
+	{
+		StreamState& Stream = *Streams[i];
+		FrameView Dropped;
+
+		if ( Stream.IOThread.joinable() )
+		{
+			Stream.IOThread.join();
+		}
+
+		while( Stream.Queue->Pop( Dropped ) == true );
+		Stream.Current.Reset();
+	}
+
+	Playing = false;
+}
+
+/** @brief Get the next frame of all streams in time order (frames with the same timestamp in stream order).
+ *
+ * @param NextEvent [out] The frame.
+ * @return False at the end of all streams.
+ */
+bool PlaybackEngine::GetNextEvent( Event& NextEvent )
+{
+	size_t i;
+	int First = -1;
+
+	NextEvent.View.Reset();
+
+	if ( Playing == false )
+	{
+		return false;
+	}
+
+	// Each stream gives its next frame, the oldest one is the next event
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		StreamState& Stream = *Streams[i];
+
+		if ( Stream.Current.IsValid() == false )
+		{
+			FrameView * Next = WaitForFrame( Stream );
+			if ( Next == nullptr )
+			{
+				continue;
+			}
+			Stream.Queue->Pop( Stream.Current );
+			Notify();
+		}
+
+		if ( First < 0 || Stream.Current.Timestamp < Streams[(size_t)First]->Current.Timestamp )
+		{
+			First = (int)i;
+		}
+	}
+
+	if ( First < 0 )
+	{
+		return false;
+	}
+
+	NextEvent.Stream = (size_t)First;
+	NextEvent.View = move( Streams[(size_t)First]->Current );
+	Streams[(size_t)First]->Current.Reset();
+
+	return true;
+}
+
+/** @brief Get the next frame of the master stream and the nearest frame of each other stream.
+ *
+ * @param Frames [out] Frame of each stream, an empty view if no frame is within the tolerance of the stream.
+ * @param SkipIncomplete [in] Skip master frames without a frame of each stream (default=true).
+ * @return False at the end of the master stream.
+ */
+bool PlaybackEngine::GetNextTuple( vector<FrameView>& Frames, bool SkipIncomplete /* = true */ )
+{
+	size_t i;
+
+	Frames.assign( Streams.size(), FrameView() );
+
+	if ( Playing == false )
+	{
+		return false;
+	}
+
+	StreamState& Master = *Streams[MasterStream];
+
+	for(;;)
+	{
+		bool Complete = true;
+
+		if ( WaitForFrame( Master ) == nullptr )
+		{
+			return false;
+		}
+		Master.Queue->Pop( Frames[MasterStream] );
+		Notify();
+
+		const HighResTimestamp& MasterTimestamp = Frames[MasterStream].Timestamp;
+
+		for( i = 0; i < Streams.size(); i++ )
+		{
+			StreamState& Stream = *Streams[i];
+
+			if ( i == MasterStream )
+			{
+				continue;
+			}
+
+			// Frames are in time order, move forward while the next frame is nearer (the first one on a tie, like Synchronizer)
+			for(;;)
+			{
+				if ( Stream.Current.IsValid() == true && Stream.Current.Timestamp >= MasterTimestamp )
+				{
+					break;
+				}
+
+				FrameView * Next = WaitForFrame( Stream );
+				if ( Next == nullptr )
+				{
+					break;
+				}
+
+				if ( Stream.Current.IsValid() == true && llabs( Next->Timestamp - MasterTimestamp ) >= llabs( Stream.Current.Timestamp - MasterTimestamp ) )
+				{
+					break;
+				}
+
+				Stream.Queue->Pop( Stream.Current );
+				Notify();
+			}
+
+			if ( Stream.Current.IsValid() == true && llabs( Stream.Current.Timestamp - MasterTimestamp ) <= Stream.ToleranceInNs )
+			{
+				Frames[i] = Stream.Current;
+			}
+			else
+			{
+				Complete = false;
+			}
+		}
+
+		if ( Complete == true || SkipIncomplete == false )
+		{
+			return true;
+		}
+
+		Frames.assign( Streams.size(), FrameView() );
+	}
+}
+
+/** @brief Main loop of the I/O thread of a stream.
+ *
+ * @param Stream [in] The stream.
+ */
+void PlaybackEngine::Run( StreamState& Stream )
+{
+	while( Stopping == false )
+	{
+		FrameView View;
+
+		if ( Stream.Source( View ) == false )
+		{
+			break;
+		}
+
+		// Backpressure, the consumer is late
+		Wait( [&Stream]() { return Stream.Queue->IsFull() == false; } );
+		if ( Stopping == true )
+		{
+			break;
+		}
+
+		Stream.Queue->Push( View );
+		Notify();
+	}
+
+	Stream.Ended = true;
+	Notify();
+}
+
+/** @brief Wait until a frame is in the queue of a stream or the stream ended. Consumer side.
+ *
+ * @param Stream [in] The stream.
+ * @return A pointer on the next frame of the queue, nullptr at the end of the stream.
+ */
+FrameView * PlaybackEngine::WaitForFrame( StreamState& Stream )
+{
+	FrameView * Next = Stream.Queue->Front();
+	if ( Next != nullptr )
+	{
+		return Next;
+	}
+
+	Wait( [&Stream]() { return Stream.Queue->IsEmpty() == false || Stream.Ended == true; } );
+
+	if ( Stopping == true )
+	{
+		return nullptr;
+	}
+
+	// Frames are pushed before the end of the stream
+	return Stream.Queue->Front();
+}
+
+/** @brief Wait for a condition changed by another thread, or for Stop.
+ *
+ * @param IsReady [in] The condition.
+ */
+void PlaybackEngine::Wait( const function<bool()>& IsReady )
+{
+	if ( IsReady() == true )
+	{
+		return;
+	}
+
+	// Registered before checking again, Notify can not miss us
+	NumberOfSleepers++;
+	atomic_thread_fence( memory_order_seq_cst );
+
+	{
+		unique_lock<mutex> Lock( Protect );
+		while( IsReady() == false && Stopping == false )
+		{
+			Changed.wait( Lock );
+		}
+	}
+
+	NumberOfSleepers--;
+}
+
+/** @brief Wake up threads waiting in Wait. Nothing is done if no thread waits.
+ */
+void PlaybackEngine::Notify()
+{
+	atomic_thread_fence( memory_order_seq_cst );
+	if ( NumberOfSleepers == 0 )
+	{
+		return;
+	}
+
+	// A thread between its check and its wait holds the mutex
+	{
+		lock_guard<mutex> Lock( Protect );
+	}
+	Changed.notify_all();
+}
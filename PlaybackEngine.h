@@ -0,0 +1,216 @@
+/**
+ * @file PlaybackEngine.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __PLAYBACK_ENGINE_H__
+#define __PLAYBACK_ENGINE_H__
+
+#include <inttypes.h>
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+#include "FrameView.h"
+#include "FrameBufferPool.h"
+#include "SPSCQueue.h"
+#include "ReadTimestampFile.h"
+#include "ReadTimestampRawFile.h"
+
+namespace MobileRGBD {
+
+/** @brief Produce the next frame of a stream (see PlaybackEngine::AddStream). The view must have a timestamp
+ *		   and own its data (Holder). Called by the I/O thread of the stream only.
+ *
+ * @return False at the end of the stream (or on error).
+ */
+typedef std::function<bool( FrameView& View )> PlaybackSource;
+
+/**
+ * @class PlaybackEngine PlaybackEngine.cpp PlaybackEngine.h
+ * @brief Play several streams of a session in parallel. Each stream is read by its own I/O thread
+ *		  (reading, decompressing, decoding) which pushes ready frames in a bounded lock-free queue. When the queue
+ *		  is full, the I/O thread waits for the consumer (backpressure). The consumer merges the queues
+ *		  like Synchronizer:
+ *		  - GetNextEvent gives the frames of all streams in time order.
+ *		  - GetNextTuple gives, for each frame of a master stream, the nearest frame of each other stream within
+ *		    its tolerance.
+ *		  Only one of them must be used during a playback.
+ *		  Frames are copied in buffers of a pool, views stay valid as long as the consumer keeps them.
+ *		  Readers must not be used between Start and Stop. Other sources (VideoIO, ...) are added with a
+ *		  PlaybackSource. Example:
+ *		  @code
+		  PlaybackEngine Engine;
+		  size_t DepthStream = Engine.AddRawStream( &Depth );
+		  Engine.AddRawStream( &Color );
+		  Engine.AddTimestampStream( &Bodies, 50 );
+		  Engine.AddStream( [&Video, &VideoTimestamps]( FrameView& View ) { return ReadVideoFrame( Video, VideoTimestamps, View ); } );
+		  Engine.SetMasterStream( DepthStream );
+		  Engine.Start();
+
+		  std::vector<FrameView> Frames;
+		  while( Engine.GetNextTuple( Frames ) )
+		  {
+			  Process( Frames );
+		  }
+		  Engine.Stop();
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class PlaybackEngine
+{
+public:
+	static const unsigned int DefaultQueueSize;		/*!< @brief Default number of frames read in advance for each stream (8). */
+
+	/**
+	 * @struct PlaybackEngine::Event PlaybackEngine.h
+	 * @brief A frame of a stream (see GetNextEvent).
+	 */
+	struct Event
+	{
+		size_t Stream;						/*!< @brief Stream of the frame (as returned by AddStream). */
+		FrameView View;						/*!< @brief The frame and its timestamp. */
+	};
+
+	/** @brief Constructor.
+	 *
+	 * @param eQueueSize [in] Number of frames read in advance for each stream (default=DefaultQueueSize).
+	 */
+	PlaybackEngine( unsigned int eQueueSize = DefaultQueueSize );
+
+	/** @brief Virtual destructor, always. Stop the I/O threads.
+	 */
+	virtual ~PlaybackEngine();
+
+	/** @brief Add a stream read by a PlaybackSource. Streams can not be added while playing.
+	 *
+	 * @param Source [in] Source of the frames, in time order.
+	 * @param ToleranceInMs [in] Maximum distance between a frame of this stream and a master frame in tuples (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return Number of the stream.
+	 */
+	size_t AddStream( const PlaybackSource& Source, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
+	/** @brief Add a raw stream read with GetNextFrame (decimation, prefetching and decoding of the reader apply),
+	 *		   starting after its current line. The reader is not owned by the engine, it must stay alive.
+	 *
+	 * @param Reader [in] Reader of the raw stream.
+	 * @param ToleranceInMs [in] Maximum distance between a frame of this stream and a master frame in tuples (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return Number of the stream.
+	 */
+	size_t AddRawStream( ReadTimestampRawFile * Reader, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
+	/** @brief Add a timestamp file stream (robot, ...), starting after its current line. Views contain the data
+	 *		   following the timestamp, as a C string. The reader is not owned by the engine, it must stay alive.
+	 *
+	 * @param Reader [in] Reader of the timestamp file.
+	 * @param ToleranceInMs [in] Maximum distance between a line of this stream and a master frame in tuples (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return Number of the stream.
+	 */
+	size_t AddTimestampStream( ReadTimestampFile * Reader, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
+	/** @brief Number of streams.
+	 */
+	size_t GetNumberOfStreams() const { return Streams.size(); }
+
+	/** @brief Select the stream giving the timestamps of the tuples (see GetNextTuple).
+	 *
+	 * @param Stream [in] Number of the stream.
+	 * @return True if the stream exists.
+	 */
+	bool SetMasterStream( size_t Stream );
+
+	/** @brief Get the stream giving the timestamps of the tuples.
+	 */
+	size_t GetMasterStream() const { return MasterStream; }
+
+	/** @brief Start the I/O threads.
+	 *
+	 * @return False if there is no stream or if the engine is already playing.
+	 */
+	bool Start();
+
+	/** @brief Stop the I/O threads (even if they wait for room in their queue) and drop frames read in
+	 *		   advance. Called by the consumer, streams can then be played again (dropped frames are not played).
+	 */
+	void Stop();
+
+	/** @brief Return true if the I/O threads are started.
+	 */
+	bool IsPlaying() const { return Playing; }
+
+	/** @brief Get the next frame of all streams in time order (frames with the same timestamp in stream order).
+	 *
+	 * @param NextEvent [out] The frame.
+	 * @return False at the end of all streams.
+	 */
+	bool GetNextEvent( Event& NextEvent );
+
+	/** @brief Get the next frame of the master stream and the nearest frame of each other stream.
+	 *
+	 * @param Frames [out] Frame of each stream, an empty view if no frame is within the tolerance of the stream.
+	 * @param SkipIncomplete [in] Skip master frames without a frame of each stream (default=true).
+	 * @return False at the end of the master stream.
+	 */
+	bool GetNextTuple( std::vector<FrameView>& Frames, bool SkipIncomplete = true );
+
+protected:
+	/**
+	 * @struct PlaybackEngine::StreamState PlaybackEngine.h
+	 * @brief A stream, its I/O thread and its queue.
+	 */
+	struct StreamState
+	{
+		PlaybackSource Source;						/*!< @brief Source of the frames. */
+		int64_t ToleranceInNs;						/*!< @brief Maximum distance to the master frame in tuples. */
+		std::unique_ptr< SPSCQueue<FrameView> > Queue;	/*!< @brief Frames read in advance. */
+		std::atomic<bool> Ended;					/*!< @brief The I/O thread pushed its last frame. */
+		std::thread IOThread;						/*!< @brief The I/O thread. */
+		FrameView Current;							/*!< @brief Frame taken from the queue by the consumer but not given yet (or nearest frame of the last tuple). */
+	};
+
+	/** @brief Main loop of the I/O thread of a stream.
+	 *
+	 * @param Stream [in] The stream.
+	 */
+	void Run( StreamState& Stream );
+
+	/** @brief Wait until a frame is in the queue of a stream or the stream ended. Consumer side.
+	 *
+	 * @param Stream [in] The stream.
+	 * @return A pointer on the next frame of the queue, nullptr at the end of the stream.
+	 */
+	FrameView * WaitForFrame( StreamState& Stream );
+
+	/** @brief Wait for a condition changed by another thread, or for Stop.
+	 *
+	 * @param IsReady [in] The condition.
+	 */
+	void Wait( const std::function<bool()>& IsReady );
+
+	/** @brief Wake up threads waiting in Wait. Nothing is done if no thread waits.
+	 */
+	void Notify();
+
+	std::vector< std::unique_ptr<StreamState> > Streams;	/*!< @brief Streams to play. */
+	size_t MasterStream;						/*!< @brief Stream giving the timestamps of the tuples. */
+	unsigned int QueueSize;						/*!< @brief Number of frames read in advance for each stream. */
+	std::shared_ptr<FrameBufferPool> Pool;		/*!< @brief Buffers of the frames of readers. */
+	bool Playing;								/*!< @brief I/O threads are started. */
+
+	std::atomic<bool> Stopping;					/*!< @brief Ask I/O threads and the consumer to stop. */
+	std::atomic<int> NumberOfSleepers;			/*!< @brief Number of threads waiting in Wait. */
+	std::mutex Protect;							/*!< @brief Protect sleeping in Wait. */
+	std::condition_variable Changed;			/*!< @brief Signal queue changes (or stop) to waiting threads. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __PLAYBACK_ENGINE_H__
@@ -0,0 +1,117 @@
+/**
+ * @file RawFrameFormat.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __RAW_FRAME_FORMAT_H__
+#define __RAW_FRAME_FORMAT_H__
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include <type_traits>
+
+namespace MobileRGBD {
+
+/**
+ * @struct RawFrameFormat RawFrameFormat.h
+ * @brief Compile time description of the frames of a raw file: type of the values, size and layout
+ *		  (rows of interleaved channels). All sizes and offsets are constant expressions.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<typename Element, int eWidth, int eHeight, int eChannels, bool eSubFrames = false>
+struct RawFrameFormat
+{
+	typedef Element ElementType;												/*!< @brief Type of each value. */
+
+	static constexpr int Width = eWidth;										/*!< @brief Width of the frames. */
+	static constexpr int Height = eHeight;										/*!< @brief Height of the frames. */
+	static constexpr int Channels = eChannels;									/*!< @brief Number of values per pixel. */
+	static constexpr int NumberOfValues = eWidth*eHeight*eChannels;				/*!< @brief Number of values in a frame (or subframe). */
+	static constexpr int FrameSize = NumberOfValues*(int)sizeof(Element);		/*!< @brief Size of a frame (or subframe) in bytes. */
+	static constexpr bool IsSubFrames = eSubFrames;								/*!< @brief Timestamps own several subframes (see ReadTimestampRawFile::SubFramesMode). */
+
+	/** @brief Offset of a value in a frame (in number of values).
+	 *
+	 * @param x [in] Column.
+	 * @param y [in] Row.
+	 * @param Channel [in] Channel (default=0).
+	 */
+	static constexpr size_t Offset( int x, int y, int Channel = 0 ) { return ((size_t)y*(size_t)eWidth + (size_t)x)*(size_t)eChannels + (size_t)Channel; }
+};
+
+/**
+ * @struct Kinect2DepthFormat RawFrameFormat.h
+ * @brief Kinect2 depth frames: 512x424 distances in millimeters (16 bits).
+ */
+struct Kinect2DepthFormat : public RawFrameFormat<uint16_t, 512, 424, 1> {};
+
+/**
+ * @struct Kinect2InfraredFormat RawFrameFormat.h
+ * @brief Kinect2 infrared frames: 512x424 intensities (16 bits).
+ */
+struct Kinect2InfraredFormat : public RawFrameFormat<uint16_t, 512, 424, 1> {};
+
+/**
+ * @struct Kinect2ColorFormat RawFrameFormat.h
+ * @brief Kinect2 color frames: 1920x1080 BGRA pixels.
+ */
+struct Kinect2ColorFormat : public RawFrameFormat<uint8_t, 1920, 1080, 4> {};
+
+/**
+ * @struct SubFrameRecordFormat RawFrameFormat.h
+ * @brief Subframes streams (Kinect2 bodies, faces, ...): each subframe is a plain Record structure, as
+ *		  written by the recorder.
+ */
+template<typename Record>
+struct SubFrameRecordFormat : public RawFrameFormat<Record, 1, 1, 1, true> {};
+
+/** @brief Convert a Kinect2 depth frame to distances in meters. The number of values is a compile time
+ *		   constant, the loop is vectorized by the compiler.
+ *
+ * @param Depth [in] Depth frame (millimeters).
+ * @param Meters [out] Distances in meters (Format::NumberOfValues values, must not overlap Depth).
+ */
+template<typename Format>
+inline void ConvertDepthToMeters( const typename Format::ElementType * __restrict Depth, float * __restrict Meters )
+{
+	static_assert( std::is_same<typename Format::ElementType, uint16_t>::value, "Depth values must be 16 bits" );
+
+	for( int i = 0; i < Format::NumberOfValues; i++ )
+	{
+		Meters[i] = (float)Depth[i]*0.001f;
+	}
+}
+
+/** @brief Normalize a Kinect2 infrared frame in [MinimumValue, 1] for display, like the Kinect SDK samples:
+ *		   intensities are divided by the average intensity of a scene times a number of standard deviations.
+ *
+ * @param Infrared [in] Infrared frame.
+ * @param Normalized [out] Normalized intensities (Format::NumberOfValues values, must not overlap Infrared).
+ * @param SceneAverage [in] Average intensity of a scene, relative to the maximum value (default=0.08).
+ * @param StandardDeviations [in] Number of standard deviations mapped to 1 (default=3).
+ * @param MinimumValue [in] Minimum output value, black pixels stay visible (default=0.01).
+ */
+template<typename Format>
+inline void NormalizeInfrared( const typename Format::ElementType * __restrict Infrared, float * __restrict Normalized,
+	float SceneAverage = 0.08f, float StandardDeviations = 3.0f, float MinimumValue = 0.01f )
+{
+	static_assert( std::is_same<typename Format::ElementType, uint16_t>::value, "Infrared values must be 16 bits" );
+
+	const float Scale = 1.0f/(65535.0f*SceneAverage*StandardDeviations);
+
+	for( int i = 0; i < Format::NumberOfValues; i++ )
+	{
+		// Branchless clamping
+		float Value = (float)Infrared[i]*Scale;
+		Value = Value < MinimumValue ? MinimumValue : Value;
+		Normalized[i] = Value > 1.0f ? 1.0f : Value;
+	}
+}
+
+} // namespace MobileRGBD
+
+#endif // __RAW_FRAME_FORMAT_H__
@@ -12,6 +12,8 @@ using namespace MobileRGBD;
 
 const size_t ReadTimestamp::DefaultLineBufferSize =  10*1024*1024;		/*!< @brief Default buffer size for line reading (default 10MiB) */
 const unsigned short int ReadTimestamp::DefaultValidityTimeInMs = 33;	/*!< @brief When searching for a specified timestamp, DefaultValidityTimeInMs specifies a threshold to for validity (33ms). */
+const unsigned short int ReadTimestamp::EndOfFileValidityTimeInMs = 100;	/*!< @brief When searching after the last timestamp of the file, last data is considered as valid during EndOfFileValidityTimeInMs (100ms). */
+const unsigned int ReadTimestamp::DefaultFollowTimeoutInMs = 100;		/*!< @brief In follow mode, default maximum waiting time for new data (100ms). */
 
 /** @brief Constructor. Create a ReadTimeStamp object using specific file.
  *
@@ -27,6 +29,12 @@ ReadTimestamp::ReadTimestamp( const string& FileName, size_t SizeOfLineBuffer /*
 	CurrentTimestamp.millitm = 0;
 	CurrentTimestamp.timezone = 0;
 	CurrentTimestampIsInitialized = false;
+	CurrentIndexEntry = -1;
+	InterpolationEntry = -1;
+	InterpolationAlpha = 0.0f;
+	FollowMode = false;
+	FollowTimeoutInMs = DefaultFollowTimeoutInMs;
+	FileIsCompressed = false;
 
 	PreviousTimestampPosInFile[0] = -1;
 	PreviousTimestampPosInFile[1] = -1;
@@ -60,11 +68,20 @@ void ReadTimestamp::Reinit()
 #ifdef DEBUG
 		// fprintf( stderr, "Try to open '%s'\n", FiletoOpen.c_str() );
 #endif
-		fin.Open( FiletoOpen.c_str(), DataFile::READ_MODE );
+		if ( FileIsCompressed == true )
+		{
+			// Known to be compressed, no failed opening of the usual file
+			fin.OpenCompressedVersion( FiletoOpen.c_str(), DataFile::READ_MODE );
+		}
+		else
+		{
+			fin.Open( FiletoOpen.c_str(), DataFile::READ_MODE );
+		}
 	}
 	else
 	{
-		fseek( fin, 0, SEEK_SET );
+		// Works also for pipes (reopened)
+		fin.Rewind();
 	}
 	PreviousTimestampPosInFile[0] = -1;
 	PreviousTimestampPosInFile[1] = -1;
@@ -73,6 +90,8 @@ void ReadTimestamp::Reinit()
 	CurrentTimestamp.millitm = 0;
 	CurrentTimestamp.timezone = 0;
 	CurrentTimestampIsInitialized = false;
+	CurrentIndexEntry = -1;
+	InterpolationEntry = -1;
 }
 
 /** @brief Close file.
@@ -126,9 +145,19 @@ bool ReadTimestamp::SearchDataForTimestamp(const TimeB &RequestedTimestamp, unsi
 		// Requested time stamp is in future
 		if ( Comp > 0 )
 		{
+			if ( FollowMode == true )
+			{
+				// Wait for next lines, if none came, we are at the end of the file for now
+				if ( GetNextTimestamp() == false )
+				{
+					return (Comp <= (int)EndOfFileValidityTimeInMs);
+				}
+				continue;
+			}
+
 			if ( fin != nullptr && feof(fin) )
 			{
-				return (CurrentTimestampIsInitialized && Comp <= 100);	// let's say that if last data is older taht 100ms, we did not take care of it anymore
+				return (CurrentTimestampIsInitialized && Comp <= (int)EndOfFileValidityTimeInMs);	// let's say that if last data is older than 100ms, we did not take care of it anymore
 			}
 
 			// Cancel current result
@@ -200,25 +229,59 @@ bool ReadTimestamp::GetNextTimestamp()
 		return false;
 	}
 
-	if ( feof(fin) )
+	if ( FollowMode == false && feof(fin) )
 	{
 		// return last value or none
 		return CurrentTimestampIsInitialized;
 	}
+
+	chrono::steady_clock::time_point Deadline = chrono::steady_clock::now() + chrono::milliseconds(FollowTimeoutInMs);
 	
-	while( !feof(fin) )
+	while( FollowMode == true || !feof(fin) )
 	{
-		int iTmp;
 		int length = 0;
-		TimeB lTimestamp;
+		HighResTimestamp lTimestamp;
+		long int SavedTimestampPosInFile[2] = { PreviousTimestampPosInFile[0], PreviousTimestampPosInFile[1] };
 
 		// Remember where I am
 		AddTimestampPos();
 
 		// try to read a line
-		if ( fgets( LineBuffer, LineBufferSize-1, fin ) == (char*)NULL )
+		if ( fin.ReadLine( LineBuffer, LineBufferSize-1 ) == (char*)NULL || (FollowMode == true && IsLineComplete() == false) )
 		{
-			break;
+			if ( FollowMode == false )
+			{
+				break;
+			}
+
+			// End of file for now, come back at the beginning of the line (clear end of file flag)
+			SeekInFile( PreviousTimestampPosInFile[1] );
+			PreviousTimestampPosInFile[0] = SavedTimestampPosInFile[0];
+			PreviousTimestampPosInFile[1] = SavedTimestampPosInFile[1];
+
+			// Wait for the recorder
+			if ( Watcher.WaitForChange( Deadline ) == true )
+			{
+				continue;
+			}
+
+			// Nothing new, restore current line as it was before the call
+			int64_t NextLinePosition = fin.Tell();
+			LineBuffer[0] = '\0';
+			if ( CurrentTimestampIsInitialized == true && PreviousTimestampPosInFile[1] != -1 && SeekInFile( PreviousTimestampPosInFile[1] ) == true )
+			{
+				fin.ReadLine( LineBuffer, LineBufferSize-1 );
+			}
+			SeekInFile( NextLinePosition );
+
+			return false;
+		}
+
+		// In follow mode, add new lines to the index
+		bool NewLineToIndex = (FollowMode == true && Index.IsEmpty() == false && (int64_t)PreviousTimestampPosInFile[1] == Index.IndexedSize);
+		if ( NewLineToIndex == true )
+		{
+			Index.IndexedSize = fin.Tell();
 		}
 
 		// Ok, we have a line, remeber CurrentTimestamp
@@ -227,18 +290,33 @@ bool ReadTimestamp::GetNextTimestamp()
 		PreviousTimestamp.timezone = CurrentTimestamp.timezone;
 
 		// try to parse line
-		if ( sscanf( LineBuffer, "%d.%hu%*[ \t]%n", &iTmp, &lTimestamp.millitm, &length ) != 2 )
+		if ( HighResTimestamp::Parse( LineBuffer, lTimestamp, length ) == false )
 		{
 			continue;
 		}
-		lTimestamp.time = iTmp;
 
 		// Copy data to internal 
-		CurrentTimestamp = lTimestamp;
+		CurrentHighResTimestamp = lTimestamp;
+		CurrentTimestamp = lTimestamp.ToTimeB();
 		EndOfTimestampPosition = length;
 
 		CurrentTimestampIsInitialized = true;
 
+		// Keep track of the entry in the index if any
+		if ( NewLineToIndex == true )
+		{
+			TimestampIndexEntry NewEntry;
+			NewEntry.Timestamp = lTimestamp;
+			NewEntry.Position = (int64_t)PreviousTimestampPosInFile[1];
+			TimestampIndex::ParseFrameFields( &LineBuffer[length], NewEntry );
+			Index.Append( NewEntry );
+			CurrentIndexEntry = (int)Index.Size()-1;
+		}
+		else if ( Index.IsEmpty() == false )
+		{
+			CurrentIndexEntry = Index.FindPosition( PreviousTimestampPosInFile[1], CurrentIndexEntry+1 );
+		}
+
 		return true;
 	}
 	
@@ -259,7 +337,7 @@ bool ReadTimestamp::Rewind()
 	{
 		if ( PreviousTimestampPosInFile[0] != -1 )
 		{
-			fseek( fin, PreviousTimestampPosInFile[0], SEEK_SET );
+			SeekInFile( PreviousTimestampPosInFile[0] );
 			PreviousTimestampPosInFile[0] = -1;
 			PreviousTimestampPosInFile[1] = -1;
 
@@ -273,3 +351,349 @@ bool ReadTimestamp::Rewind()
 	return false;
 }
 
+
+/** @brief Set position in the timestamp file, reopening it if needed (backward seek in pipes).
+ *
+ * @param Position [in] New position in the file.
+ * @return True if the position has been set.
+ */
+bool ReadTimestamp::SeekInFile( int64_t Position )
+{
+	if ( fin.Seek( Position, SEEK_SET ) == 0 )
+	{
+		return true;
+	}
+
+	// We can not go backward in pipes, restart from the beginning
+	fin.Rewind();
+	return (fin.Seek( Position, SEEK_SET ) == 0);
+}
+
+/** @brief Build the index of the timestamp file if not already done.
+ *
+ * @param NumberOfThreads [in] Maximum number of threads parsing a usual file, 0 for the number of hardware threads (default=1).
+ * @return True if the index is available.
+ */
+bool ReadTimestamp::BuildIndex( unsigned int NumberOfThreads /* = 1 */ )
+{
+	if ( Index.IsEmpty() == false )
+	{
+		return true;
+	}
+
+	// Use saved index if any, or parse the whole file (only complete lines if the file is being recorded)
+	if ( LoadIndex() == false )
+	{
+		if ( Index.Build( FiletoOpen, (size_t)LineBufferSize, NumberOfThreads, FollowMode ) == false )
+		{
+			return false;
+		}
+		UpdateCurrentIndexEntry();
+	}
+
+	return (Index.IsEmpty() == false);
+}
+
+/** @brief Index the lines appended to the file since the index was built (see BuildIndex).
+ *
+ * @return True if new lines were indexed.
+ */
+bool ReadTimestamp::UpdateIndex()
+{
+	if ( Index.IsEmpty() == true )
+	{
+		return BuildIndex();
+	}
+
+	return Index.Update( FiletoOpen, (size_t)LineBufferSize );
+}
+
+/** @brief In follow mode, update the index until it contains RequestedTimestamp, waiting for new
+ *		   lines at most FollowTimeoutInMs.
+ *
+ * @param RequestedTimestamp [in] Timestamp expected in the file.
+ * @return True if the last entry of the index is at or after RequestedTimestamp.
+ */
+bool ReadTimestamp::FollowIndex( const HighResTimestamp &RequestedTimestamp )
+{
+	chrono::steady_clock::time_point Deadline = chrono::steady_clock::now() + chrono::milliseconds(FollowTimeoutInMs);
+
+	UpdateIndex();
+	while( Index.IsEmpty() == true || Index[Index.Size()-1].Timestamp < RequestedTimestamp )
+	{
+		if ( Watcher.WaitForChange( Deadline ) == false )
+		{
+			return false;
+		}
+		UpdateIndex();
+	}
+
+	return true;
+}
+
+/** @brief Set follow mode, i.e. read a file while it is still being recorded. In follow mode,
+ *		   end of file is not final: reading and searching functions wait at most TimeoutInMs
+ *		   for new complete lines and the index is updated with them. Only usual files can be followed.
+ *
+ * @param Follow [in] Activate or deactivate follow mode.
+ * @param TimeoutInMs [in] Maximum waiting time for new data in each call (default=DefaultFollowTimeoutInMs).
+ * @return True if the mode has been set.
+ */
+bool ReadTimestamp::SetFollowMode( bool Follow, unsigned int TimeoutInMs /* = DefaultFollowTimeoutInMs */ )
+{
+	FollowMode = false;
+	Watcher.Stop();
+
+	if ( Follow == false )
+	{
+		return true;
+	}
+
+	if ( fin == (FILE*)NULL )
+	{
+		Reinit();
+	}
+
+	if ( fin == (FILE*)NULL || fin.IsPipeOpened() == true )
+	{
+		fprintf( stderr, "Only usual files can be followed ('%s').\n", FiletoOpen.c_str() );
+		return false;
+	}
+
+	// Last line of the current index may be incomplete, it will be rebuilt
+	Index.Clear();
+	CurrentIndexEntry = -1;
+
+	FollowTimeoutInMs = TimeoutInMs;
+	FollowMode = true;
+
+	return Watcher.Watch( FiletoOpen );
+}
+
+/** @brief Retrieve the index entry of the current line after a change of the index.
+ */
+void ReadTimestamp::UpdateCurrentIndexEntry()
+{
+	CurrentIndexEntry = -1;
+
+	if ( CurrentTimestampIsInitialized == true )
+	{
+		CurrentIndexEntry = Index.FindPosition( PreviousTimestampPosInFile[1] );
+	}
+}
+
+/** @brief Save the index next to the timestamp file (TimestampIndex::DefaultIndexFileName). Build it if needed.
+ *
+ * @return True if the index has been saved.
+ */
+bool ReadTimestamp::SaveIndex()
+{
+	if ( BuildIndex() == false )
+	{
+		return false;
+	}
+
+	return Index.Save( TimestampIndex::DefaultIndexFileName(FiletoOpen), FiletoOpen );
+}
+
+/** @brief Load the index saved next to the timestamp file, if it is up to date.
+ *
+ * @return True if the index has been loaded.
+ */
+bool ReadTimestamp::LoadIndex()
+{
+	if ( Index.Load( TimestampIndex::DefaultIndexFileName(FiletoOpen), FiletoOpen ) == false )
+	{
+		return false;
+	}
+
+	UpdateCurrentIndexEntry();
+
+	return true;
+}
+
+/** @brief Get the first and last timestamps of the file without reading it sequentially: from the index
+ *		   (loaded if saved) or by reading the end of usual files backward. Only compressed files without
+ *		   saved index require a full reading.
+ *
+ * @param FirstTimestamp [out] First timestamp of the file.
+ * @param LastTimestamp [out] Last timestamp of the file.
+ * @return True if the file contains at least one timestamp.
+ */
+bool ReadTimestamp::GetTimeRange( HighResTimestamp &FirstTimestamp, HighResTimestamp &LastTimestamp )
+{
+	if ( Index.IsEmpty() == true && LoadIndex() == false )
+	{
+		// No index, try to read first and last lines
+		if ( TimestampIndex::ReadTimeRange( FiletoOpen, FirstTimestamp, LastTimestamp ) == true )
+		{
+			return true;
+		}
+
+		// Compressed file, we must read it once
+		if ( BuildIndex() == false )
+		{
+			return false;
+		}
+	}
+
+	if ( Index.IsEmpty() == true )
+	{
+		return false;
+	}
+
+	FirstTimestamp = Index[0].Timestamp;
+	LastTimestamp = Index[Index.Size()-1].Timestamp;
+
+	return true;
+}
+
+/** @brief Go to a specific entry of the index and read its line. The index must be built.
+ *
+ * @param Entry [in] Entry number in the index (zero based).
+ * @return True if the line has been read.
+ */
+bool ReadTimestamp::GoToIndexEntry( int Entry )
+{
+	if ( Entry < 0 || Entry >= (int)Index.Size() )
+	{
+		return false;
+	}
+
+	if ( fin == (FILE*)NULL )
+	{
+		Reinit();
+		if ( fin == (FILE*)NULL )
+		{
+			return false;
+		}
+	}
+
+	// Already on this line
+	if ( CurrentTimestampIsInitialized == true && CurrentIndexEntry == Entry )
+	{
+		return true;
+	}
+
+	if ( SeekInFile( Index[Entry].Position ) == false )
+	{
+		return false;
+	}
+
+	// Set previous data as if we read the file sequentially (for Rewind)
+	if ( Entry > 0 )
+	{
+		PreviousTimestampPosInFile[0] = (long int)Index[Entry-1].Position;
+		PreviousTimestamp = Index[Entry-1].Timestamp.ToTimeB();
+	}
+	else
+	{
+		PreviousTimestampPosInFile[0] = -1;
+		PreviousTimestamp.time = 0;
+		PreviousTimestamp.millitm = 0;
+		PreviousTimestamp.timezone = 0;
+	}
+	PreviousTimestampPosInFile[1] = (long int)Index[Entry].Position;
+
+	CurrentTimestampIsInitialized = false;
+	CurrentIndexEntry = -1;
+
+	if ( fin.ReadLine( LineBuffer, LineBufferSize-1 ) == (char*)NULL )
+	{
+		return false;
+	}
+
+	HighResTimestamp lTimestamp;
+	int length = 0;
+	if ( HighResTimestamp::Parse( LineBuffer, lTimestamp, length ) == false )
+	{
+		// File changed since the index was built
+		return false;
+	}
+
+	CurrentHighResTimestamp = lTimestamp;
+	CurrentTimestamp = lTimestamp.ToTimeB();
+	EndOfTimestampPosition = length;
+	CurrentTimestampIsInitialized = true;
+	CurrentIndexEntry = Entry;
+
+	return true;
+}
+
+/** @brief Search for a timestamp using the index of the file (built if needed) and a match policy.
+ *		   Only the matching line is read from the file.
+ *
+ * @param RequestedTimestamp [in] Timestamp to search for.
+ * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+ * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=DefaultValidityTimeInMs).
+ * @return True if a line matches. In this case, the current line is the matching one.
+ */
+bool ReadTimestamp::SearchDataForTimestamp( const TimeB &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs /* = DefaultValidityTimeInMs */ )
+{
+	InterpolationEntry = -1;
+	InterpolationAlpha = 0.0f;
+
+	if ( BuildIndex() == false && FollowMode == false )
+	{
+		return false;
+	}
+
+	if ( FollowMode == true )
+	{
+		// Wait for the requested timestamp if not yet recorded
+		FollowIndex( HighResTimestamp(RequestedTimestamp) );
+	}
+
+	int Entry = Index.Find( RequestedTimestamp, Policy, ToleranceInMs );
+	if ( Entry < 0 )
+	{
+		return false;
+	}
+
+	if ( Policy == TimestampIndex::MatchInterpolated )
+	{
+		int Before;
+		Index.FindBracket( HighResTimestamp(RequestedTimestamp), Before, InterpolationEntry, InterpolationAlpha );
+	}
+
+	return GoToIndexEntry( Entry );
+}
+
+/** @brief Search for a high resolution timestamp using the index of the file (built if needed) and a match policy.
+ *		   Only the matching line is read from the file.
+ *
+ * @param RequestedTimestamp [in] Timestamp to search for.
+ * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+ * @param ToleranceInNs [in] Maximum distance between the requested and the found timestamps in nanoseconds (negative for unbounded).
+ * @return True if a line matches. In this case, the current line is the matching one.
+ */
+bool ReadTimestamp::SearchDataForTimestamp( const HighResTimestamp &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, int64_t ToleranceInNs )
+{
+	InterpolationEntry = -1;
+	InterpolationAlpha = 0.0f;
+
+	if ( BuildIndex() == false && FollowMode == false )
+	{
+		return false;
+	}
+
+	if ( FollowMode == true )
+	{
+		// Wait for the requested timestamp if not yet recorded
+		FollowIndex( RequestedTimestamp );
+	}
+
+	int Entry = Index.Find( RequestedTimestamp, Policy, ToleranceInNs );
+	if ( Entry < 0 )
+	{
+		return false;
+	}
+
+	if ( Policy == TimestampIndex::MatchInterpolated )
+	{
+		int Before;
+		Index.FindBracket( RequestedTimestamp, Before, InterpolationEntry, InterpolationAlpha );
+	}
+
+	return GoToIndexEntry( Entry );
+}
@@ -14,6 +14,8 @@
 
 #include "DataFile.h"
 #include "TimestampTools.h"
+#include "TimestampIndex.h"
+#include "FileWatcher.h"
 
 namespace MobileRGBD {
 
@@ -38,6 +40,8 @@ class ReadTimestamp
 public:
 	static const size_t DefaultLineBufferSize;					/*!< @brief Default buffer size for line reading (default 10 MiB) */
 	static const unsigned short int DefaultValidityTimeInMs;	/*!< @brief When searching for a specified timestamp, DefaultValidityTimeInMs specifies a threshold to for validity (33ms). */
+	static const unsigned short int EndOfFileValidityTimeInMs;	/*!< @brief When searching after the last timestamp of the file, last data is considered as valid during EndOfFileValidityTimeInMs (100ms). */
+	static const unsigned int DefaultFollowTimeoutInMs;			/*!< @brief In follow mode, default maximum waiting time for new data (100ms). */
 	
 	/** @brief Constructor. Create a ReadTimeStamp object using specific file.
 	 *
@@ -68,6 +72,99 @@ public:
 	 */
 	virtual bool SearchDataForTimestamp( const TimeB &RequestedTimestamp, unsigned short int ValidityTimeInMs = (unsigned short int)DefaultValidityTimeInMs );
 
+	/** @brief Search for a timestamp using the index of the file (built if needed) and a match policy.
+	 *		   Only the matching line is read from the file.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=DefaultValidityTimeInMs).
+	 * @return True if a line matches. In this case, the current line is the matching one.
+	 */
+	virtual bool SearchDataForTimestamp( const TimeB &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs = (unsigned int)DefaultValidityTimeInMs );
+
+	/** @brief Search for a high resolution timestamp using the index of the file (built if needed) and a match policy.
+	 *		   Only the matching line is read from the file.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInNs [in] Maximum distance between the requested and the found timestamps in nanoseconds (negative for unbounded).
+	 * @return True if a line matches. In this case, the current line is the matching one.
+	 */
+	virtual bool SearchDataForTimestamp( const HighResTimestamp &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, int64_t ToleranceInNs );
+
+	/** @brief Build the index of the timestamp file if not already done. A saved index
+	 *		   (see SaveIndex) is loaded instead if it is up to date. To index several files
+	 *		   concurrently, see SessionIndexer.
+	 *
+	 * @param NumberOfThreads [in] Maximum number of threads parsing a usual file, 0 for the number of hardware threads (default=1).
+	 * @return True if the index is available.
+	 */
+	virtual bool BuildIndex( unsigned int NumberOfThreads = 1 );
+
+	/** @brief Save the index next to the timestamp file (TimestampIndex::DefaultIndexFileName). Build it if needed.
+	 *
+	 * @return True if the index has been saved.
+	 */
+	bool SaveIndex();
+
+	/** @brief Load the index saved next to the timestamp file, if it is up to date.
+	 *
+	 * @return True if the index has been loaded.
+	 */
+	bool LoadIndex();
+
+	/** @brief Retrieve the index entry of the current line after a change of the index.
+	 */
+	void UpdateCurrentIndexEntry();
+
+	/** @brief Name of the timestamp file.
+	 */
+	const std::string& GetFileName() const { return FiletoOpen; }
+
+	/** @brief Index the lines appended to the file since the index was built (see BuildIndex).
+	 *
+	 * @return True if new lines were indexed.
+	 */
+	bool UpdateIndex();
+
+	/** @brief Set follow mode, i.e. read a file while it is still being recorded. In follow mode,
+	 *		   end of file is not final: reading and searching functions wait at most TimeoutInMs
+	 *		   for new complete lines and the index is updated with them. Only usual files can be followed.
+	 *
+	 * @param Follow [in] Activate or deactivate follow mode.
+	 * @param TimeoutInMs [in] Maximum waiting time for new data in each call (default=DefaultFollowTimeoutInMs).
+	 * @return True if the mode has been set.
+	 */
+	virtual bool SetFollowMode( bool Follow, unsigned int TimeoutInMs = DefaultFollowTimeoutInMs );
+
+	/** @brief Return true if the file is read in follow mode.
+	 */
+	bool IsInFollowMode() const { return FollowMode; }
+
+	/** @brief Say that the timestamp file is compressed with 7z (from a session manifest for instance), its
+	 *		   7z version is then opened directly, without trying the usual file. Must be called before the file is opened.
+	 *
+	 * @param eFileIsCompressed [in] The timestamp file is compressed.
+	 */
+	void SetFileIsCompressed( bool eFileIsCompressed ) { FileIsCompressed = eFileIsCompressed; }
+
+	/** @brief Get the first and last timestamps of the file without reading it sequentially: from the index
+	 *		   (loaded if saved) or by reading the end of usual files backward. Only compressed files without
+	 *		   saved index require a full reading.
+	 *
+	 * @param FirstTimestamp [out] First timestamp of the file.
+	 * @param LastTimestamp [out] Last timestamp of the file.
+	 * @return True if the file contains at least one timestamp.
+	 */
+	bool GetTimeRange( HighResTimestamp &FirstTimestamp, HighResTimestamp &LastTimestamp );
+
+	/** @brief Go to a specific entry of the index and read its line. The index must be built.
+	 *
+	 * @param Entry [in] Entry number in the index (zero based).
+	 * @return True if the line has been read.
+	 */
+	virtual bool GoToIndexEntry( int Entry );
+
 	/** @brief Get the next timestamp of the file if any.
 	 *
 	 * @return True is the next timestamp has been retrieve.
@@ -90,8 +187,14 @@ public:
 	int LineBufferSize;							/*!< @brief Actual size of the line buffer. */
 	int EndOfTimestampPosition;					/*!< @brief Actual size of the line buffer. */
 	TimeB CurrentTimestamp;						/*!< @brief Current value for the timestamp extracted from the file. */
+	HighResTimestamp CurrentHighResTimestamp;	/*!< @brief Current value for the timestamp with all digits from the file (sub-millisecond if any). */
 	bool  CurrentTimestampIsInitialized;		/*!< @brief CurrentTimestamp is valid. */
 
+	TimestampIndex Index;						/*!< @brief Index of the timestamp file (empty until BuildIndex is called). */
+	int CurrentIndexEntry;						/*!< @brief Entry of the index for the current line when known, -1 otherwise. */
+	int InterpolationEntry;						/*!< @brief After a search with MatchInterpolated, entry of the line following the current one (-1 otherwise). */
+	float InterpolationAlpha;					/*!< @brief After a search with MatchInterpolated, weight of the InterpolationEntry line data in [0, 1]. */
+
 protected:
 	/** @brief Retrieve position of the current timestamp in the file (for the Rewind method).
 	 *
@@ -101,15 +204,43 @@ protected:
 		if ( fin != (FILE*)NULL )
 		{
 			PreviousTimestampPosInFile[0] = PreviousTimestampPosInFile[1];
-			PreviousTimestampPosInFile[1] = ftell( fin );
+			PreviousTimestampPosInFile[1] = (long int)fin.Tell();
 		}
 	}
 
+	/** @brief Check if the line in LineBuffer is complete (ends with an end of line or fills the buffer).
+	 */
+	bool IsLineComplete()
+	{
+		size_t Length = strlen( LineBuffer );
+		return ((Length > 0 && LineBuffer[Length-1] == '\n') || (int)Length >= LineBufferSize-2);
+	}
+
+	/** @brief In follow mode, update the index until it contains RequestedTimestamp, waiting for new
+	 *		   lines at most FollowTimeoutInMs.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp expected in the file.
+	 * @return True if the last entry of the index is at or after RequestedTimestamp.
+	 */
+	bool FollowIndex( const HighResTimestamp &RequestedTimestamp );
+
+	/** @brief Set position in the timestamp file, reopening it if needed (backward seek in pipes).
+	 *
+	 * @param Position [in] New position in the file.
+	 * @return True if the position has been set.
+	 */
+	bool SeekInFile( int64_t Position );
+
 	DataFile fin;								/*!< @brief DataFile object to read usual or compressed files. */
 	std::string FiletoOpen;						/*!< @brief Store the file name. */
 
 	long int PreviousTimestampPosInFile[2];		/*!< @brief Store previous position in file in order to permit rewind. */
 	TimeB PreviousTimestamp;					/*!< @brief Value of the preivous timestamp. */
+
+	bool FollowMode;							/*!< @brief The file is still being recorded, end of file is not final. */
+	unsigned int FollowTimeoutInMs;				/*!< @brief In follow mode, maximum waiting time for new data in each call. */
+	bool FileIsCompressed;						/*!< @brief Only the 7z version of the timestamp file is opened (see SetFileIsCompressed). */
+	FileWatcher Watcher;						/*!< @brief In follow mode, wait for modifications of the file. */
 };
 
 } // namespace MobileRGBD
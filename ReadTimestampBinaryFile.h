@@ -0,0 +1,236 @@
+/**
+ * @file ReadTimestampBinaryFile.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __READ_TIMESTAMP_BINARY_FILE__
+#define __READ_TIMESTAMP_BINARY_FILE__
+
+#include <string>
+
+#include "BinaryRecordFile.h"
+#include "ReadTimestamp.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class ReadTimestampBinaryFile ReadTimestampBinaryFile.h
+ * @brief Read a binary record file (see BinaryRecordFile) with the same interface as ReadTimestampFile.
+ *		  Instead of the textual DataBuffer, the Data pointer gives the decoded structure of the
+ *		  current record, directly in the mapped file. No text is parsed. Example:
+ *		  @code
+		  ConvertToBinaryRecordFile<RobotPoseSchema>( "robot.txt", "robot.rec" );	// once
+
+		  ReadTimestampBinaryFile<RobotPose> Robot( "robot.rec" );
+		  if ( Robot.GetDataForTimestamp( Timestamp ) ) { float x = Robot.Data->x; ... }
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<typename Struct>
+class ReadTimestampBinaryFile
+{
+public:
+	/** @brief Constructor. Create a ReadTimestampBinaryFile object using specific file.
+	 *
+	 * @param FileName [in] Name of the binary record file to open.
+	 */
+	ReadTimestampBinaryFile( const std::string& FileName )
+	{
+		FiletoOpen = FileName;
+		Data = nullptr;
+		ResetCurrent();
+	}
+
+	/** @brief virtual destructor (always).
+	 */
+	virtual ~ReadTimestampBinaryFile() {}
+
+	/** @brief Restart file at beginning (if file is closed, file is re-opened).
+	 */
+	virtual void Reinit()
+	{
+		if ( File.IsOpen() == false )
+		{
+			File.Open( FiletoOpen, sizeof(Struct) );
+		}
+		ResetCurrent();
+	}
+
+	/** @brief Close file.
+	 */
+	void Close()
+	{
+		File.Close();
+		ResetCurrent();
+	}
+
+	/** @brief Get the next timestamp of the file if any. The current record does not change at the end of the file.
+	 *
+	 * @return True is the next timestamp has been retrieve, false if no record is left.
+	 */
+	virtual bool GetNextTimestamp()
+	{
+		if ( OpenIfNeeded() == false || CurrentRecord+1 >= (int)File.Size() )
+		{
+			return false;
+		}
+
+		return GoToRecord( CurrentRecord+1 );
+	}
+
+	/** @brief Get the previous timestamp of the file if any.
+	 *
+	 * @return True is the previous timestamp has been retrieve.
+	 */
+	bool GetPreviousTimestamp()
+	{
+		return GoToRecord( CurrentRecord-1 );
+	}
+
+	/** @brief Search for a specific timestamp, same behaviour as ReadTimestamp::SearchDataForTimestamp.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param ValidityTimeInMs [in] Validity of a previous record (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if the record exists or if the previous one is less than ValidityTimeInMs ms before.
+	 */
+	virtual bool SearchDataForTimestamp( const TimeB &RequestedTimestamp, unsigned short int ValidityTimeInMs = (unsigned short int)ReadTimestamp::DefaultValidityTimeInMs )
+	{
+		if ( OpenIfNeeded() == false || File.Size() == 0 )
+		{
+			return false;
+		}
+
+		HighResTimestamp lRequestedTimestamp( RequestedTimestamp );
+
+		// After the end of the file, last record stays valid during EndOfFileValidityTimeInMs
+		if ( lRequestedTimestamp > File.GetTimestamp( File.Size()-1 ) )
+		{
+			ValidityTimeInMs = ReadTimestamp::EndOfFileValidityTimeInMs;
+		}
+
+		return SearchDataForTimestamp( lRequestedTimestamp, TimestampIndex::MatchFloor, (int64_t)ValidityTimeInMs*HighResTimestamp::NanosecondsPerMillisecond );
+	}
+
+	/** @brief Search for a timestamp using a match policy, same behaviour as ReadTimestamp::SearchDataForTimestamp.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if a record matches. In this case, the current record is the matching one.
+	 */
+	virtual bool SearchDataForTimestamp( const TimeB &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs )
+	{
+		int64_t ToleranceInNs = -1;
+
+		if ( ToleranceInMs != TimestampIndex::UnboundedTolerance )
+		{
+			ToleranceInNs = (int64_t)ToleranceInMs*HighResTimestamp::NanosecondsPerMillisecond;
+		}
+		return SearchDataForTimestamp( HighResTimestamp(RequestedTimestamp), Policy, ToleranceInNs );
+	}
+
+	/** @brief Search for a timestamp using a match policy.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInNs [in] Maximum distance between the requested and the found timestamps in nanoseconds (negative for unbounded).
+	 * @return True if a record matches. In this case, the current record is the matching one.
+	 */
+	virtual bool SearchDataForTimestamp( const HighResTimestamp &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, int64_t ToleranceInNs )
+	{
+		if ( OpenIfNeeded() == false )
+		{
+			return false;
+		}
+
+		return GoToRecord( File.Find( RequestedTimestamp, Policy, ToleranceInNs ) );
+	}
+
+	/** @brief Search for a specific timestamp and set the Data pointer on the record.
+	 *
+	 * @param RequestedTimestamp [in] Requested timestamp.
+	 * @param ValidityTimeInMs [in] Threshold for searching for a timestamp (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if the timestamp has been found.
+	 */
+	virtual bool GetDataForTimestamp( const TimeB &RequestedTimestamp, unsigned short int ValidityTimeInMs = (unsigned short int)ReadTimestamp::DefaultValidityTimeInMs )
+	{
+		return SearchDataForTimestamp( RequestedTimestamp, ValidityTimeInMs );
+	}
+
+	/** @brief Search for a specific timestamp using a match policy and set the Data pointer on the record.
+	 *
+	 * @param RequestedTimestamp [in] Requested timestamp.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if the timestamp has been found.
+	 */
+	virtual bool GetDataForTimestamp( const TimeB &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs )
+	{
+		return SearchDataForTimestamp( RequestedTimestamp, Policy, ToleranceInMs );
+	}
+
+	/** @brief Go to a specific record.
+	 *
+	 * @param Record [in] Record number (zero based).
+	 * @return True if the record exists.
+	 */
+	bool GoToRecord( int Record )
+	{
+		if ( OpenIfNeeded() == false || Record < 0 || Record >= (int)File.Size() )
+		{
+			return false;
+		}
+
+		CurrentRecord = Record;
+		CurrentHighResTimestamp = File.GetTimestamp( (size_t)Record );
+		CurrentTimestamp = CurrentHighResTimestamp.ToTimeB();
+		CurrentTimestampIsInitialized = true;
+		Data = (const Struct*)File.GetData( (size_t)Record );
+
+		return true;
+	}
+
+	/** @brief Number of records in the file.
+	 */
+	size_t Size() { OpenIfNeeded(); return File.Size(); }
+
+	TimeB CurrentTimestamp;						/*!< @brief Current value for the timestamp. */
+	HighResTimestamp CurrentHighResTimestamp;	/*!< @brief Current value for the timestamp with all digits. */
+	bool  CurrentTimestampIsInitialized;		/*!< @brief CurrentTimestamp is valid. */
+	int CurrentRecord;							/*!< @brief Current record number, -1 before the first one. */
+	const Struct * Data;						/*!< @brief Pointer on the data of the current record (valid until Close). */
+
+protected:
+	/** @brief Open the file if needed.
+	 */
+	bool OpenIfNeeded()
+	{
+		if ( File.IsOpen() == false )
+		{
+			Reinit();
+		}
+		return File.IsOpen();
+	}
+
+	/** @brief Reset current values.
+	 */
+	void ResetCurrent()
+	{
+		CurrentTimestamp.time = 0;
+		CurrentTimestamp.millitm = 0;
+		CurrentTimestamp.timezone = 0;
+		CurrentHighResTimestamp = HighResTimestamp();
+		CurrentTimestampIsInitialized = false;
+		CurrentRecord = -1;
+	}
+
+	BinaryRecordFile File;				/*!< @brief The mapped binary record file. */
+	std::string FiletoOpen;				/*!< @brief Store the file name. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __READ_TIMESTAMP_BINARY_FILE__
@@ -38,6 +38,25 @@ bool ReadTimestampFile::GetDataForTimestamp(const TimeB &RequestedTimestamp, uns
 	return false;
 }
 
+/** @brief Search for a specific timestamp using the index and a match policy and set the DataBuffer pointer
+ *		   on the beginning of the data.
+ *
+ * @param RequestedTimestamp [in] Requested timestamp.
+ * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+ * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return True if the timestamp has been found.
+ */
+bool ReadTimestampFile::GetDataForTimestamp(const TimeB &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	if ( SearchDataForTimestamp(RequestedTimestamp, Policy, ToleranceInMs) == true )
+	{
+		DataBuffer = &LineBuffer[EndOfTimestampPosition];
+		return true;
+	}
+
+	return false;
+}
+
 
 /** @brief Search for the timestamp and set the DataBuffer pointer on the beginning of the data.
  *		   Could be overloaded as a virtual function.
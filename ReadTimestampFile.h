@@ -61,6 +61,16 @@ public:
 	 */
 	virtual bool GetDataForTimestamp(const TimeB &RequestedTimestamp, unsigned short int ValidityTimeInMs = (unsigned short int)ReadTimestamp::DefaultValidityTimeInMs );
 
+	/** @brief Search for a specific timestamp using the index and a match policy and set the DataBuffer pointer
+	 *		   on the beginning of the data.
+	 *
+	 * @param RequestedTimestamp [in] Requested timestamp.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if the timestamp has been found.
+	 */
+	virtual bool GetDataForTimestamp(const TimeB &RequestedTimestamp, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
 	/** @brief Search for the timestamp and set the DataBuffer pointer on the beginning of the data.
 	 *		   Could be overloaded as a virtual function.
 	 *
@@ -11,6 +11,8 @@
 
 using namespace MobileRGBD;
 
+const unsigned int ReadTimestampRawFile::DefaultNumberOfPrefetchedFrames = 8;	/*!< @brief Default number of frames read in advance when prefetching (8). */
+
 /** @brief Constructor. Create a ReadTimestampRawFile object using specific files (timestamp + raw).
  *
  * @param WorkingFile [in] Name of the timestamp file to open (even with '/' separator under Windows as Windows handles it also as a folder/file separator).
@@ -29,7 +31,16 @@ ReadTimestampRawFile::ReadTimestampRawFile( const std::string &WorkingFile, cons
 	FrameSize = SizeOfFrame;
 
 	FrameBuffer.SetNewBufferSize(SizeOfFrame+1);
+	FrameData = FrameBuffer;
 	IndexofFrameBuffer = -1;
+	CacheFileId = 0;
+	VariableFrameDecoder = DecodeStoredFrame;
+	NumberOfDecodingThreads = 0;
+	DecimationStep = 1;
+	DecimationPeriodInNs = 0;
+	RawFormat = UnknownRawFileFormat;
+	StartingFrameIsKnown = false;
+	RawFileIsCompressed = false;
 }
 
 /** @brief Restart file at beginning (if file is closed, file is re-opened).
@@ -45,26 +56,38 @@ void ReadTimestampRawFile::Reinit()
 
 	// Reinit number of subframes
 	NumberOfSubFrames = 0;
-	
-	// try to read a line
-	LineBuffer[0] = '\0';
-	if ( fgets( LineBuffer, LineBufferSize-1, fin ) == (char*)NULL )
-	{
-		return;
-	}
 
-	// Get Starting Frame (in case it is not 0)
-	if ( sscanf( LineBuffer, "%*d.%*d%*[ \t]%d", &StartingFrame ) != 1 )
+	// Starting frame given by the caller, the file is already at its beginning
+	if ( StartingFrameIsKnown == false )
 	{
-		return;
-	}
+		// try to read a line
+		LineBuffer[0] = '\0';
+		if ( fin.ReadLine( LineBuffer, LineBufferSize-1 ) == (char*)NULL )
+		{
+			return;
+		}
 
-	// Reset file to begining
-	fin.Seek( 0L, SEEK_SET );
+		// Get Starting Frame (in case it is not 0)
+		if ( sscanf( LineBuffer, "%*d.%*d%*[ \t]%d", &StartingFrame ) != 1 )
+		{
+			return;
+		}
+
+		// Reset file to begining
+		SeekInFile( 0L );
+	}
 
-	// Restore starting current indexes
+	// Restore starting current indexes, the raw file stays where it is
 	IndexofFrameBuffer = -1;
 	CurrentIndex = 0;
+	if ( fRaw.IsOpen() == true && fRaw.Tell() > 0 )
+	{
+		// May be inside a frame after GetFrameROI on a pipe
+		int64_t RawPosition = fRaw.Tell();
+		CurrentIndex = (RawPosition % (int64_t)FrameSize) == 0 ? (int)(RawPosition/(int64_t)FrameSize) : -1;
+	}
+
+	RestartPrefetching();
 }
 
 /** @brief Search for the timestamp and if found and process it by calling ProcessElement. 
@@ -91,6 +114,12 @@ int ReadTimestampRawFile::GetFrameNumber()
 {
 	int FrameIndex = -1;
 
+	// Frame number already parsed by the index
+	if ( CurrentIndexEntry >= 0 && Index[CurrentIndexEntry].FrameNumber >= 0 )
+	{
+		return Index[CurrentIndexEntry].FrameNumber;
+	}
+
 	// If sscanf failed, FrameIndex remains -1
 	sscanf( DataBuffer, "%d", &FrameIndex );
 
@@ -120,7 +149,33 @@ bool ReadTimestampRawFile::LoadFrame( const TimeB &RequestTimestamp )
 	return false;
 }
 
-/** @brief Get frame for a specific index
+/** @brief Load frame for a specific timestamp using the index and a match policy
+ *
+ * @param RequestedTimestamp [in] Requested timestamp.
+ * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+ * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return True if the full frame was loaded.
+ */
+bool ReadTimestampRawFile::LoadFrame( const TimeB &RequestTimestamp, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	if ( GetDataForTimestamp( RequestTimestamp, Policy, ToleranceInMs ) == false )
+	{
+		// Can not get data
+		return false;
+	}
+
+	// Get corresponding frame index
+	int FrameIndex = GetFrameNumber();
+	if( FrameIndex >= 0 )
+	{
+		return GetFrame( FrameIndex );
+	}
+
+	return false;
+}
+
+/** @brief Get frame for a specific index. In SubFramesMode, WantedIndex is the frame number of a line
+ *		   and its subframes are located using the index (built if needed).
  *
  * @param WantedIndex [in] Frame number in the raw file.
  * @return True if the full frame was loaded.
@@ -128,14 +183,18 @@ bool ReadTimestampRawFile::LoadFrame( const TimeB &RequestTimestamp )
 bool ReadTimestampRawFile::GetFrame( int WantedIndex )
 {
 	int Index = WantedIndex - StartingFrame;
+	int64_t FirstSubFrame;
 	NumberOfSubFrames = 0;
 
-	if ( fRaw.IsOpen() == false )
+	if ( OpenRawFile() == false )
 	{
-		if ( fRaw.Open( RawFileName.c_str(), DataFile::READ_MODE ) == false )
-		{
-			return false;
-		}
+		return false;
+	}
+
+	// If we are in multiple mode, we want to load all frame at once
+	if ( LocateFrame( WantedIndex, FirstSubFrame ) == false )
+	{
+		return false;
 	}
 
 	// The frame buffer contains already data for this index
@@ -144,66 +203,1080 @@ bool ReadTimestampRawFile::GetFrame( int WantedIndex )
 		return true;
 	}
 
-	// If we are in multiple mode, we want to load all frame at once
-	// Default values for single mode
-	int LoadSize;
-	if ( Mode == SubFramesMode )
+	if ( NumberOfSubFrames == 0 )
 	{
-		// Here we need to get the number of sub-frames
-		if ( sscanf( DataBuffer, "%*d, %d", &NumberOfSubFrames ) != 1 )
+		// Here, nothing to load timestamp with empty data, loaded !
+		return true;
+	}
+
+	// Compute new load size
+	int LoadSize = FrameSize * NumberOfSubFrames;
+
+	// Increase if needed size of buffer
+	FrameBuffer.SetNewBufferSize( LoadSize );
+
+	// Frame loaded in advance, just hand off the buffer
+	if ( Prefetcher != nullptr )
+	{
+		int PrefetchedSubFrames;
+		const unsigned char * PrefetchedData = Prefetcher->Acquire( Index, PrefetchedSubFrames );
+
+		if ( PrefetchedData != nullptr && PrefetchedSubFrames == NumberOfSubFrames )
 		{
-			// Could not find subframe number
-			fprintf( stderr, "Could not retrieve number of subFrame in SubFramesMode\n" );
-			return false;
+			FrameData = PrefetchedData;
+			IndexofFrameBuffer = Index;
+			AddFrameToCache( Index, LoadSize );
+			return true;
 		}
 
-		if ( NumberOfSubFrames == 0 )
+		// Previous prefetched buffer is released
+		FrameData = FrameBuffer;
+		IndexofFrameBuffer = -1;
+	}
+
+	// Frame already read recently
+	if ( Cache != nullptr )
+	{
+		std::shared_ptr<const CachedFrame> Frame = Cache->Find( CacheFileId, Index );
+		if ( Frame != nullptr && Frame->Data.size() == (size_t)LoadSize )
 		{
-			// Here, nothing to load timestamp with empty data, loaded !
+			memcpy( (unsigned char*)FrameBuffer, &Frame->Data[0], LoadSize );
+			FrameData = FrameBuffer;
+			IndexofFrameBuffer = Index;
 			return true;
 		}
-		
-		// Compute new load size
-		LoadSize = FrameSize * NumberOfSubFrames;
-
-		// Increase if needed size of buffer
-		FrameBuffer.SetNewBufferSize( LoadSize );
 	}
-	else
+
+	// Try to go to new position and read a frame
+	int64_t NewPos = FirstSubFrame*(int64_t)FrameSize;
+
+	if ( FollowMode == true && WaitForRawData( NewPos + (int64_t)LoadSize ) == false )
 	{
-		// In simple mode, there is alsways a frame
-		NumberOfSubFrames = 1;
-		LoadSize = FrameSize;
+		// Frame is not written yet
+		return false;
 	}
 
-	if ( Index == CurrentIndex )
+	if ( FirstSubFrame == (int64_t)CurrentIndex && IsPlainRawFile() == true )
 	{
 		// idilic case
 		if ( fRaw.Read( FrameBuffer, LoadSize, 1) != 1 )
 		{
 			return false;
 		}
+		FrameData = FrameBuffer;
 		IndexofFrameBuffer = Index;
 		CurrentIndex += NumberOfSubFrames;
+		AddFrameToCache( Index, LoadSize );
+		RestartPrefetching();
 		return true;
 	}
 
-	// Try to go to new position and read a frame
-	int64_t NewPos = (int64_t)Index*(int64_t)FrameSize;
+	// One positional read (or decoding), the position in the raw file only changes for pipes
+	if ( ReadRawData( FrameBuffer, (size_t)LoadSize, NewPos ) == false )
+	{
+		return false;
+	}
+
+	// Data in memory buffer is Index
+	FrameData = FrameBuffer;
+	IndexofFrameBuffer = Index;
+	if ( fRaw.IsPipeOpened() == true )
+	{
+		// Current Index is now the next one
+		CurrentIndex = (int)FirstSubFrame + NumberOfSubFrames;
+	}
+
+	AddFrameToCache( Index, LoadSize );
+	RestartPrefetching();
+
+	return true;
+}
 
-	if ( fRaw.Seek( NewPos, SEEK_SET ) != 0 )
+/** @brief Get a frame of 16 bits values (depth, infrared) as floats, in SimpleFrameMode. Packed depth files
+ *		   are unpacked directly in Output, other raw files are loaded in FrameBuffer (see GetFrame) and converted.
+ *
+ * @param WantedIndex [in] Frame number in the raw file.
+ * @param Output [out] Buffer of FrameSize/2 floats.
+ * @param Scale [in] Scale of the values, 0.001 gives meters for depth frames (default=1).
+ * @return True if the full frame was loaded.
+ */
+bool ReadTimestampRawFile::GetFrame( int WantedIndex, float * Output, float Scale /* = 1.0f */ )
+{
+	int64_t FirstSubFrame;
+
+	if ( Mode != SimpleFrameMode || (FrameSize % sizeof(uint16_t)) != 0 || OpenRawFile() == false )
 	{
 		return false;
 	}
-	if ( fRaw.Read( FrameBuffer, LoadSize, 1 ) != 1 )
+
+	if ( PackedRaw != nullptr )
+	{
+		if ( LocateFrame( WantedIndex, FirstSubFrame ) == false )
+		{
+			return false;
+		}
+		return PackedRaw->ReadFrames( FirstSubFrame, 1, Output, Scale );
+	}
+
+	if ( GetFrame( WantedIndex ) == false )
 	{
 		return false;
 	}
 
-	// Data in memory buffer is Index
-	IndexofFrameBuffer = Index;
-	// Current Index is now the next one
-	CurrentIndex = Index + NumberOfSubFrames;
+	const uint16_t * Values = (const uint16_t*)FrameData;
+	int NumberOfValues = FrameSize/(int)sizeof(uint16_t);
+	for( int i = 0; i < NumberOfValues; i++ )
+	{
+		Output[i] = (float)Values[i]*Scale;
+	}
+
+	return true;
+}
+
+/** @brief Get a region of a frame in SimpleFrameMode, reading only its rows: one vectored positional read
+ *		   for usual raw files (see DataFile::ReadSegmentsAt). Frames already in memory are not read again,
+ *		   compressed raw files are decoded with GetFrame. The current frame (FrameData) does not change.
+ *
+ * @param WantedIndex [in] Frame number in the raw file.
+ * @param ROI [in] Region in pixels, inside the frame.
+ * @param FrameWidth [in] Width of the frames in pixels, the height is deduced from FrameSize.
+ * @param BytesPerPixel [in] Size of each pixel.
+ * @param Output [out] Buffer of ROI.Width*ROI.Height*BytesPerPixel bytes, rows of the region one after the other.
+ * @return True if the full region was read.
+ */
+bool ReadTimestampRawFile::GetFrameROI( int WantedIndex, const FrameROI& ROI, int FrameWidth, int BytesPerPixel, void * Output )
+{
+	int Index = WantedIndex - StartingFrame;
+	int64_t FirstSubFrame;
+
+	if ( Mode != SimpleFrameMode || Index < 0 || FrameWidth <= 0 || BytesPerPixel <= 0 )
+	{
+		return false;
+	}
+
+	int RowSize = FrameWidth*BytesPerPixel;
+	int FrameHeight = FrameSize/RowSize;
+	if ( ROI.x < 0 || ROI.y < 0 || ROI.Width <= 0 || ROI.Height <= 0 || ROI.x + ROI.Width > FrameWidth || ROI.y + ROI.Height > FrameHeight )
+	{
+		return false;
+	}
+
+	if ( OpenRawFile() == false || LocateFrame( WantedIndex, FirstSubFrame ) == false )
+	{
+		return false;
+	}
+
+	// Frame already in memory
+	if ( Index == IndexofFrameBuffer )
+	{
+		CopyFrameROI( FrameData, ROI, (size_t)RowSize, BytesPerPixel, (unsigned char*)Output );
+		return true;
+	}
+	if ( Cache != nullptr )
+	{
+		std::shared_ptr<const CachedFrame> Frame = Cache->Find( CacheFileId, Index );
+		if ( Frame != nullptr && Frame->Data.size() == (size_t)FrameSize )
+		{
+			CopyFrameROI( &Frame->Data[0], ROI, (size_t)RowSize, BytesPerPixel, (unsigned char*)Output );
+			return true;
+		}
+	}
+
+	if ( IsPlainRawFile() == false )
+	{
+		// Frames are decoded as a whole
+		if ( GetFrame( WantedIndex ) == false )
+		{
+			return false;
+		}
+		CopyFrameROI( FrameData, ROI, (size_t)RowSize, BytesPerPixel, (unsigned char*)Output );
+		return true;
+	}
+
+	int64_t FramePosition = FirstSubFrame*(int64_t)FrameSize;
+	if ( FollowMode == true && WaitForRawData( FramePosition + (int64_t)FrameSize ) == false )
+	{
+		// Frame is not written yet
+		return false;
+	}
+
+	// Only the rows of the region, i.e. 4 times less data for a quarter of the height
+	size_t SegmentSize = (size_t)ROI.Width*(size_t)BytesPerPixel;
+	int64_t Position = FramePosition + (int64_t)ROI.y*(int64_t)RowSize + (int64_t)ROI.x*(int64_t)BytesPerPixel;
+	size_t NbRead = fRaw.ReadSegmentsAt( Output, SegmentSize, (size_t)ROI.Height, Position, (int64_t)RowSize );
+
+	if ( fRaw.IsPipeOpened() == true )
+	{
+		// Not at the beginning of a frame anymore
+		CurrentIndex = -1;
+	}
+
+	return (NbRead == SegmentSize*(size_t)ROI.Height);
+}
+
+/** @brief Copy a region of a frame in memory.
+ *
+ * @param Frame [in] Frame data.
+ * @param ROI [in] Region in pixels.
+ * @param RowSize [in] Size of a row of the frame.
+ * @param BytesPerPixel [in] Size of each pixel.
+ * @param Output [out] Rows of the region.
+ */
+void ReadTimestampRawFile::CopyFrameROI( const unsigned char * Frame, const FrameROI& ROI, size_t RowSize, int BytesPerPixel, unsigned char * Output )
+{
+	size_t SegmentSize = (size_t)ROI.Width*(size_t)BytesPerPixel;
+	const unsigned char * Row = Frame + (size_t)ROI.y*RowSize + (size_t)ROI.x*(size_t)BytesPerPixel;
+
+	for( int y = 0; y < ROI.Height; y++ )
+	{
+		memcpy( Output, Row, SegmentSize );
+		Output += SegmentSize;
+		Row += RowSize;
+	}
+}
+
+/** @brief Read frames in advance in a background thread, following the next lines of the timestamp
+ *		   file. When a requested frame is already loaded, GetFrame only sets FrameData on it (FrameBuffer
+ *		   is not filled). Other requests are read as usual and prefetching restarts after them.
+ *
+ * @param NumberOfFrames [in] Number of frames read in advance (default=DefaultNumberOfPrefetchedFrames).
+ * @return True if prefetching started.
+ */
+bool ReadTimestampRawFile::EnablePrefetching( unsigned int NumberOfFrames /* = DefaultNumberOfPrefetchedFrames */ )
+{
+	DisablePrefetching();
+
+	// The prefetcher reads usual or 7z raw files
+	if ( OpenRawFile() == false || IsPlainRawFile() == false )
+	{
+		return false;
+	}
+
+	// We need the starting frame
+	if ( fin.IsOpen() == false )
+	{
+		Reinit();
+		if ( fin.IsOpen() == false )
+		{
+			return false;
+		}
+	}
+
+	Prefetcher.reset( new FramePrefetcher( FiletoOpen, RawFileName, FrameSize, StartingFrame, Mode == SubFramesMode, NumberOfFrames, (size_t)LineBufferSize ) );
+	Prefetcher->SetDecimation( DecimationStep, DecimationPeriodInNs );
+	RestartPrefetching();
+
+	return true;
+}
+
+/** @brief Stop reading frames in advance.
+ */
+void ReadTimestampRawFile::DisablePrefetching()
+{
+	if ( Prefetcher == nullptr )
+	{
+		return;
+	}
+
+	// Current frame may be in a prefetched buffer
+	if ( FrameData != (const unsigned char*)FrameBuffer )
+	{
+		FrameData = FrameBuffer;
+		IndexofFrameBuffer = -1;
+	}
+
+	Prefetcher.reset();
+}
+
+/** @brief Restart prefetching after the current line of the timestamp file.
+ */
+void ReadTimestampRawFile::RestartPrefetching()
+{
+	if ( Prefetcher == nullptr || fin.IsOpen() == false )
+	{
+		return;
+	}
+
+	int64_t NextSubFrame = 0;
+	if ( Mode == SubFramesMode && CurrentTimestampIsInitialized == true )
+	{
+		// Subframes of the next lines follow the ones of the current line
+		if ( CurrentIndexEntry < 0 )
+		{
+			Prefetcher->Stop();
+			return;
+		}
+		NextSubFrame = Index.GetSubFrameOffset( (size_t)CurrentIndexEntry+1 );
+	}
+
+	// The current frame is read, next frames are the ones of GetNextFrame
+	unsigned int LinesToSkip = 0;
+	HighResTimestamp NextTimestamp;
+	if ( CurrentTimestampIsInitialized == true )
+	{
+		LinesToSkip = DecimationStep - 1;
+		if ( DecimationPeriodInNs > 0 )
+		{
+			NextTimestamp = GetNextDecimationTimestamp();
+		}
+	}
+
+	Prefetcher->Start( fin.Tell(), NextSubFrame, LinesToSkip, NextTimestamp );
+}
+
+/** @brief Read one frame line out of Step with GetNextFrame. Skipped frames are neither read nor decoded,
+ *		   the next frame is reached using the index and a positional read. Prefetching follows the decimation.
+ *
+ * @param Step [in] Number of frame lines from one read frame to the next one, 1 reads all frames.
+ */
+void ReadTimestampRawFile::SetDecimation( unsigned int Step )
+{
+	DecimationStep = Step > 0 ? Step : 1;
+	DecimationPeriodInNs = 0;
+
+	if ( Prefetcher != nullptr )
+	{
+		Prefetcher->SetDecimation( DecimationStep, DecimationPeriodInNs );
+		RestartPrefetching();
+	}
+}
+
+/** @brief Read frames at a target rate with GetNextFrame: the first frame at or after each period (see SetDecimation).
+ *
+ * @param FramesPerSecond [in] Target rate, 0 reads all frames.
+ */
+void ReadTimestampRawFile::SetDecimationRate( double FramesPerSecond )
+{
+	DecimationStep = 1;
+	DecimationPeriodInNs = 0;
+	if ( FramesPerSecond > 0.0 )
+	{
+		DecimationPeriodInNs = (int64_t)((double)HighResTimestamp::NanosecondsPerSecond/FramesPerSecond + 0.5);
+	}
+	NextDecimationTimestamp = HighResTimestamp();
+
+	if ( Prefetcher != nullptr )
+	{
+		Prefetcher->SetDecimation( DecimationStep, DecimationPeriodInNs );
+		RestartPrefetching();
+	}
+}
+
+/** @brief Load the next frame according to the decimation (see SetDecimation), or the first frame of the
+ *		   file if there is no current line. The index is built if needed, the current line is the line of the frame.
+ *
+ * @return True if a frame was loaded, false at the end of the file.
+ */
+bool ReadTimestampRawFile::GetNextFrame()
+{
+	if ( BuildIndex() == false )
+	{
+		return false;
+	}
+
+	if ( FollowMode == true )
+	{
+		// Lines may have been written since
+		UpdateIndex();
+	}
+
+	int Entry = 0;
+	if ( CurrentTimestampIsInitialized == true && CurrentIndexEntry >= 0 )
+	{
+		if ( DecimationPeriodInNs > 0 )
+		{
+			// First line of the next period
+			Entry = Index.Find( GetNextDecimationTimestamp(), TimestampIndex::MatchCeil, -1 );
+			if ( Entry < 0 )
+			{
+				return false;
+			}
+			if ( Entry <= CurrentIndexEntry )
+			{
+				Entry = CurrentIndexEntry+1;
+			}
+		}
+		else
+		{
+			// Skipped lines are never read, only their index entries
+			Entry = CurrentIndexEntry;
+			for( unsigned int Remaining = DecimationStep; Remaining > 0; )
+			{
+				if ( ++Entry >= (int)Index.Size() )
+				{
+					return false;
+				}
+				if ( Index[Entry].FrameNumber >= 0 )
+				{
+					Remaining--;
+				}
+			}
+		}
+	}
+
+	// Lines without frame number are not frames
+	while( Entry < (int)Index.Size() && Index[Entry].FrameNumber < 0 )
+	{
+		Entry++;
+	}
+
+	if ( DecimationPeriodInNs > 0 && Entry < (int)Index.Size() )
+	{
+		// Next period, or one period after this frame if we are late (gap in the recording)
+		HighResTimestamp FrameTimestamp = Index[Entry].Timestamp;
+		HighResTimestamp NextTimestamp = FrameTimestamp + DecimationPeriodInNs;
+		if ( CurrentTimestampIsInitialized == true && CurrentIndexEntry >= 0 )
+		{
+			NextTimestamp = GetNextDecimationTimestamp() + DecimationPeriodInNs;
+			if ( NextTimestamp <= FrameTimestamp )
+			{
+				NextTimestamp = FrameTimestamp + DecimationPeriodInNs;
+			}
+		}
+		NextDecimationTimestamp = NextTimestamp;
+	}
+
+	if ( GoToIndexEntry( Entry ) == false )
+	{
+		return false;
+	}
+
+	return GetFrame( Index[Entry].FrameNumber );
+}
+
+/** @brief With a decimation rate, minimal timestamp of the frame after the current line (see GetNextFrame).
+ *		   A value left by another current line is replaced by one period after the current timestamp.
+ */
+HighResTimestamp ReadTimestampRawFile::GetNextDecimationTimestamp() const
+{
+	if ( NextDecimationTimestamp <= CurrentHighResTimestamp || NextDecimationTimestamp > CurrentHighResTimestamp + DecimationPeriodInNs )
+	{
+		return CurrentHighResTimestamp + DecimationPeriodInNs;
+	}
+
+	return NextDecimationTimestamp;
+}
+
+/** @brief Get a read only view on a frame, directly in the mapping of the raw file (no copy). Compressed raw files
+ *		   can not be mapped, the frame is then read and copied in a buffer owned by the view.
+ *		   Like GetFrame, subframes are located using the index in SubFramesMode.
+ *
+ * @param WantedIndex [in] Frame number in the raw file.
+ * @param View [out] View on the frame, its timestamp is the current one.
+ * @return True if the full frame is available.
+ */
+bool ReadTimestampRawFile::GetFrameView( int WantedIndex, FrameView& View )
+{
+	int Index = WantedIndex - StartingFrame;
+	int64_t FirstSubFrame;
+
+	View.Reset();
+
+	if ( Index < 0 || LocateFrame( WantedIndex, FirstSubFrame ) == false )
+	{
+		return false;
+	}
+
+	View.FrameIndex = Index;
+	View.NumberOfSubFrames = NumberOfSubFrames;
+	View.Timestamp = CurrentHighResTimestamp;
+
+	if ( NumberOfSubFrames == 0 )
+	{
+		// Here, nothing to load timestamp with empty data, loaded !
+		return true;
+	}
+
+	size_t LoadSize = (size_t)FrameSize*(size_t)NumberOfSubFrames;
+	int64_t Position = FirstSubFrame*(int64_t)FrameSize;
+
+	if ( MapRawFile( Position + (int64_t)LoadSize ) == true )
+	{
+		View.Data = RawMapping->GetData() + Position;
+		View.Size = LoadSize;
+		View.Holder = RawMapping;
+
+		// Next frame will probably be asked soon
+		RawMapping->WillNeed( Position + (int64_t)LoadSize, (int64_t)LoadSize );
+
+		return true;
+	}
+
+	// Compressed raw file, read a copy of the frame
+	if ( GetFrame( WantedIndex ) == false )
+	{
+		return false;
+	}
+
+	std::shared_ptr< std::vector<unsigned char> > FrameCopy = std::make_shared< std::vector<unsigned char> >( FrameData, FrameData + LoadSize );
+	View.Data = &(*FrameCopy)[0];
+	View.Size = LoadSize;
+	View.Holder = FrameCopy;
+
+	return true;
+}
+
+/** @brief Get a read only view on the frame of a specific timestamp (see GetFrameView).
+ *
+ * @param RequestedTimestamp [in] Requested timestamp.
+ * @param View [out] View on the frame.
+ * @return True if the full frame is available.
+ */
+bool ReadTimestampRawFile::LoadFrameView( const TimeB &RequestTimestamp, FrameView& View )
+{
+	View.Reset();
+
+	if ( GetDataForTimestamp( RequestTimestamp ) == false )
+	{
+		// Can not get data
+		return false;
+	}
+
+	// Get corresponding frame index
+	int FrameIndex = GetFrameNumber();
+	if( FrameIndex >= 0 )
+	{
+		return GetFrameView( FrameIndex, View );
+	}
+
+	return false;
+}
+
+/** @brief Get a read only view on the frame of a specific timestamp using the index and a match policy (see GetFrameView).
+ *
+ * @param RequestedTimestamp [in] Requested timestamp.
+ * @param View [out] View on the frame.
+ * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+ * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return True if the full frame is available.
+ */
+bool ReadTimestampRawFile::LoadFrameView( const TimeB &RequestTimestamp, FrameView& View, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	View.Reset();
+
+	if ( GetDataForTimestamp( RequestTimestamp, Policy, ToleranceInMs ) == false )
+	{
+		// Can not get data
+		return false;
+	}
+
+	// Get corresponding frame index
+	int FrameIndex = GetFrameNumber();
+	if( FrameIndex >= 0 )
+	{
+		return GetFrameView( FrameIndex, View );
+	}
+
+	return false;
+}
+
+/** @brief Load consecutive frames with a single read of the raw file. Frames are read in a buffer shared by their
+ *		   views, reused when all views of the previous call are released. The index is built if needed,
+ *		   the current line does not change.
+ *
+ * @param FirstIndex [in] Frame number of the first frame in the raw file.
+ * @param NumberOfFrames [in] Number of frames (i.e. of lines with a frame number) to load.
+ * @param Views [out] Views on the loaded frames, with their timestamps. May contain less frames at the end of the file.
+ * @return True if NumberOfFrames frames were loaded.
+ */
+bool ReadTimestampRawFile::GetFrames( int FirstIndex, int NumberOfFrames, std::vector<FrameView>& Views )
+{
+	Views.clear();
+
+	if ( NumberOfFrames <= 0 || BuildIndex() == false )
+	{
+		return false;
+	}
+
+	if ( FollowMode == true )
+	{
+		// Lines may have been written since
+		UpdateIndex();
+	}
+
+	int FirstEntry = Index.FindFrameNumber( FirstIndex, CurrentIndexEntry );
+	if ( FirstEntry < 0 )
+	{
+		return false;
+	}
+
+	// Collect frames and the range of the raw file containing them
+	std::vector<int64_t> Positions;
+	int64_t RangeStart = INT64_MAX;
+	int64_t RangeEnd = 0;
+
+	for( size_t Entry = (size_t)FirstEntry; Entry < Index.Size() && (int)Views.size() < NumberOfFrames; Entry++ )
+	{
+		const TimestampIndexEntry& Line = Index[Entry];
+		FrameView View;
+
+		if ( Line.FrameNumber < 0 || (Mode == SubFramesMode && Line.NumberOfSubFrames < 0) )
+		{
+			// Not a frame line
+			continue;
+		}
+
+		View.FrameIndex = Line.FrameNumber - StartingFrame;
+		View.Timestamp = Line.Timestamp;
+		if ( Mode == SubFramesMode )
+		{
+			View.NumberOfSubFrames = Line.NumberOfSubFrames;
+			Positions.push_back( Index.GetSubFrameOffset( Entry )*(int64_t)FrameSize );
+		}
+		else
+		{
+			View.NumberOfSubFrames = 1;
+			Positions.push_back( (int64_t)View.FrameIndex*(int64_t)FrameSize );
+		}
+		View.Size = (size_t)FrameSize*(size_t)View.NumberOfSubFrames;
+
+		if ( View.Size > 0 )
+		{
+			if ( Positions.back() < RangeStart )
+			{
+				RangeStart = Positions.back();
+			}
+			if ( Positions.back() + (int64_t)View.Size > RangeEnd )
+			{
+				RangeEnd = Positions.back() + (int64_t)View.Size;
+			}
+		}
+
+		Views.push_back( View );
+	}
+
+	if ( RangeEnd == 0 )
+	{
+		// Only timestamps with empty data, loaded !
+		return ((int)Views.size() == NumberOfFrames);
+	}
+
+	if ( OpenRawFile() == false )
+	{
+		Views.clear();
+		return false;
+	}
+
+	if ( FollowMode == true && WaitForRawData( RangeEnd ) == false )
+	{
+		// Frames are not written yet
+		Views.clear();
+		return false;
+	}
+
+	// Views of the previous call may still use the buffer
+	if ( FramesArena == nullptr || FramesArena.use_count() > 1 )
+	{
+		FramesArena = std::make_shared< std::vector<unsigned char> >();
+	}
+
+	size_t RangeSize = (size_t)(RangeEnd - RangeStart);
+	FramesArena->resize( RangeSize );
+
+	// One large read for all frames (decoded in parallel for compressed raw files)
+	if ( ReadRawData( &(*FramesArena)[0], RangeSize, RangeStart ) == false )
+	{
+		Views.clear();
+		return false;
+	}
+
+	if ( fRaw.IsPipeOpened() == true )
+	{
+		// Current Index is now the one after the range
+		CurrentIndex = (int)(RangeEnd/(int64_t)FrameSize);
+	}
+
+	for( size_t i = 0; i < Views.size(); i++ )
+	{
+		if ( Views[i].Size > 0 )
+		{
+			Views[i].Data = &(*FramesArena)[(size_t)(Positions[i] - RangeStart)];
+			Views[i].Holder = FramesArena;
+		}
+	}
+
+	return ((int)Views.size() == NumberOfFrames);
+}
+
+/** @brief Load consecutive frames starting at a specific timestamp (see GetFrames). The current line is the
+ *		   line of the first frame.
+ *
+ * @param FirstTimestamp [in] Timestamp of the first frame.
+ * @param NumberOfFrames [in] Number of frames to load.
+ * @param Views [out] Views on the loaded frames.
+ * @return True if NumberOfFrames frames were loaded.
+ */
+bool ReadTimestampRawFile::LoadFrames( const TimeB &FirstTimestamp, int NumberOfFrames, std::vector<FrameView>& Views )
+{
+	Views.clear();
+
+	if ( GetDataForTimestamp( FirstTimestamp ) == false )
+	{
+		// Can not get data
+		return false;
+	}
+
+	// Get corresponding frame index
+	int FrameIndex = GetFrameNumber();
+	if( FrameIndex >= 0 )
+	{
+		return GetFrames( FrameIndex, NumberOfFrames, Views );
+	}
+
+	return false;
+}
+
+/** @brief Load consecutive frames starting at a specific timestamp using the index and a match policy (see GetFrames).
+ *
+ * @param FirstTimestamp [in] Timestamp of the first frame.
+ * @param NumberOfFrames [in] Number of frames to load.
+ * @param Views [out] Views on the loaded frames.
+ * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+ * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return True if NumberOfFrames frames were loaded.
+ */
+bool ReadTimestampRawFile::LoadFrames( const TimeB &FirstTimestamp, int NumberOfFrames, std::vector<FrameView>& Views, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	Views.clear();
+
+	if ( GetDataForTimestamp( FirstTimestamp, Policy, ToleranceInMs ) == false )
+	{
+		// Can not get data
+		return false;
+	}
+
+	// Get corresponding frame index
+	int FrameIndex = GetFrameNumber();
+	if( FrameIndex >= 0 )
+	{
+		return GetFrames( FrameIndex, NumberOfFrames, Views );
+	}
+
+	return false;
+}
+
+/** @brief Map the raw file if it is a usual file. The file is mapped again if it grew.
+ *
+ * @param RequiredSize [in] Size of the raw file needed by the caller.
+ * @return True if the mapping contains at least RequiredSize bytes.
+ */
+bool ReadTimestampRawFile::MapRawFile( int64_t RequiredSize )
+{
+	if ( RawMapping != nullptr && RawMapping->GetSize() >= RequiredSize )
+	{
+		return true;
+	}
+
+	// Only usual files with frames stored as is can be mapped
+	if ( DataFile::FileOrFolderExists( RawFileName.c_str() ) == false || OpenRawFile() == false || IsPlainRawFile() == false )
+	{
+		return false;
+	}
+
+	if ( FollowMode == true && WaitForRawData( RequiredSize ) == false )
+	{
+		return false;
+	}
+
+	// Views on the previous mapping keep it alive
+	std::shared_ptr<MappedFile> NewMapping = std::make_shared<MappedFile>();
+	if ( NewMapping->Open( RawFileName ) == false )
+	{
+		return false;
+	}
+	RawMapping = NewMapping;
+
+	return (RawMapping->GetSize() >= RequiredSize);
+}
+
+/** @brief Open the raw file if needed: a compressed raw file (see CompressedRawFile) is opened
+ *		   in CompressedRaw, a packed depth file (see PackedDepthFile) in PackedRaw, a file with an offset
+ *		   table (see VariableSizeRawFile) in VariableRaw, other raw files (usual or compressed with 7z) in fRaw.
+ *
+ * @return True if the raw file is opened.
+ */
+bool ReadTimestampRawFile::OpenRawFile()
+{
+	if ( fRaw.IsOpen() == true || IsPlainRawFile() == false )
+	{
+		return true;
+	}
+
+	if ( RawFormat == UnknownRawFileFormat )
+	{
+		// Probe the file, once
+		if ( VariableSizeRawFile::IsVariableSizeRawFile( RawFileName ) == true )
+		{
+			RawFormat = VariableSizeRawFileFormat;
+		}
+		else if ( PackedDepthFile::IsPackedDepthFile( RawFileName ) == true )
+		{
+			RawFormat = PackedDepthFileFormat;
+		}
+		else if ( CompressedRawFile::IsCompressedRawFile( RawFileName ) == true )
+		{
+			RawFormat = CompressedRawFileFormat;
+		}
+		else
+		{
+			RawFormat = PlainRawFileFormat;
+		}
+	}
+
+	switch( RawFormat )
+	{
+		case VariableSizeRawFileFormat:
+		{
+			std::unique_ptr<VariableSizeRawFile> NewVariableRaw( new VariableSizeRawFile );
+			if ( NewVariableRaw->Open( RawFileName, FrameSize ) == false )
+			{
+				return false;
+			}
+			NewVariableRaw->SetDecoder( VariableFrameDecoder );
+			NewVariableRaw->SetNumberOfThreads( NumberOfDecodingThreads );
+			VariableRaw = std::move( NewVariableRaw );
+			return true;
+		}
+
+		case PackedDepthFileFormat:
+		{
+			std::unique_ptr<PackedDepthFile> NewPackedRaw( new PackedDepthFile );
+			if ( NewPackedRaw->Open( RawFileName, FrameSize ) == false )
+			{
+				return false;
+			}
+			PackedRaw = std::move( NewPackedRaw );
+			return true;
+		}
+
+		case CompressedRawFileFormat:
+		{
+			std::unique_ptr<CompressedRawFile> NewCompressedRaw( new CompressedRawFile );
+			if ( NewCompressedRaw->Open( RawFileName, FrameSize ) == false )
+			{
+				return false;
+			}
+			CompressedRaw = std::move( NewCompressedRaw );
+			return true;
+		}
+
+		default:
+			if ( RawFileIsCompressed == true )
+			{
+				// Known to be compressed, no failed opening of the usual file
+				return fRaw.OpenCompressedVersion( RawFileName.c_str(), DataFile::READ_MODE );
+			}
+			return fRaw.Open( RawFileName.c_str(), DataFile::READ_MODE );
+	}
+}
+
+/** @brief Get the format of the raw file. The raw file is opened if needed.
+ *
+ * @return The format, UnknownRawFileFormat if the raw file can not be opened.
+ */
+ReadTimestampRawFile::RawFileFormat ReadTimestampRawFile::GetRawFileFormat()
+{
+	if ( OpenRawFile() == false )
+	{
+		return UnknownRawFileFormat;
+	}
+
+	return RawFormat;
+}
+
+/** @brief Read (or decode) data of the raw file at a position, without using the current position of fRaw.
+ *
+ * @param Buffer [out] Buffer of Size bytes.
+ * @param Size [in] Size to read, a multiple of FrameSize.
+ * @param Position [in] Position in the uncompressed raw data, a multiple of FrameSize.
+ * @return True if Size bytes were read.
+ */
+bool ReadTimestampRawFile::ReadRawData( void * Buffer, size_t Size, int64_t Position )
+{
+	if ( CompressedRaw != nullptr )
+	{
+		return CompressedRaw->DecodeFrames( Position/(int64_t)FrameSize, (int64_t)Size/(int64_t)FrameSize, (unsigned char*)Buffer );
+	}
+
+	if ( VariableRaw != nullptr )
+	{
+		return VariableRaw->DecodeFrames( Position/(int64_t)FrameSize, (int64_t)Size/(int64_t)FrameSize, (unsigned char*)Buffer );
+	}
+
+	if ( PackedRaw != nullptr )
+	{
+		// Unpacked directly in the buffer
+		return PackedRaw->ReadFrames( Position/(int64_t)FrameSize, (int64_t)Size/(int64_t)FrameSize, (uint16_t*)Buffer );
+	}
+
+	return (fRaw.ReadAt( Buffer, Size, Position ) == Size);
+}
+
+/** @brief Locate a frame in the raw file and set NumberOfSubFrames (always 1 in SimpleFrameMode). In SubFramesMode,
+ *		   the line of the frame is searched in the index (the current line first) and its subframes follow all the
+ *		   subframes of the previous lines (see TimestampIndex::GetSubFrameOffset).
+ *
+ * @param WantedIndex [in] Frame number in the raw file.
+ * @param FirstSubFrame [out] Position of the frame in the raw file, in number of (sub)frames.
+ * @return False if the frame could not be located.
+ */
+bool ReadTimestampRawFile::LocateFrame( int WantedIndex, int64_t &FirstSubFrame )
+{
+	if ( Mode != SubFramesMode )
+	{
+		// In simple mode, there is alsways a frame
+		NumberOfSubFrames = 1;
+		FirstSubFrame = (int64_t)(WantedIndex - StartingFrame);
+		return true;
+	}
+
+	int Entry = -1;
+	if ( BuildIndex() == true )
+	{
+		Entry = Index.FindFrameNumber( WantedIndex, CurrentIndexEntry );
+		if ( Entry < 0 && FollowMode == true && UpdateIndex() == true )
+		{
+			// Line may have been written since
+			Entry = Index.FindFrameNumber( WantedIndex, CurrentIndexEntry );
+		}
+	}
+
+	if ( Entry < 0 || Index[Entry].NumberOfSubFrames < 0 )
+	{
+		// Could not find subframe number
+		NumberOfSubFrames = 0;
+		fprintf( stderr, "Could not retrieve number of subFrame in SubFramesMode\n" );
+		return false;
+	}
+
+	NumberOfSubFrames = Index[Entry].NumberOfSubFrames;
+	FirstSubFrame = Index.GetSubFrameOffset( (size_t)Entry );
+
+	return true;
+}
+
+/** @brief Set the decoder of the frames of variable size raw files (see VariableSizeRawFile), used
+ *		   when the raw file has an offset table. Frames loaded together (GetFrames) are decoded in parallel.
+ *
+ * @param Decoder [in] Decoder of the payloads.
+ * @param NumberOfThreads [in] Number of decoding threads, 0 for the number of hardware threads (default=0).
+ */
+void ReadTimestampRawFile::SetFrameDecoder( const FrameDecoder& Decoder, unsigned int NumberOfThreads /* = 0 */ )
+{
+	VariableFrameDecoder = Decoder;
+	NumberOfDecodingThreads = NumberOfThreads;
+
+	if ( VariableRaw != nullptr )
+	{
+		VariableRaw->SetDecoder( VariableFrameDecoder );
+		VariableRaw->SetNumberOfThreads( NumberOfDecodingThreads );
+	}
+}
+
+/** @brief Use a cache for frames read by GetFrame. The cache can be shared with other readers.
+ *
+ * @param NewCache [in] The cache, an empty pointer disables caching.
+ */
+void ReadTimestampRawFile::SetFrameCache( const std::shared_ptr<FrameCache>& NewCache )
+{
+	Cache = NewCache;
+	CacheFileId = 0;
+
+	if ( Cache != nullptr )
+	{
+		CacheFileId = Cache->RegisterFile( RawFileName );
+	}
+}
+
+/** @brief Add the content of FrameData in the frame cache, if any.
+ *
+ * @param Index [in] Zero based index of the frame in the raw file.
+ * @param LoadSize [in] Size of data in FrameData.
+ */
+void ReadTimestampRawFile::AddFrameToCache( int Index, int LoadSize )
+{
+	if ( Cache == nullptr )
+	{
+		return;
+	}
+
+	std::shared_ptr<CachedFrame> Frame = std::make_shared<CachedFrame>();
+	Frame->NumberOfSubFrames = NumberOfSubFrames;
+	Frame->Data.assign( FrameData, FrameData + LoadSize );
+
+	Cache->Insert( CacheFileId, Index, Frame );
+}
+
+/** @brief Set follow mode for the timestamp file and the raw file (see ReadTimestamp::SetFollowMode).
+ *		   In follow mode, GetFrame waits for frames not fully written yet.
+ *
+ * @param Follow [in] Activate or deactivate follow mode.
+ * @param TimeoutInMs [in] Maximum waiting time for new data in each call (default=DefaultFollowTimeoutInMs).
+ * @return True if the mode has been set.
+ */
+bool ReadTimestampRawFile::SetFollowMode( bool Follow, unsigned int TimeoutInMs /* = DefaultFollowTimeoutInMs */ )
+{
+	RawWatcher.Stop();
+
+	if ( ReadTimestampFile::SetFollowMode( Follow, TimeoutInMs ) == false )
+	{
+		return false;
+	}
+
+	if ( Follow == false )
+	{
+		return true;
+	}
+
+	// Compressed raw files are written at once (offset table at the end), packed ones are converted,
+	// variable size ones load new entries of their offset table when needed
+	if ( OpenRawFile() == false || (IsPlainRawFile() == false && VariableRaw == nullptr) || fRaw.IsPipeOpened() == true )
+	{
+		fprintf( stderr, "Only usual files can be followed ('%s').\n", RawFileName.c_str() );
+		ReadTimestampFile::SetFollowMode( false );
+		return false;
+	}
+
+	if ( VariableRaw != nullptr )
+	{
+		// The entry of a frame is written after its payload
+		return RawWatcher.Watch( VariableSizeRawFile::GetOffsetTableFileName( RawFileName ) );
+	}
+
+	return RawWatcher.Watch( RawFileName );
+}
+
+/** @brief In follow mode, wait until the raw file is large enough (its offset table for variable size raw files).
+ *
+ * @param RequiredSize [in] Expected size of the raw file (of the decoded frames for variable size raw files).
+ * @return True if the raw file reached RequiredSize in time.
+ */
+bool ReadTimestampRawFile::WaitForRawData( int64_t RequiredSize )
+{
+	std::chrono::steady_clock::time_point Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(FollowTimeoutInMs);
+	std::string WatchedFileName = RawFileName;
+
+	if ( VariableRaw != nullptr )
+	{
+		// Frames of variable size raw files are available once their entries are in the offset table
+		int64_t NumberOfFrames = (RequiredSize + (int64_t)FrameSize - 1)/(int64_t)FrameSize;
+		RequiredSize = (int64_t)sizeof(FrameOffsetTableHeader) + NumberOfFrames*(int64_t)sizeof(FrameOffsetEntry);
+		WatchedFileName = VariableSizeRawFile::GetOffsetTableFileName( RawFileName );
+	}
+
+	while( FileWatcher::GetFileSize( WatchedFileName ) < RequiredSize )
+	{
+		if ( RawWatcher.WaitForChange( Deadline ) == false )
+		{
+			return false;
+		}
+	}
+
+	// Previous reads may have reached the end of the file (variable size raw files use positional reads)
+	if ( fRaw.IsOpen() == true )
+	{
+		clearerr( fRaw );
+	}
 
 	return true;
 }
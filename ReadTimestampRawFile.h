@@ -9,6 +9,13 @@
 #define __READ_TIMESTAMP_RAW_FILE__
 
 #include "ReadTimestampFile.h"
+#include "FrameCache.h"
+#include "FramePrefetcher.h"
+#include "FrameView.h"
+#include "MappedFile.h"
+#include "CompressedRawFile.h"
+#include "PackedDepthFile.h"
+#include "VariableSizeRawFile.h"
 // Use Omiscid::TemporaryMemoryBuffer
 #include <System/TemporaryMemoryBuffer.h>
 
@@ -29,7 +36,10 @@ namespace MobileRGBD {
  *		  when data at a requested timestamp can contains severals subojects (of the same
  *		  size).
  *		  As for standard timestamped files, textual data could be added at the end
- *		  of each lines.
+ *		  of each lines. The raw file can be a usual file, a 7z archive, a file
+ *		  with independently compressed frames (see CompressedRawFile) or a depth
+ *		  file with 13 bits values (see PackedDepthFile) or a file with variable size
+ *		  frames (encoded images, see VariableSizeRawFile).
  *		  Here an example for a Kinect2 video stream:
  *		  @code
 		  1432037186.049 1, 20323761405951
@@ -47,6 +57,20 @@ namespace MobileRGBD {
 class ReadTimestampRawFile : public ReadTimestampFile
 {
 public:
+	/** @enum ReadTimestampRawFile::RawFileFormat
+	 *  @brief Storage format of the raw file.
+	 */
+	enum RawFileFormat
+	{
+		UnknownRawFileFormat = -1,					/*!< @brief Format probed when the raw file is opened, default value. */
+		PlainRawFileFormat = 0,						/*!< @brief Usual raw file (or its 7z version). */
+		CompressedRawFileFormat = 1,				/*!< @brief Independently compressed frames (see CompressedRawFile). */
+		PackedDepthFileFormat = 2,					/*!< @brief Depth with 13 bits values (see PackedDepthFile). */
+		VariableSizeRawFileFormat = 3				/*!< @brief Variable size frames (see VariableSizeRawFile). */
+	};
+
+	static const unsigned int DefaultNumberOfPrefetchedFrames;	/*!< @brief Default number of frames read in advance when prefetching (8). */
+
 	/** @brief Constructor. Create a ReadTimestampRawFile object using specific files (timestamp + raw).
 	 *
 	 * @param WorkingFile [in] Name of the timestamp file to open (even with '/' separator under Windows as Windows handles it also as a folder/file separator).
@@ -96,13 +120,199 @@ public:
 	 */
 	virtual bool LoadFrame( const TimeB &RequestTimestamp );
 
-	/** @brief Get frame for a specific index
+	/** @brief Load frame for a specific timestamp using the index and a match policy
+	 *
+	 * @param RequestedTimestamp [in] Requested timestamp.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if the full frame was loaded.
+	 */
+	virtual bool LoadFrame( const TimeB &RequestTimestamp, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
+	/** @brief Get frame for a specific index. In SubFramesMode, WantedIndex is the frame number of a line
+	 *		   and its subframes are located using the index (built if needed).
 	 *
 	 * @param WantedIndex [in] Frame number in the raw file.
 	 * @return True if the full frame was loaded.
 	 */
 	bool GetFrame( int WantedIndex );
 
+	/** @brief Get a frame of 16 bits values (depth, infrared) as floats, in SimpleFrameMode. Packed depth files
+	 *		   are unpacked directly in Output, other raw files are loaded in FrameBuffer (see GetFrame) and converted.
+	 *
+	 * @param WantedIndex [in] Frame number in the raw file.
+	 * @param Output [out] Buffer of FrameSize/2 floats.
+	 * @param Scale [in] Scale of the values, 0.001 gives meters for depth frames (default=1).
+	 * @return True if the full frame was loaded.
+	 */
+	bool GetFrame( int WantedIndex, float * Output, float Scale = 1.0f );
+
+	/** @brief Get a region of a frame in SimpleFrameMode, reading only its rows: one vectored positional read
+	 *		   for usual raw files (see DataFile::ReadSegmentsAt). Frames already in memory are not read again,
+	 *		   compressed raw files are decoded with GetFrame. The current frame (FrameData) does not change.
+	 *
+	 * @param WantedIndex [in] Frame number in the raw file.
+	 * @param ROI [in] Region in pixels, inside the frame.
+	 * @param FrameWidth [in] Width of the frames in pixels, the height is deduced from FrameSize.
+	 * @param BytesPerPixel [in] Size of each pixel.
+	 * @param Output [out] Buffer of ROI.Width*ROI.Height*BytesPerPixel bytes, rows of the region one after the other.
+	 * @return True if the full region was read.
+	 */
+	bool GetFrameROI( int WantedIndex, const FrameROI& ROI, int FrameWidth, int BytesPerPixel, void * Output );
+
+	/** @brief Get a read only view on a frame, directly in the mapping of the raw file (no copy). Compressed raw files
+	 *		   can not be mapped, the frame is then read and copied in a buffer owned by the view.
+	 *		   Like GetFrame, subframes are located using the index in SubFramesMode.
+	 *
+	 * @param WantedIndex [in] Frame number in the raw file.
+	 * @param View [out] View on the frame, its timestamp is the current one.
+	 * @return True if the full frame is available.
+	 */
+	bool GetFrameView( int WantedIndex, FrameView& View );
+
+	/** @brief Get a read only view on the frame of a specific timestamp (see GetFrameView).
+	 *
+	 * @param RequestedTimestamp [in] Requested timestamp.
+	 * @param View [out] View on the frame.
+	 * @return True if the full frame is available.
+	 */
+	bool LoadFrameView( const TimeB &RequestTimestamp, FrameView& View );
+
+	/** @brief Get a read only view on the frame of a specific timestamp using the index and a match policy (see GetFrameView).
+	 *
+	 * @param RequestedTimestamp [in] Requested timestamp.
+	 * @param View [out] View on the frame.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if the full frame is available.
+	 */
+	bool LoadFrameView( const TimeB &RequestTimestamp, FrameView& View, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
+	/** @brief Load consecutive frames with a single read of the raw file. Frames are read in a buffer shared by their
+	 *		   views, reused when all views of the previous call are released. The index is built if needed,
+	 *		   the current line does not change.
+	 *
+	 * @param FirstIndex [in] Frame number of the first frame in the raw file.
+	 * @param NumberOfFrames [in] Number of frames (i.e. of lines with a frame number) to load.
+	 * @param Views [out] Views on the loaded frames, with their timestamps. May contain less frames at the end of the file.
+	 * @return True if NumberOfFrames frames were loaded.
+	 */
+	bool GetFrames( int FirstIndex, int NumberOfFrames, std::vector<FrameView>& Views );
+
+	/** @brief Load consecutive frames starting at a specific timestamp (see GetFrames). The current line is the
+	 *		   line of the first frame.
+	 *
+	 * @param FirstTimestamp [in] Timestamp of the first frame.
+	 * @param NumberOfFrames [in] Number of frames to load.
+	 * @param Views [out] Views on the loaded frames.
+	 * @return True if NumberOfFrames frames were loaded.
+	 */
+	bool LoadFrames( const TimeB &FirstTimestamp, int NumberOfFrames, std::vector<FrameView>& Views );
+
+	/** @brief Load consecutive frames starting at a specific timestamp using the index and a match policy (see GetFrames).
+	 *
+	 * @param FirstTimestamp [in] Timestamp of the first frame.
+	 * @param NumberOfFrames [in] Number of frames to load.
+	 * @param Views [out] Views on the loaded frames.
+	 * @param Policy [in] How to match the timestamp (see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if NumberOfFrames frames were loaded.
+	 */
+	bool LoadFrames( const TimeB &FirstTimestamp, int NumberOfFrames, std::vector<FrameView>& Views, TimestampIndex::MatchPolicy Policy, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
+	/** @brief Read one frame line out of Step with GetNextFrame. Skipped frames are neither read nor decoded,
+	 *		   the next frame is reached using the index and a positional read. Prefetching follows the decimation.
+	 *
+	 * @param Step [in] Number of frame lines from one read frame to the next one, 1 reads all frames.
+	 */
+	void SetDecimation( unsigned int Step );
+
+	/** @brief Read frames at a target rate with GetNextFrame: the first frame at or after each period (see SetDecimation).
+	 *
+	 * @param FramesPerSecond [in] Target rate, 0 reads all frames.
+	 */
+	void SetDecimationRate( double FramesPerSecond );
+
+	/** @brief Load the next frame according to the decimation (see SetDecimation), or the first frame of the
+	 *		   file if there is no current line. The index is built if needed, the current line is the line of the frame.
+	 *
+	 * @return True if a frame was loaded, false at the end of the file.
+	 */
+	bool GetNextFrame();
+
+	/** @brief Give the format of the raw file (from a session manifest for instance), the file is then
+	 *		   opened without probing. Must be called before the raw file is opened.
+	 *
+	 * @param Format [in] Format of the raw file (UnknownRawFileFormat to probe it).
+	 */
+	void SetRawFileFormat( RawFileFormat Format ) { RawFormat = Format; }
+
+	/** @brief Get the format of the raw file. The raw file is opened if needed.
+	 *
+	 * @return The format, UnknownRawFileFormat if the raw file can not be opened.
+	 */
+	RawFileFormat GetRawFileFormat();
+
+	/** @brief Give the number of the first frame of the raw file (from a session manifest for instance),
+	 *		   Reinit does not read it any more in the first line of the timestamp file.
+	 *
+	 * @param eStartingFrame [in] Number of the first frame.
+	 */
+	void SetStartingFrame( int eStartingFrame ) { StartingFrame = eStartingFrame; StartingFrameIsKnown = true; }
+
+	/** @brief Say that the usual raw file is compressed with 7z (from a session manifest for instance), its
+	 *		   7z version is then opened directly, without trying the usual file. Must be called before the raw file is opened.
+	 *
+	 * @param eRawFileIsCompressed [in] The raw file is compressed.
+	 */
+	void SetRawFileIsCompressed( bool eRawFileIsCompressed ) { RawFileIsCompressed = eRawFileIsCompressed; }
+
+	/** @brief Set the decoder of the frames of variable size raw files (see VariableSizeRawFile), used
+	 *		   when the raw file has an offset table. Frames loaded together (GetFrames) are decoded in parallel.
+	 *
+	 * @param Decoder [in] Decoder of the payloads.
+	 * @param NumberOfThreads [in] Number of decoding threads, 0 for the number of hardware threads (default=0).
+	 */
+	void SetFrameDecoder( const FrameDecoder& Decoder, unsigned int NumberOfThreads = 0 );
+
+	/** @brief Use a cache for frames read by GetFrame. The cache can be shared with other readers.
+	 *
+	 * @param NewCache [in] The cache, an empty pointer disables caching.
+	 */
+	void SetFrameCache( const std::shared_ptr<FrameCache>& NewCache );
+
+	/** @brief Create a cache for frames read by this reader.
+	 *
+	 * @param BudgetInBytes [in] Maximum size of the cached frames (default=FrameCache::DefaultBudgetInBytes).
+	 */
+	void EnableFrameCache( size_t BudgetInBytes = FrameCache::DefaultBudgetInBytes ) { SetFrameCache( std::make_shared<FrameCache>( BudgetInBytes ) ); }
+
+	/** @brief Get the frame cache, if any.
+	 */
+	const std::shared_ptr<FrameCache>& GetFrameCache() const { return Cache; }
+
+	/** @brief Read frames in advance in a background thread, following the next lines of the timestamp
+	 *		   file. When a requested frame is already loaded, GetFrame only sets FrameData on it (FrameBuffer
+	 *		   is not filled). Other requests are read as usual and prefetching restarts after them.
+	 *
+	 * @param NumberOfFrames [in] Number of frames read in advance (default=DefaultNumberOfPrefetchedFrames).
+	 * @return True if prefetching started.
+	 */
+	bool EnablePrefetching( unsigned int NumberOfFrames = DefaultNumberOfPrefetchedFrames );
+
+	/** @brief Stop reading frames in advance.
+	 */
+	void DisablePrefetching();
+
+	/** @brief Set follow mode for the timestamp file and the raw file (see ReadTimestamp::SetFollowMode).
+	 *		   In follow mode, GetFrame waits for frames not fully written yet.
+	 *
+	 * @param Follow [in] Activate or deactivate follow mode.
+	 * @param TimeoutInMs [in] Maximum waiting time for new data in each call (default=DefaultFollowTimeoutInMs).
+	 * @return True if the mode has been set.
+	 */
+	virtual bool SetFollowMode( bool Follow, unsigned int TimeoutInMs = DefaultFollowTimeoutInMs );
+
 	/** @enum ReadTimestampRawFile::ReadingMode
 	 *  @brief Define single frame mode (for RGB, Depth, ...) et SubFramesMode, i.e. mode where several frames
 	 *		   like bodies or faces are associated with a unique timestamp
@@ -115,17 +325,106 @@ public:
 
 public:
 	Omiscid::TemporaryMemoryBuffer FrameBuffer;		/*!< @brief A growing and autodeleting buffer (from Omiscid. See http://omiscid.gforge.inria.fr/) */
+	const unsigned char * FrameData;				/*!< @brief Data of the current frame: FrameBuffer or a prefetched buffer (valid until the next GetFrame call) */
 	int IndexofFrameBuffer;							/*!< @brief Store starting index of current FrameBuffer */
 	int FrameSize;									/*!< @brief Size of each frame (or subframe) */
 	int StartingFrame;								/*!< @brief Number of the first frame of the file (permits to recontsruct zero based index) */
-	int CurrentIndex;								/*!< @brief Store current frame number in file (to prevent for uneeded fseek in file) */
+	int CurrentIndex;								/*!< @brief Store current frame (or subframe) number in file (to prevent for uneeded fseek in file) */
 
 	unsigned char Mode;								/*!< @brief Store current mode : single or subframes mode */
 	int NumberOfSubFrames;							/*!< @brief When processing in SubFramesMode, store the number of subframes for the current timestamp */
 
 protected:
+	/** @brief In follow mode, wait until the raw file is large enough (its offset table for variable size raw files).
+	 *
+	 * @param RequiredSize [in] Expected size of the raw file (of the decoded frames for variable size raw files).
+	 * @return True if the raw file reached RequiredSize in time.
+	 */
+	bool WaitForRawData( int64_t RequiredSize );
+
+	/** @brief Map the raw file if it is a usual file. The file is mapped again if it grew.
+	 *
+	 * @param RequiredSize [in] Size of the raw file needed by the caller.
+	 * @return True if the mapping contains at least RequiredSize bytes.
+	 */
+	bool MapRawFile( int64_t RequiredSize );
+
+	/** @brief Open the raw file if needed: a compressed raw file (see CompressedRawFile) is opened
+	 *		   in CompressedRaw, a packed depth file (see PackedDepthFile) in PackedRaw, a file with an offset
+	 *		   table (see VariableSizeRawFile) in VariableRaw, other raw files (usual or compressed with 7z) in fRaw.
+	 *
+	 * @return True if the raw file is opened.
+	 */
+	bool OpenRawFile();
+
+	/** @brief Return true if the raw file is read with fRaw, i.e. frames are stored as is.
+	 */
+	bool IsPlainRawFile() const { return CompressedRaw == nullptr && PackedRaw == nullptr && VariableRaw == nullptr; }
+
+	/** @brief Read (or decode) data of the raw file at a position, without using the current position of fRaw.
+	 *
+	 * @param Buffer [out] Buffer of Size bytes.
+	 * @param Size [in] Size to read, a multiple of FrameSize.
+	 * @param Position [in] Position in the uncompressed raw data, a multiple of FrameSize.
+	 * @return True if Size bytes were read.
+	 */
+	bool ReadRawData( void * Buffer, size_t Size, int64_t Position );
+
+	/** @brief Locate a frame in the raw file and set NumberOfSubFrames (always 1 in SimpleFrameMode). In SubFramesMode,
+	 *		   the line of the frame is searched in the index (the current line first) and its subframes follow all the
+	 *		   subframes of the previous lines (see TimestampIndex::GetSubFrameOffset).
+	 *
+	 * @param WantedIndex [in] Frame number in the raw file.
+	 * @param FirstSubFrame [out] Position of the frame in the raw file, in number of (sub)frames.
+	 * @return False if the frame could not be located.
+	 */
+	bool LocateFrame( int WantedIndex, int64_t &FirstSubFrame );
+
+	/** @brief Add the content of FrameData in the frame cache, if any.
+	 *
+	 * @param Index [in] Zero based index of the frame in the raw file.
+	 * @param LoadSize [in] Size of data in FrameData.
+	 */
+	void AddFrameToCache( int Index, int LoadSize );
+
+	/** @brief Copy a region of a frame in memory.
+	 *
+	 * @param Frame [in] Frame data.
+	 * @param ROI [in] Region in pixels.
+	 * @param RowSize [in] Size of a row of the frame.
+	 * @param BytesPerPixel [in] Size of each pixel.
+	 * @param Output [out] Rows of the region.
+	 */
+	static void CopyFrameROI( const unsigned char * Frame, const FrameROI& ROI, size_t RowSize, int BytesPerPixel, unsigned char * Output );
+
+	/** @brief Restart prefetching after the current line of the timestamp file.
+	 */
+	void RestartPrefetching();
+
+	/** @brief With a decimation rate, minimal timestamp of the frame after the current line (see GetNextFrame).
+	 *		   A value left by another current line is replaced by one period after the current timestamp.
+	 */
+	HighResTimestamp GetNextDecimationTimestamp() const;
+
 	DataFile fRaw;									/*!< @brief DataFile object to read usual or compressed raw files. */
 	std::string RawFileName;						/*!< @brief Store name of the raw file */
+	FileWatcher RawWatcher;							/*!< @brief In follow mode, wait for modifications of the raw file. */
+	std::shared_ptr<FrameCache> Cache;				/*!< @brief Cache of frames, may be shared with other readers (empty if none). */
+	unsigned int CacheFileId;						/*!< @brief Identifier of the raw file in the cache. */
+	std::unique_ptr<FramePrefetcher> Prefetcher;	/*!< @brief Read frames in advance (empty if not prefetching). */
+	std::shared_ptr<MappedFile> RawMapping;			/*!< @brief Mapping of the raw file for frame views, shared with the views. */
+	std::shared_ptr< std::vector<unsigned char> > FramesArena;	/*!< @brief Buffer of GetFrames, shared with the views. */
+	std::unique_ptr<CompressedRawFile> CompressedRaw;			/*!< @brief Raw file with compressed frames, used instead of fRaw (empty if none). */
+	std::unique_ptr<PackedDepthFile> PackedRaw;					/*!< @brief Depth file with packed values, used instead of fRaw (empty if none). */
+	std::unique_ptr<VariableSizeRawFile> VariableRaw;			/*!< @brief Raw file with variable size frames, used instead of fRaw (empty if none). */
+	FrameDecoder VariableFrameDecoder;				/*!< @brief Decoder of the frames of VariableRaw. */
+	unsigned int NumberOfDecodingThreads;			/*!< @brief Number of threads decoding frames of VariableRaw. */
+	unsigned int DecimationStep;					/*!< @brief GetNextFrame reads one frame line out of DecimationStep. */
+	int64_t DecimationPeriodInNs;					/*!< @brief If not 0, GetNextFrame reads one frame per period instead. */
+	HighResTimestamp NextDecimationTimestamp;		/*!< @brief Minimal timestamp of the next frame with a decimation rate. */
+	RawFileFormat RawFormat;						/*!< @brief Format of the raw file, probed by OpenRawFile if unknown. */
+	bool StartingFrameIsKnown;						/*!< @brief StartingFrame was given by SetStartingFrame. */
+	bool RawFileIsCompressed;						/*!< @brief Only the 7z version of a usual raw file is opened (see SetRawFileIsCompressed). */
 };
 
 } // namespace MobileRGBD
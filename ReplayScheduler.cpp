@@ -0,0 +1,206 @@
+/**
+ * @file ReplayScheduler.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "ReplayScheduler.h"
+
+#include <thread>
+
+using namespace std;
+using namespace MobileRGBD;
+
+const int64_t ReplayScheduler::DefaultSpinTimeInNs = 200*1000;			/*!< @brief Default time spent spinning before a deadline instead of sleeping (200us). */
+const int64_t ReplayScheduler::DefaultLateThresholdInNs = 5*HighResTimestamp::NanosecondsPerMillisecond;	/*!< @brief Default lateness from which a frame is late (5ms). */
+
+/** @brief Constructor.
+ *
+ * @param eSpeed [in] Replay speed, 1 for the recorded rate, 0 (or less) for as fast as possible (default=1).
+ * @param ePolicy [in] Policy for late frames (default=DeliverLate).
+ * @param eLateThresholdInNs [in] Lateness from which a frame is late (default=DefaultLateThresholdInNs).
+ */
+ReplayScheduler::ReplayScheduler( double eSpeed /* = 1.0 */, LatePolicy ePolicy /* = DeliverLate */, int64_t eLateThresholdInNs /* = DefaultLateThresholdInNs */ )
+{
+	Speed = eSpeed;
+	Policy = ePolicy;
+	LateThresholdInNs = eLateThresholdInNs;
+	SpinTimeInNs = DefaultSpinTimeInNs;
+	Started = false;
+}
+
+/** @brief Change the replay speed. The change applies from now, past frames are not replayed again.
+ *
+ * @param eSpeed [in] Replay speed, 1 for the recorded rate, 0 (or less) for as fast as possible.
+ */
+void ReplayScheduler::SetSpeed( double eSpeed )
+{
+	if ( Started == true )
+	{
+		// New origin: the last frame, at its deadline with the previous speed
+		if ( Speed > 0.0 )
+		{
+			ClockOrigin += chrono::nanoseconds( (int64_t)((double)(LastTimestamp - TimestampOrigin)/Speed) );
+		}
+		else
+		{
+			ClockOrigin = Clock::now();
+		}
+		TimestampOrigin = LastTimestamp;
+	}
+
+	Speed = eSpeed;
+}
+
+/** @brief Change the policy for late frames.
+ *
+ * @param ePolicy [in] Policy for late frames.
+ * @param eLateThresholdInNs [in] Lateness from which a frame is late (default=DefaultLateThresholdInNs).
+ */
+void ReplayScheduler::SetLatePolicy( LatePolicy ePolicy, int64_t eLateThresholdInNs /* = DefaultLateThresholdInNs */ )
+{
+	Policy = ePolicy;
+	LateThresholdInNs = eLateThresholdInNs;
+}
+
+/** @brief Wait for the deadline of a frame.
+ *
+ * @param Timestamp [in] Recorded timestamp of the frame.
+ * @return False if the frame must be dropped (DropLate policy).
+ */
+bool ReplayScheduler::Schedule( const HighResTimestamp& Timestamp )
+{
+	if ( Started == false )
+	{
+		// The first frame starts the replay clock
+		Started = true;
+		ClockOrigin = Clock::now();
+		TimestampOrigin = Timestamp;
+		LastTimestamp = Timestamp;
+		Statistics.NumberOfFrames++;
+		return true;
+	}
+
+	LastTimestamp = Timestamp;
+
+	if ( Speed <= 0.0 )
+	{
+		Statistics.NumberOfFrames++;
+		return true;
+	}
+
+	Clock::time_point Deadline = ClockOrigin + chrono::nanoseconds( (int64_t)((double)(Timestamp - TimestampOrigin)/Speed) );
+	int64_t LatenessInNs = chrono::duration_cast<chrono::nanoseconds>( Clock::now() - Deadline ).count();
+
+	if ( LatenessInNs > LateThresholdInNs )
+	{
+		switch( Policy )
+		{
+			case DropLate:
+				Statistics.NumberOfDroppedFrames++;
+				return false;
+
+			case DeliverLate:
+				// Keep the recorded gaps from this frame on
+				ClockOrigin += chrono::nanoseconds( LatenessInNs );
+				break;
+
+			case CatchUp:
+				// Following deadlines are also passed, no wait until we are back on schedule
+				break;
+		}
+		Statistics.NumberOfLateFrames++;
+	}
+	else if ( LatenessInNs < 0 )
+	{
+		WaitUntil( Deadline );
+		LatenessInNs = chrono::duration_cast<chrono::nanoseconds>( Clock::now() - Deadline ).count();
+	}
+
+	Statistics.NumberOfFrames++;
+	Statistics.TotalLatenessInNs += LatenessInNs;
+	if ( LatenessInNs > Statistics.MaxLatenessInNs )
+	{
+		Statistics.MaxLatenessInNs = LatenessInNs;
+	}
+
+	return true;
+}
+
+/** @brief Get the next frame of a playback at its deadline (see PlaybackEngine::GetNextEvent).
+ *
+ * @param Engine [in] The started playback.
+ * @param NextEvent [out] The frame.
+ * @return False at the end of all streams.
+ */
+bool ReplayScheduler::GetNextEvent( PlaybackEngine& Engine, PlaybackEngine::Event& NextEvent )
+{
+	while( Engine.GetNextEvent( NextEvent ) == true )
+	{
+		if ( Schedule( NextEvent.View.Timestamp ) == true )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** @brief Get the next tuple of a playback at the deadline of its master frame (see PlaybackEngine::GetNextTuple).
+ *
+ * @param Engine [in] The started playback.
+ * @param Frames [out] Frame of each stream.
+ * @param SkipIncomplete [in] Skip master frames without a frame of each stream (default=true).
+ * @return False at the end of the master stream.
+ */
+bool ReplayScheduler::GetNextTuple( PlaybackEngine& Engine, vector<FrameView>& Frames, bool SkipIncomplete /* = true */ )
+{
+	size_t MasterStream = Engine.GetMasterStream();
+
+	while( Engine.GetNextTuple( Frames, SkipIncomplete ) == true )
+	{
+		if ( Schedule( Frames[MasterStream].Timestamp ) == true )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** @brief Get the next line of a synchronizer at its deadline (see Synchronizer::GetNextEvent).
+ *		   Frames are loaded after the deadline by the caller, prefer a PlaybackEngine for heavy streams.
+ *
+ * @param Sync [in] The started synchronizer.
+ * @param NextEvent [out] The line.
+ * @return False at the end of all streams.
+ */
+bool ReplayScheduler::GetNextEvent( Synchronizer& Sync, Synchronizer::Event& NextEvent )
+{
+	while( Sync.GetNextEvent( NextEvent ) == true )
+	{
+		if ( Schedule( NextEvent.Timestamp ) == true )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** @brief Wait until a deadline: sleep, then spin for the last SpinTimeInNs.
+ *
+ * @param Deadline [in] The deadline.
+ */
+void ReplayScheduler::WaitUntil( const Clock::time_point& Deadline )
+{
+	// Sleeping may wake up late (timer slack, scheduling), the end is reached by spinning
+	Clock::time_point WakeUp = Deadline - chrono::nanoseconds( SpinTimeInNs );
+	if ( Clock::now() < WakeUp )
+	{
+		this_thread::sleep_until( WakeUp );
+	}
+
+	while( Clock::now() < Deadline );
+}
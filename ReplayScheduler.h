@@ -0,0 +1,185 @@
+/**
+ * @file ReplayScheduler.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __REPLAY_SCHEDULER_H__
+#define __REPLAY_SCHEDULER_H__
+
+#include <inttypes.h>
+
+#include <vector>
+#include <chrono>
+
+#include "TimestampTools.h"
+#include "PlaybackEngine.h"
+#include "Synchronizer.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct ReplayStatistics ReplayScheduler.h
+ * @brief Lateness of the frames given by a ReplayScheduler. The lateness of a frame is the time between
+ *		  its deadline and its delivery.
+ */
+struct ReplayStatistics
+{
+	uint64_t NumberOfFrames;				/*!< @brief Number of delivered frames. */
+	uint64_t NumberOfLateFrames;			/*!< @brief Number of delivered frames later than the late threshold. */
+	uint64_t NumberOfDroppedFrames;			/*!< @brief Number of frames dropped by the DropLate policy. */
+	int64_t TotalLatenessInNs;				/*!< @brief Sum of the lateness of delivered frames. */
+	int64_t MaxLatenessInNs;				/*!< @brief Maximum lateness of delivered frames. */
+
+	/** @brief Constructor. All values are 0.
+	 */
+	ReplayStatistics() : NumberOfFrames(0), NumberOfLateFrames(0), NumberOfDroppedFrames(0), TotalLatenessInNs(0), MaxLatenessInNs(0) {}
+
+	/** @brief Mean lateness of delivered frames in nanoseconds.
+	 */
+	double GetMeanLatenessInNs() const { return NumberOfFrames == 0 ? 0.0 : (double)TotalLatenessInNs/(double)NumberOfFrames; }
+};
+
+/**
+ * @class ReplayScheduler ReplayScheduler.cpp ReplayScheduler.h
+ * @brief Replay recorded frames at their recorded rate (or faster/slower): each frame is given when the
+ *		  time elapsed since the first frame reaches the recorded offset of its timestamp, divided by the speed.
+ *		  Deadlines are absolute (no drift), the scheduler sleeps until shortly before the deadline then
+ *		  spins for the last microseconds (low jitter). Frames may come from a PlaybackEngine (frames
+ *		  read in advance, the best choice), from a Synchronizer or from any source through Schedule. Example:
+ *		  @code
+		  ReplayScheduler Scheduler( 2.0, ReplayScheduler::DropLate );	// Twice the recorded rate
+		  PlaybackEngine::Event Event;
+		  Engine.Start();
+		  while( Scheduler.GetNextEvent( Engine, Event ) )
+		  {
+			  Publish( Event );
+		  }
+		  fprintf( stderr, "Mean lateness %f ms\n", Scheduler.GetStatistics().GetMeanLatenessInNs()/1e6 );
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class ReplayScheduler
+{
+public:
+	static const int64_t DefaultSpinTimeInNs;			/*!< @brief Default time spent spinning before a deadline instead of sleeping (200us). */
+	static const int64_t DefaultLateThresholdInNs;		/*!< @brief Default lateness from which a frame is late (5ms). */
+
+	/**
+	 * @enum LatePolicy
+	 * @brief What to do with frames given after their deadline (plus the late threshold).
+	 */
+	enum LatePolicy
+	{
+		DeliverLate = 0,		/*!< @brief Deliver late frames, later deadlines are shifted by the lateness (the replay keeps the recorded gaps between frames but lasts longer). */
+		DropLate = 1,			/*!< @brief Drop late frames until the replay is back on schedule. */
+		CatchUp = 2				/*!< @brief Deliver late frames at once, without waiting, until the replay is back on schedule. */
+	};
+
+	/** @brief Constructor.
+	 *
+	 * @param eSpeed [in] Replay speed, 1 for the recorded rate, 0 (or less) for as fast as possible (default=1).
+	 * @param ePolicy [in] Policy for late frames (default=DeliverLate).
+	 * @param eLateThresholdInNs [in] Lateness from which a frame is late (default=DefaultLateThresholdInNs).
+	 */
+	ReplayScheduler( double eSpeed = 1.0, LatePolicy ePolicy = DeliverLate, int64_t eLateThresholdInNs = DefaultLateThresholdInNs );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~ReplayScheduler() {}
+
+	/** @brief Change the replay speed. The change applies from now, past frames are not replayed again.
+	 *
+	 * @param eSpeed [in] Replay speed, 1 for the recorded rate, 0 (or less) for as fast as possible.
+	 */
+	void SetSpeed( double eSpeed );
+
+	/** @brief Get the replay speed.
+	 */
+	double GetSpeed() const { return Speed; }
+
+	/** @brief Change the policy for late frames.
+	 *
+	 * @param ePolicy [in] Policy for late frames.
+	 * @param eLateThresholdInNs [in] Lateness from which a frame is late (default=DefaultLateThresholdInNs).
+	 */
+	void SetLatePolicy( LatePolicy ePolicy, int64_t eLateThresholdInNs = DefaultLateThresholdInNs );
+
+	/** @brief Set the time spent spinning before each deadline (0 to only sleep).
+	 *
+	 * @param eSpinTimeInNs [in] Spinning time.
+	 */
+	void SetSpinTime( int64_t eSpinTimeInNs ) { SpinTimeInNs = eSpinTimeInNs; }
+
+	/** @brief Restart the replay clock, the next frame is given at once. Statistics are kept.
+	 */
+	void Restart() { Started = false; }
+
+	/** @brief Wait for the deadline of a frame.
+	 *
+	 * @param Timestamp [in] Recorded timestamp of the frame.
+	 * @return False if the frame must be dropped (DropLate policy).
+	 */
+	bool Schedule( const HighResTimestamp& Timestamp );
+
+	/** @brief Get the next frame of a playback at its deadline (see PlaybackEngine::GetNextEvent).
+	 *
+	 * @param Engine [in] The started playback.
+	 * @param NextEvent [out] The frame.
+	 * @return False at the end of all streams.
+	 */
+	bool GetNextEvent( PlaybackEngine& Engine, PlaybackEngine::Event& NextEvent );
+
+	/** @brief Get the next tuple of a playback at the deadline of its master frame (see PlaybackEngine::GetNextTuple).
+	 *
+	 * @param Engine [in] The started playback.
+	 * @param Frames [out] Frame of each stream.
+	 * @param SkipIncomplete [in] Skip master frames without a frame of each stream (default=true).
+	 * @return False at the end of the master stream.
+	 */
+	bool GetNextTuple( PlaybackEngine& Engine, std::vector<FrameView>& Frames, bool SkipIncomplete = true );
+
+	/** @brief Get the next line of a synchronizer at its deadline (see Synchronizer::GetNextEvent).
+	 *		   Frames are loaded after the deadline by the caller, prefer a PlaybackEngine for heavy streams.
+	 *
+	 * @param Sync [in] The started synchronizer.
+	 * @param NextEvent [out] The line.
+	 * @return False at the end of all streams.
+	 */
+	bool GetNextEvent( Synchronizer& Sync, Synchronizer::Event& NextEvent );
+
+	/** @brief Get the lateness statistics since the creation (or the last ResetStatistics).
+	 */
+	const ReplayStatistics& GetStatistics() const { return Statistics; }
+
+	/** @brief Reset the lateness statistics.
+	 */
+	void ResetStatistics() { Statistics = ReplayStatistics(); }
+
+protected:
+	typedef std::chrono::steady_clock Clock;	/*!< @brief Monotonic clock of the replay. */
+
+	/** @brief Wait until a deadline: sleep, then spin for the last SpinTimeInNs.
+	 *
+	 * @param Deadline [in] The deadline.
+	 */
+	void WaitUntil( const Clock::time_point& Deadline );
+
+	double Speed;								/*!< @brief Replay speed, 0 or less for as fast as possible. */
+	LatePolicy Policy;							/*!< @brief Policy for late frames. */
+	int64_t LateThresholdInNs;					/*!< @brief Lateness from which a frame is late. */
+	int64_t SpinTimeInNs;						/*!< @brief Time spent spinning before each deadline. */
+
+	bool Started;								/*!< @brief The replay clock is started. */
+	Clock::time_point ClockOrigin;				/*!< @brief Time of the origin of the replay. */
+	HighResTimestamp TimestampOrigin;			/*!< @brief Recorded timestamp given at ClockOrigin. */
+	HighResTimestamp LastTimestamp;				/*!< @brief Timestamp of the last scheduled frame. */
+
+	ReplayStatistics Statistics;				/*!< @brief Lateness statistics. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __REPLAY_SCHEDULER_H__
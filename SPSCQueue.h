@@ -0,0 +1,119 @@
+/**
+ * @file SPSCQueue.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __SPSC_QUEUE_H__
+#define __SPSC_QUEUE_H__
+
+#include <stddef.h>
+
+#include <vector>
+#include <atomic>
+#include <utility>
+
+namespace MobileRGBD {
+
+/**
+ * @class SPSCQueue SPSCQueue.cpp SPSCQueue.h
+ * @brief Bounded lock-free queue between one producer thread and one consumer thread. Slots are
+ *		  allocated once, Push and Pop never block nor allocate: the caller decides how to wait when
+ *		  the queue is full (producer) or empty (consumer). Only Push may be called by the producer,
+ *		  Front, Pop and IsEmpty by the consumer.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<typename ElementType>
+class SPSCQueue
+{
+public:
+	/** @brief Constructor.
+	 *
+	 * @param Capacity [in] Maximum number of elements in the queue (at least 1).
+	 */
+	SPSCQueue( size_t Capacity ) : Slots( Capacity > 0 ? Capacity : 1 ), Head(0), Tail(0) {}
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~SPSCQueue() {}
+
+	/** @brief Maximum number of elements in the queue.
+	 */
+	size_t GetCapacity() const { return Slots.size(); }
+
+	/** @brief Return true if the queue is full. Producer side.
+	 */
+	bool IsFull() const { return (Head.load( std::memory_order_relaxed ) - Tail.load( std::memory_order_acquire ) == Slots.size()); }
+
+	/** @brief Move an element at the end of the queue. Producer side.
+	 *
+	 * @param Element [in,out] The element, moved in the queue if there is room for it.
+	 * @return False if the queue is full.
+	 */
+	bool Push( ElementType& Element )
+	{
+		size_t CurrentHead = Head.load( std::memory_order_relaxed );
+		if ( CurrentHead - Tail.load( std::memory_order_acquire ) == Slots.size() )
+		{
+			return false;
+		}
+
+		Slots[CurrentHead % Slots.size()] = std::move( Element );
+
+		// The element is visible to the consumer with the new head
+		Head.store( CurrentHead + 1, std::memory_order_release );
+		return true;
+	}
+
+	/** @brief Return true if the queue is empty. Consumer side.
+	 */
+	bool IsEmpty() const { return (Head.load( std::memory_order_acquire ) == Tail.load( std::memory_order_relaxed )); }
+
+	/** @brief Get the first element of the queue without removing it. Consumer side.
+	 *
+	 * @return A pointer on the element (valid until Pop), nullptr if the queue is empty.
+	 */
+	ElementType * Front()
+	{
+		size_t CurrentTail = Tail.load( std::memory_order_relaxed );
+		if ( Head.load( std::memory_order_acquire ) == CurrentTail )
+		{
+			return nullptr;
+		}
+
+		return &Slots[CurrentTail % Slots.size()];
+	}
+
+	/** @brief Remove the first element of the queue. Consumer side.
+	 *
+	 * @param Element [out] The removed element.
+	 * @return False if the queue is empty.
+	 */
+	bool Pop( ElementType& Element )
+	{
+		ElementType * First = Front();
+		if ( First == nullptr )
+		{
+			return false;
+		}
+
+		Element = std::move( *First );
+
+		// Release resources held by the slot before giving it back to the producer
+		*First = ElementType();
+		Tail.store( Tail.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+		return true;
+	}
+
+protected:
+	std::vector<ElementType> Slots;				/*!< @brief Preallocated slots. */
+	std::atomic<size_t> Head;					/*!< @brief Number of elements pushed since the creation (written by the producer). */
+	char Padding[64];							/*!< @brief Keep Head and Tail in separate cache lines. */
+	std::atomic<size_t> Tail;					/*!< @brief Number of elements popped since the creation (written by the consumer). */
+};
+
+} // namespace MobileRGBD
+
+#endif // __SPSC_QUEUE_H__
@@ -0,0 +1,130 @@
+/**
+ * @file SessionIndexer.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "SessionIndexer.h"
+#include "ThreadPool.h"
+
+using namespace std;
+using namespace MobileRGBD;
+
+/** @brief Constructor.
+ *
+ * @param eNumberOfThreads [in] Number of threads, 0 means number of hardware threads (default=0).
+ */
+SessionIndexer::SessionIndexer( unsigned int eNumberOfThreads /* = 0 */ )
+{
+	NumberOfThreads = eNumberOfThreads;
+}
+
+/** @brief Add a stream to index. The reader must stay alive and unused during Run.
+ *
+ * @param Stream [in] Reader of the timestamp file.
+ */
+void SessionIndexer::AddStream( ReadTimestamp * Stream )
+{
+	if ( Stream != nullptr )
+	{
+		Streams.push_back( Stream );
+	}
+}
+
+/** @brief Build or load the indexes of all streams.
+ *
+ * @param SaveIndexes [in] Save built indexes next to the timestamp files (default=false).
+ * @return True if all indexes are available.
+ */
+bool SessionIndexer::Run( bool SaveIndexes /* = false */ )
+{
+	ThreadPool Workers( NumberOfThreads );
+	bool Result = true;
+	size_t i, Chunk;
+
+	// First, load saved indexes if up to date (each reader is modified by only one task)
+	vector< future<bool> > Loaded;
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		ReadTimestamp * Stream = Streams[i];
+		Loaded.push_back( Workers.Submit( [Stream]() { return (Stream->Index.IsEmpty() == false || Stream->LoadIndex() == true); } ) );
+	}
+
+	// Then, split files to parse in chunks. Tasks of all files are submitted before waiting
+	// for any of them, no task waits for another one
+	vector< vector<int64_t> > Chunks( Streams.size() );
+	vector< vector< vector<TimestampIndexEntry> > > ChunksEntries( Streams.size() );
+	vector< vector< future<bool> > > Parsed( Streams.size() );
+	vector<int64_t> EndOfLastChunks( Streams.size(), 0 );
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		if ( Loaded[i].get() == true )
+		{
+			continue;
+		}
+
+		const string& FileName = Streams[i]->GetFileName();
+		size_t SizeOfLineBuffer = (size_t)Streams[i]->LineBufferSize;
+
+		Chunks[i] = TimestampIndex::SplitInChunks( FileName, Workers.GetNumberOfThreads() );
+		if ( Chunks[i].empty() )
+		{
+			// Compressed file, read sequentially by one thread
+			Chunks[i].push_back( 0 );
+			Chunks[i].push_back( INT64_MAX );
+		}
+
+		ChunksEntries[i].resize( Chunks[i].size()-1 );
+		for( Chunk = 0; Chunk < ChunksEntries[i].size(); Chunk++ )
+		{
+			vector<TimestampIndexEntry> * ChunkEntries = &ChunksEntries[i][Chunk];
+			int64_t ChunkStart = Chunks[i][Chunk];
+			int64_t ChunkEnd = Chunks[i][Chunk+1];
+			int64_t * EndOfChunk = (Chunk == ChunksEntries[i].size()-1) ? &EndOfLastChunks[i] : nullptr;
+
+			Parsed[i].push_back( Workers.Submit( [=]() { return TimestampIndex::BuildChunk( FileName, ChunkStart, ChunkEnd, SizeOfLineBuffer, *ChunkEntries, EndOfChunk ); } ) );
+		}
+	}
+
+	// Stitch chunks of each file
+	vector< future<bool> > Saved;
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		if ( Parsed[i].empty() )
+		{
+			// Loaded
+			continue;
+		}
+
+		bool StreamResult = true;
+		for( Chunk = 0; Chunk < Parsed[i].size(); Chunk++ )
+		{
+			StreamResult = Parsed[i][Chunk].get() && StreamResult;
+		}
+
+		if ( StreamResult == false )
+		{
+			fprintf( stderr, "Unable to index '%s'.\n", Streams[i]->GetFileName().c_str() );
+			Result = false;
+			continue;
+		}
+
+		ReadTimestamp * Stream = Streams[i];
+		Stream->Index.Stitch( ChunksEntries[i], EndOfLastChunks[i] );
+		Stream->UpdateCurrentIndexEntry();
+
+		if ( SaveIndexes == true )
+		{
+			Saved.push_back( Workers.Submit( [Stream]() { return Stream->SaveIndex(); } ) );
+		}
+	}
+
+	// A failure to save an index is not an error, it will be built again next time
+	for( i = 0; i < Saved.size(); i++ )
+	{
+		Saved[i].get();
+	}
+
+	return Result;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file SessionIndexer.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __SESSION_INDEXER_H__
+#define __SESSION_INDEXER_H__
+
+#include <vector>
+
+#include "ReadTimestamp.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class SessionIndexer SessionIndexer.cpp SessionIndexer.h
+ * @brief Build (or load if saved) the indexes of all the timestamp files of one or several sessions
+ *		  concurrently. Large usual files are split in chunks parsed in parallel, compressed files are parsed
+ *		  by one thread each. All chunks of all files share the same pool of threads. Example:
+ *		  @code
+		  SessionIndexer Indexer;
+		  Indexer.AddStream( &Depth );
+		  Indexer.AddStream( &Robot );
+		  Indexer.Run( true );	// Indexes are also saved for the next opening
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class SessionIndexer
+{
+public:
+	/** @brief Constructor.
+	 *
+	 * @param NumberOfThreads [in] Number of threads, 0 means number of hardware threads (default=0).
+	 */
+	SessionIndexer( unsigned int NumberOfThreads = 0 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~SessionIndexer() {}
+
+	/** @brief Add a stream to index. The reader must stay alive and unused during Run.
+	 *
+	 * @param Stream [in] Reader of the timestamp file.
+	 */
+	void AddStream( ReadTimestamp * Stream );
+
+	/** @brief Remove all streams.
+	 */
+	void Clear() { Streams.clear(); }
+
+	/** @brief Build or load the indexes of all streams.
+	 *
+	 * @param SaveIndexes [in] Save built indexes next to the timestamp files (default=false).
+	 * @return True if all indexes are available.
+	 */
+	bool Run( bool SaveIndexes = false );
+
+protected:
+	std::vector<ReadTimestamp*> Streams;	/*!< @brief Streams to index. */
+	unsigned int NumberOfThreads;			/*!< @brief Number of threads of the pool. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __SESSION_INDEXER_H__
@@ -0,0 +1,408 @@
+/**
+ * @file SessionManifest.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "SessionManifest.h"
+#include "SessionIndexer.h"
+#include "DataFile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+using namespace MobileRGBD;
+
+const char * SessionManifest::DefaultFileName = "session.manifest";	/*!< @brief Default name of the manifest in the session folder ("session.manifest"). */
+const int SessionManifest::CurrentVersion = 1;						/*!< @brief Version of the manifest format written by this code (1). */
+
+// First line of manifests, followed by the version
+static const char ManifestHeader[] = "MobileRGBD session manifest";
+
+// Number of tab separated fields of a stream line
+static const size_t NumberOfStreamFields = 17;
+
+/** @brief Write a timestamp with all its digits.
+ *
+ * @param fOut [in] Output file.
+ * @param Timestamp [in] The timestamp.
+ */
+static void WriteTimestamp( FILE * fOut, const HighResTimestamp& Timestamp )
+{
+	int64_t Value = Timestamp.ToNanoseconds();
+
+	// HighResTimestamp::Parse applies the sign to the seconds and to the fraction
+	if ( Value < 0 )
+	{
+		fprintf( fOut, "-" );
+		Value = -Value;
+	}
+
+	fprintf( fOut, "%" PRId64 ".%09" PRId64, Value/HighResTimestamp::NanosecondsPerSecond, Value%HighResTimestamp::NanosecondsPerSecond );
+}
+
+/** @brief Constructor.
+ *
+ * @param eSessionFolder [in] Folder of the session, files of streams are relative to it (default="", current folder).
+ */
+SessionManifest::SessionManifest( const string& eSessionFolder /* = "" */ )
+{
+	SessionFolder = eSessionFolder;
+}
+
+/** @brief Add a timestamp stream (see SessionStream::TimestampStream). Other values are set by Scan.
+ *
+ * @param Name [in] Name of the stream.
+ * @param TimestampFileName [in] Timestamp file, relative to the session folder (or absolute).
+ * @return Number of the stream.
+ */
+size_t SessionManifest::AddTimestampStream( const string& Name, const string& TimestampFileName )
+{
+	SessionStream NewStream;
+
+	NewStream.Name = Name;
+	NewStream.Kind = SessionStream::TimestampStream;
+	NewStream.TimestampFileName = TimestampFileName;
+
+	Streams.push_back( NewStream );
+
+	return Streams.size()-1;
+}
+
+/** @brief Add a raw stream (see SessionStream::RawStream). Other values are set by Scan.
+ *
+ * @param Name [in] Name of the stream.
+ * @param TimestampFileName [in] Timestamp file, relative to the session folder (or absolute).
+ * @param RawFileName [in] Raw file, relative to the session folder (or absolute).
+ * @param FrameSize [in] Size of each frame (or subframe) in the raw file.
+ * @param Mode [in] Reading mode of the raw file (default=ReadTimestampRawFile::SimpleFrameMode).
+ * @param Width [in] Width of frames in pixels (default=0, not an image).
+ * @param Height [in] Height of frames in pixels (default=0, not an image).
+ * @param BytesPerPixel [in] Size of a pixel (default=0, not an image).
+ * @return Number of the stream.
+ */
+size_t SessionManifest::AddRawStream( const string& Name, const string& TimestampFileName, const string& RawFileName, int FrameSize,
+	int Mode /* = ReadTimestampRawFile::SimpleFrameMode */, int Width /* = 0 */, int Height /* = 0 */, int BytesPerPixel /* = 0 */ )
+{
+	SessionStream NewStream;
+
+	NewStream.Name = Name;
+	NewStream.Kind = SessionStream::RawStream;
+	NewStream.TimestampFileName = TimestampFileName;
+	NewStream.RawFileName = RawFileName;
+	NewStream.FrameSize = FrameSize;
+	NewStream.Mode = Mode;
+	NewStream.Width = Width;
+	NewStream.Height = Height;
+	NewStream.BytesPerPixel = BytesPerPixel;
+
+	Streams.push_back( NewStream );
+
+	return Streams.size()-1;
+}
+
+/** @brief Probe the files of all streams and build (and save) their indexes concurrently (see SessionIndexer)
+ *		   in order to fill the manifest.
+ *
+ * @param NumberOfThreads [in] Number of threads building the indexes, 0 means number of hardware threads (default=0).
+ * @return True if all streams could be read.
+ */
+bool SessionManifest::Scan( unsigned int NumberOfThreads /* = 0 */ )
+{
+	vector< unique_ptr<ReadTimestamp> > Readers;
+	SessionIndexer Indexer( NumberOfThreads );
+	bool Result = true;
+	size_t i;
+
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		SessionStream& Stream = Streams[i];
+
+		// Probing readers, values of the manifest are not used
+		if ( Stream.Kind == SessionStream::RawStream )
+		{
+			ReadTimestampRawFile * RawReader = new ReadTimestampRawFile( GetPath( Stream.TimestampFileName ), GetPath( Stream.RawFileName ), Stream.FrameSize );
+			RawReader->Mode = (unsigned char)Stream.Mode;
+			Readers.push_back( unique_ptr<ReadTimestamp>( RawReader ) );
+		}
+		else
+		{
+			Readers.push_back( unique_ptr<ReadTimestamp>( new ReadTimestampFile( GetPath( Stream.TimestampFileName ) ) ) );
+		}
+
+		Indexer.AddStream( Readers.back().get() );
+	}
+
+	// Indexes are saved, next readers load them
+	if ( Indexer.Run( true ) == false )
+	{
+		return false;
+	}
+
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		SessionStream& Stream = Streams[i];
+		const TimestampIndex& Index = Readers[i]->Index;
+		string TimestampPath = GetPath( Stream.TimestampFileName );
+
+		Stream.NumberOfLines = (int64_t)Index.Size();
+		Stream.NumberOfFrames = 0;
+		Stream.FirstTimestamp = HighResTimestamp();
+		Stream.LastTimestamp = HighResTimestamp();
+		if ( Index.IsEmpty() == false )
+		{
+			Stream.FirstTimestamp = Index[0].Timestamp;
+			Stream.LastTimestamp = Index[Index.Size()-1].Timestamp;
+		}
+
+		Stream.TimestampFileIsCompressed = (DataFile::FileOrFolderExists( TimestampPath.c_str() ) == false &&
+			DataFile::FileOrFolderExists( (TimestampPath + ".7z").c_str() ) == true);
+
+		if ( Stream.Kind != SessionStream::RawStream )
+		{
+			continue;
+		}
+
+		ReadTimestampRawFile * RawReader = (ReadTimestampRawFile*)Readers[i].get();
+		string RawPath = GetPath( Stream.RawFileName );
+
+		for( size_t Entry = 0; Entry < Index.Size(); Entry++ )
+		{
+			if ( Index[Entry].FrameNumber >= 0 )
+			{
+				Stream.NumberOfFrames++;
+			}
+		}
+
+		// Read in the first line, like for any reader
+		RawReader->Reinit();
+		Stream.StartingFrame = RawReader->StartingFrame;
+
+		Stream.RawFormat = RawReader->GetRawFileFormat();
+		if ( Stream.RawFormat == ReadTimestampRawFile::UnknownRawFileFormat )
+		{
+			fprintf( stderr, "Could not open raw file '%s' of stream '%s'.\n", RawPath.c_str(), Stream.Name.c_str() );
+			Result = false;
+		}
+
+		Stream.RawFileIsCompressed = (DataFile::FileOrFolderExists( RawPath.c_str() ) == false &&
+			DataFile::FileOrFolderExists( (RawPath + ".7z").c_str() ) == true);
+	}
+
+	return Result;
+}
+
+/** @brief Save the manifest.
+ *
+ * @param FileName [in] Name of the manifest (default="", DefaultFileName in the session folder).
+ * @return True if the manifest was written.
+ */
+bool SessionManifest::Save( const string& FileName /* = "" */ ) const
+{
+	string ManifestFileName = FileName.empty() ? GetPath( DefaultFileName ) : FileName;
+
+	FILE * fOut = fopen( ManifestFileName.c_str(), "w" );
+	if ( fOut == nullptr )
+	{
+		fprintf( stderr, "Could not create manifest '%s'.\n", ManifestFileName.c_str() );
+		return false;
+	}
+
+	fprintf( fOut, "%s %d\n", ManifestHeader, CurrentVersion );
+	fprintf( fOut, "# Name\tKind\tTimestampFile\tRawFile\tFrameSize\tWidth\tHeight\tBytesPerPixel\tMode\tStartingFrame\tRawFormat\t"
+		"TimestampFileIsCompressed\tRawFileIsCompressed\tFirstTimestamp\tLastTimestamp\tNumberOfLines\tNumberOfFrames\n" );
+
+	for( size_t i = 0; i < Streams.size(); i++ )
+	{
+		const SessionStream& Stream = Streams[i];
+
+		// Fields are separated by tabs, names may contain spaces
+		fprintf( fOut, "%s\t%s\t%s\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t", Stream.Name.c_str(), Stream.Kind == SessionStream::RawStream ? "raw" : "timestamp",
+			Stream.TimestampFileName.c_str(), Stream.RawFileName.empty() ? "-" : Stream.RawFileName.c_str(), Stream.FrameSize, Stream.Width, Stream.Height,
+			Stream.BytesPerPixel, Stream.Mode, Stream.StartingFrame, Stream.RawFormat, Stream.TimestampFileIsCompressed ? 1 : 0, Stream.RawFileIsCompressed ? 1 : 0 );
+		WriteTimestamp( fOut, Stream.FirstTimestamp );
+		fprintf( fOut, "\t" );
+		WriteTimestamp( fOut, Stream.LastTimestamp );
+		fprintf( fOut, "\t%" PRId64 "\t%" PRId64 "\n", Stream.NumberOfLines, Stream.NumberOfFrames );
+	}
+
+	bool Result = (ferror( fOut ) == 0);
+	Result = (fclose( fOut ) == 0) && Result;
+
+	return Result;
+}
+
+/** @brief Load a manifest. Streams of the manifest replace current ones.
+ *
+ * @param FileName [in] Name of the manifest (default="", DefaultFileName in the session folder).
+ * @return True if the manifest was read.
+ */
+bool SessionManifest::Load( const string& FileName /* = "" */ )
+{
+	string ManifestFileName = FileName.empty() ? GetPath( DefaultFileName ) : FileName;
+	vector<char> Line( 64*1024 );
+	int Version = 0;
+
+	Streams.clear();
+
+	FILE * fIn = fopen( ManifestFileName.c_str(), "r" );
+	if ( fIn == nullptr )
+	{
+		return false;
+	}
+
+	if ( fgets( &Line[0], (int)Line.size(), fIn ) == nullptr || strncmp( &Line[0], ManifestHeader, sizeof(ManifestHeader)-1 ) != 0 ||
+		 sscanf( &Line[sizeof(ManifestHeader)-1], "%d", &Version ) != 1 || Version != CurrentVersion )
+	{
+		fprintf( stderr, "'%s' is not a session manifest (or has an unsupported version).\n", ManifestFileName.c_str() );
+		fclose( fIn );
+		return false;
+	}
+
+	while( fgets( &Line[0], (int)Line.size(), fIn ) != nullptr )
+	{
+		vector<char*> Fields;
+		SessionStream Stream;
+		int EndOfTimestampPosition;
+
+		if ( Line[0] == '#' )
+		{
+			continue;
+		}
+
+		// Split on tabs, without the end of line
+		Line[strcspn( &Line[0], "\r\n" )] = '\0';
+		if ( Line[0] == '\0' )
+		{
+			continue;
+		}
+		for( char * Field = &Line[0]; Field != nullptr; )
+		{
+			Fields.push_back( Field );
+			Field = strchr( Field, '\t' );
+			if ( Field != nullptr )
+			{
+				*Field++ = '\0';
+			}
+		}
+
+		if ( Fields.size() != NumberOfStreamFields ||
+			 HighResTimestamp::Parse( Fields[13], Stream.FirstTimestamp, EndOfTimestampPosition ) == false ||
+			 HighResTimestamp::Parse( Fields[14], Stream.LastTimestamp, EndOfTimestampPosition ) == false )
+		{
+			fprintf( stderr, "Invalid stream line in manifest '%s'.\n", ManifestFileName.c_str() );
+			Streams.clear();
+			fclose( fIn );
+			return false;
+		}
+
+		Stream.Name = Fields[0];
+		Stream.Kind = strcmp( Fields[1], "raw" ) == 0 ? SessionStream::RawStream : SessionStream::TimestampStream;
+		Stream.TimestampFileName = Fields[2];
+		Stream.RawFileName = strcmp( Fields[3], "-" ) == 0 ? "" : Fields[3];
+		Stream.FrameSize = atoi( Fields[4] );
+		Stream.Width = atoi( Fields[5] );
+		Stream.Height = atoi( Fields[6] );
+		Stream.BytesPerPixel = atoi( Fields[7] );
+		Stream.Mode = atoi( Fields[8] );
+		Stream.StartingFrame = atoi( Fields[9] );
+		Stream.RawFormat = atoi( Fields[10] );
+		Stream.TimestampFileIsCompressed = (atoi( Fields[11] ) != 0);
+		Stream.RawFileIsCompressed = (atoi( Fields[12] ) != 0);
+		Stream.NumberOfLines = strtoll( Fields[15], nullptr, 10 );
+		Stream.NumberOfFrames = strtoll( Fields[16], nullptr, 10 );
+
+		Streams.push_back( Stream );
+	}
+
+	fclose( fIn );
+	return true;
+}
+
+/** @brief Search for a stream using its name.
+ *
+ * @param Name [in] Name of the stream.
+ * @return Number of the stream, -1 if not found.
+ */
+int SessionManifest::FindStream( const string& Name ) const
+{
+	for( size_t i = 0; i < Streams.size(); i++ )
+	{
+		if ( Streams[i].Name == Name )
+		{
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
+/** @brief Create the reader of a stream, configured from the manifest. Files are not opened.
+ *
+ * @param Stream [in] Number of the stream.
+ * @return The reader (a ReadTimestampRawFile for raw streams), owned by the caller.
+ */
+unique_ptr<ReadTimestamp> SessionManifest::CreateReader( size_t Stream ) const
+{
+	const SessionStream& Description = Streams[Stream];
+
+	if ( Description.Kind != SessionStream::RawStream )
+	{
+		ReadTimestampFile * Reader = new ReadTimestampFile( GetPath( Description.TimestampFileName ) );
+		Reader->SetFileIsCompressed( Description.TimestampFileIsCompressed );
+		return unique_ptr<ReadTimestamp>( Reader );
+	}
+
+	ReadTimestampRawFile * RawReader = new ReadTimestampRawFile( GetPath( Description.TimestampFileName ), GetPath( Description.RawFileName ), Description.FrameSize );
+
+	// No probing when files are opened
+	RawReader->Mode = (unsigned char)Description.Mode;
+	RawReader->SetStartingFrame( Description.StartingFrame );
+	RawReader->SetRawFileFormat( (ReadTimestampRawFile::RawFileFormat)Description.RawFormat );
+	RawReader->SetFileIsCompressed( Description.TimestampFileIsCompressed );
+	if ( Description.RawFormat == ReadTimestampRawFile::PlainRawFileFormat )
+	{
+		// Other formats open their own files
+		RawReader->SetRawFileIsCompressed( Description.RawFileIsCompressed );
+	}
+
+	return unique_ptr<ReadTimestamp>( RawReader );
+}
+
+/** @brief Create the readers of all streams (see CreateReader).
+ *
+ * @param Readers [out] Reader of each stream.
+ */
+void SessionManifest::CreateReaders( vector< unique_ptr<ReadTimestamp> >& Readers ) const
+{
+	Readers.clear();
+
+	for( size_t i = 0; i < Streams.size(); i++ )
+	{
+		Readers.push_back( CreateReader( i ) );
+	}
+}
+
+/** @brief Get the path of a file of the session.
+ *
+ * @param FileName [in] File name relative to the session folder (or absolute).
+ */
+string SessionManifest::GetPath( const string& FileName ) const
+{
+	// Absolute paths (Unix, Windows with drive letter or network path)
+	if ( SessionFolder.empty() || FileName.empty() || FileName[0] == '/' || FileName[0] == '\\' || (FileName.size() > 1 && FileName[1] == ':') )
+	{
+		return FileName;
+	}
+
+	char LastCharacter = SessionFolder[SessionFolder.size()-1];
+	if ( LastCharacter == '/' || LastCharacter == '\\' )
+	{
+		return SessionFolder + FileName;
+	}
+
+	return SessionFolder + "/" + FileName;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file SessionManifest.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __SESSION_MANIFEST_H__
+#define __SESSION_MANIFEST_H__
+
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "TimestampTools.h"
+#include "ReadTimestamp.h"
+#include "ReadTimestampFile.h"
+#include "ReadTimestampRawFile.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct SessionStream SessionManifest.h
+ * @brief Description of a stream of a session in a manifest (see SessionManifest).
+ */
+struct SessionStream
+{
+	/**
+	 * @enum SessionStream::StreamKind
+	 * @brief Kind of reader of the stream.
+	 */
+	enum StreamKind
+	{
+		TimestampStream = 0,				/*!< @brief Timestamp file with data on each line (robot, ...), read with ReadTimestampFile. */
+		RawStream = 1						/*!< @brief Timestamp file and raw file (depth, video, bodies, ...), read with ReadTimestampRawFile. */
+	};
+
+	std::string Name;						/*!< @brief Name of the stream in the session ("depth", "robot", ...). */
+	StreamKind Kind;						/*!< @brief Kind of reader. */
+	std::string TimestampFileName;			/*!< @brief Timestamp file, relative to the session folder (or absolute). */
+	std::string RawFileName;				/*!< @brief Raw file, relative to the session folder (or absolute), empty for timestamp streams. */
+	int FrameSize;							/*!< @brief Size of each frame (or subframe) in the raw file. */
+	int Width;								/*!< @brief Width of frames in pixels (0 if not an image). */
+	int Height;								/*!< @brief Height of frames in pixels (0 if not an image). */
+	int BytesPerPixel;						/*!< @brief Size of a pixel (0 if not an image). */
+	int Mode;								/*!< @brief Reading mode of the raw file (see ReadTimestampRawFile::ReadingMode). */
+	int StartingFrame;						/*!< @brief Number of the first frame of the raw file. */
+	int RawFormat;							/*!< @brief Format of the raw file (see ReadTimestampRawFile::RawFileFormat). */
+	bool TimestampFileIsCompressed;			/*!< @brief The timestamp file is compressed with 7z. */
+	bool RawFileIsCompressed;				/*!< @brief The raw file is compressed with 7z. */
+	HighResTimestamp FirstTimestamp;		/*!< @brief Timestamp of the first line. */
+	HighResTimestamp LastTimestamp;			/*!< @brief Timestamp of the last line. */
+	int64_t NumberOfLines;					/*!< @brief Number of lines with a timestamp. */
+	int64_t NumberOfFrames;					/*!< @brief Number of lines with a frame number (raw streams). */
+
+	/** @brief Constructor. Create an empty timestamp stream.
+	 */
+	SessionStream() : Kind(TimestampStream), FrameSize(0), Width(0), Height(0), BytesPerPixel(0), Mode(ReadTimestampRawFile::SimpleFrameMode),
+		StartingFrame(0), RawFormat(ReadTimestampRawFile::UnknownRawFileFormat), TimestampFileIsCompressed(false), RawFileIsCompressed(false),
+		NumberOfLines(0), NumberOfFrames(0) {}
+};
+
+/**
+ * @class SessionManifest SessionManifest.cpp SessionManifest.h
+ * @brief Manifest of a session: a text file in the session folder listing all its streams, with
+ *		  everything needed to create their readers (files, frame geometry, reading mode, starting
+ *		  frame, raw file format) and their time range and line/frame counts. It is generated once
+ *		  with Scan, which also saves the indexes of the streams. Readers created from a loaded manifest
+ *		  never probe files (starting frame, raw file format, 7z versions), opening a session only reads the manifest. Example:
+ *		  @code
+		  // Once, by a tool
+		  SessionManifest Generator( "/data/Session01" );
+		  Generator.AddRawStream( "depth", "depth/data.timestamp", "depth/data.raw", 512*424*2, ReadTimestampRawFile::SimpleFrameMode, 512, 424, 2 );
+		  Generator.AddTimestampStream( "robot", "robot/localization.timestamp" );
+		  Generator.Scan();
+		  Generator.Save();
+
+		  // Then in applications
+		  SessionManifest Manifest( "/data/Session01" );
+		  std::vector< std::unique_ptr<ReadTimestamp> > Readers;
+		  Manifest.Load();
+		  Manifest.CreateReaders( Readers );
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class SessionManifest
+{
+public:
+	static const char * DefaultFileName;	/*!< @brief Default name of the manifest in the session folder ("session.manifest"). */
+	static const int CurrentVersion;		/*!< @brief Version of the manifest format written by this code (1). */
+
+	/** @brief Constructor.
+	 *
+	 * @param eSessionFolder [in] Folder of the session, files of streams are relative to it (default="", current folder).
+	 */
+	SessionManifest( const std::string& eSessionFolder = "" );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~SessionManifest() {}
+
+	/** @brief Folder of the session.
+	 */
+	const std::string& GetSessionFolder() const { return SessionFolder; }
+
+	/** @brief Add a timestamp stream (see SessionStream::TimestampStream). Other values are set by Scan.
+	 *
+	 * @param Name [in] Name of the stream.
+	 * @param TimestampFileName [in] Timestamp file, relative to the session folder (or absolute).
+	 * @return Number of the stream.
+	 */
+	size_t AddTimestampStream( const std::string& Name, const std::string& TimestampFileName );
+
+	/** @brief Add a raw stream (see SessionStream::RawStream). Other values are set by Scan.
+	 *
+	 * @param Name [in] Name of the stream.
+	 * @param TimestampFileName [in] Timestamp file, relative to the session folder (or absolute).
+	 * @param RawFileName [in] Raw file, relative to the session folder (or absolute).
+	 * @param FrameSize [in] Size of each frame (or subframe) in the raw file.
+	 * @param Mode [in] Reading mode of the raw file (default=ReadTimestampRawFile::SimpleFrameMode).
+	 * @param Width [in] Width of frames in pixels (default=0, not an image).
+	 * @param Height [in] Height of frames in pixels (default=0, not an image).
+	 * @param BytesPerPixel [in] Size of a pixel (default=0, not an image).
+	 * @return Number of the stream.
+	 */
+	size_t AddRawStream( const std::string& Name, const std::string& TimestampFileName, const std::string& RawFileName, int FrameSize,
+		int Mode = ReadTimestampRawFile::SimpleFrameMode, int Width = 0, int Height = 0, int BytesPerPixel = 0 );
+
+	/** @brief Probe the files of all streams and build (and save) their indexes concurrently (see SessionIndexer)
+	 *		   in order to fill the manifest.
+	 *
+	 * @param NumberOfThreads [in] Number of threads building the indexes, 0 means number of hardware threads (default=0).
+	 * @return True if all streams could be read.
+	 */
+	bool Scan( unsigned int NumberOfThreads = 0 );
+
+	/** @brief Save the manifest.
+	 *
+	 * @param FileName [in] Name of the manifest (default="", DefaultFileName in the session folder).
+	 * @return True if the manifest was written.
+	 */
+	bool Save( const std::string& FileName = "" ) const;
+
+	/** @brief Load a manifest. Streams of the manifest replace current ones.
+	 *
+	 * @param FileName [in] Name of the manifest (default="", DefaultFileName in the session folder).
+	 * @return True if the manifest was read.
+	 */
+	bool Load( const std::string& FileName = "" );
+
+	/** @brief Number of streams.
+	 */
+	size_t GetNumberOfStreams() const { return Streams.size(); }
+
+	/** @brief Get the description of a stream.
+	 *
+	 * @param Stream [in] Number of the stream.
+	 */
+	const SessionStream& GetStream( size_t Stream ) const { return Streams[Stream]; }
+
+	/** @brief Search for a stream using its name.
+	 *
+	 * @param Name [in] Name of the stream.
+	 * @return Number of the stream, -1 if not found.
+	 */
+	int FindStream( const std::string& Name ) const;
+
+	/** @brief Create the reader of a stream, configured from the manifest. Files are not opened.
+	 *
+	 * @param Stream [in] Number of the stream.
+	 * @return The reader (a ReadTimestampRawFile for raw streams), owned by the caller.
+	 */
+	std::unique_ptr<ReadTimestamp> CreateReader( size_t Stream ) const;
+
+	/** @brief Create the readers of all streams (see CreateReader).
+	 *
+	 * @param Readers [out] Reader of each stream.
+	 */
+	void CreateReaders( std::vector< std::unique_ptr<ReadTimestamp> >& Readers ) const;
+
+	/** @brief Get the path of a file of the session.
+	 *
+	 * @param FileName [in] File name relative to the session folder (or absolute).
+	 */
+	std::string GetPath( const std::string& FileName ) const;
+
+protected:
+	std::string SessionFolder;				/*!< @brief Folder of the session. */
+	std::vector<SessionStream> Streams;		/*!< @brief Streams of the session. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __SESSION_MANIFEST_H__
@@ -0,0 +1,275 @@
+/**
+ * @file ShardPlanner.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "ShardPlanner.h"
+#include "SessionIndexer.h"
+
+using namespace std;
+using namespace MobileRGBD;
+
+/** @brief Constructor.
+ *
+ * @param eManifest [in] Manifest of the session (copied).
+ * @param eNumberOfThreads [in] Number of threads loading (or building) the indexes, 0 means number of hardware threads (default=0).
+ */
+ShardPlanner::ShardPlanner( const SessionManifest& eManifest, unsigned int eNumberOfThreads /* = 0 */ )
+	: Manifest( eManifest )
+{
+	NumberOfThreads = eNumberOfThreads;
+}
+
+/** @brief Split the session in time shards with balanced numbers of frames. Shards may be empty if
+ *		   many lines share the same timestamp.
+ *
+ * @param NumberOfShards [in] Number of shards.
+ * @param Shards [out] The shards, in time order.
+ * @return False if an index is not available.
+ */
+bool ShardPlanner::Plan( size_t NumberOfShards, vector<SessionShard>& Shards )
+{
+	SessionIndexer Indexer( NumberOfThreads );
+	HighResTimestamp FirstTimestamp, LastTimestamp;
+	int64_t TotalFrames = 0;
+	bool SessionIsEmpty = true;
+	size_t Stream;
+
+	Shards.clear();
+
+	if ( NumberOfShards == 0 )
+	{
+		return true;
+	}
+
+	// Indexes are loaded once (saved by SessionManifest::Scan)
+	if ( Readers.size() != Manifest.GetNumberOfStreams() )
+	{
+		Manifest.CreateReaders( Readers );
+		for( Stream = 0; Stream < Readers.size(); Stream++ )
+		{
+			Indexer.AddStream( Readers[Stream].get() );
+		}
+		if ( Indexer.Run() == false )
+		{
+			Readers.clear();
+			return false;
+		}
+	}
+
+	FramesBefore.resize( Readers.size() );
+	for( Stream = 0; Stream < Readers.size(); Stream++ )
+	{
+		const TimestampIndex& Index = Readers[Stream]->Index;
+		const SessionStream& Description = Manifest.GetStream( Stream );
+		vector<int64_t>& Counts = FramesBefore[Stream];
+
+		Counts.resize( Index.Size()+1 );
+		Counts[0] = 0;
+		for( size_t Entry = 0; Entry < Index.Size(); Entry++ )
+		{
+			// Only frame lines of raw streams (see StreamRange::NextFrame), all lines otherwise
+			const TimestampIndexEntry& Line = Index[Entry];
+			bool IsFrame = Description.Kind != SessionStream::RawStream ||
+				(Line.FrameNumber >= 0 && (Description.Mode != ReadTimestampRawFile::SubFramesMode || Line.NumberOfSubFrames >= 0));
+
+			Counts[Entry+1] = Counts[Entry] + (IsFrame ? 1 : 0);
+		}
+		TotalFrames += Counts[Index.Size()];
+
+		if ( Index.IsEmpty() == false )
+		{
+			if ( SessionIsEmpty == true || Index[0].Timestamp < FirstTimestamp )
+			{
+				FirstTimestamp = Index[0].Timestamp;
+			}
+			if ( SessionIsEmpty == true || Index[Index.Size()-1].Timestamp > LastTimestamp )
+			{
+				LastTimestamp = Index[Index.Size()-1].Timestamp;
+			}
+			SessionIsEmpty = false;
+		}
+	}
+
+	// Bounds of the shards, the last one ends after the last line
+	vector<HighResTimestamp> Bounds( NumberOfShards+1 );
+	Bounds[0] = FirstTimestamp;
+	Bounds[NumberOfShards] = LastTimestamp + (int64_t)1;
+	for( size_t Shard = 1; Shard < NumberOfShards; Shard++ )
+	{
+		int64_t Target = TotalFrames*(int64_t)Shard/(int64_t)NumberOfShards;
+
+		// Timestamp of the frame of rank Target in time order: first timestamp with more than Target frames at or before it
+		HighResTimestamp Low = Bounds[Shard-1];
+		HighResTimestamp High = LastTimestamp;
+		while( Low < High )
+		{
+			HighResTimestamp Middle = Low + (High - Low)/2;
+			if ( CountFramesBefore( Middle + (int64_t)1 ) > Target )
+			{
+				High = Middle;
+			}
+			else
+			{
+				Low = Middle + (int64_t)1;
+			}
+		}
+		Bounds[Shard] = Low;
+	}
+
+	Shards.resize( NumberOfShards );
+	for( size_t Shard = 0; Shard < NumberOfShards; Shard++ )
+	{
+		SessionShard& CurrentShard = Shards[Shard];
+
+		CurrentShard.StartTimestamp = Bounds[Shard];
+		CurrentShard.EndTimestamp = Bounds[Shard+1];
+		CurrentShard.Streams.resize( Readers.size() );
+
+		for( Stream = 0; Stream < Readers.size(); Stream++ )
+		{
+			const TimestampIndex& Index = Readers[Stream]->Index;
+			const SessionStream& Description = Manifest.GetStream( Stream );
+			ShardStream& Part = CurrentShard.Streams[Stream];
+
+			Part.FirstEntry = GetFirstEntry( Stream, CurrentShard.StartTimestamp );
+			Part.EndEntry = GetFirstEntry( Stream, CurrentShard.EndTimestamp );
+			Part.NumberOfFrames = FramesBefore[Stream][Part.EndEntry] - FramesBefore[Stream][Part.FirstEntry];
+			CurrentShard.NumberOfFrames += Part.NumberOfFrames;
+
+			if ( Part.FirstEntry >= Part.EndEntry )
+			{
+				continue;
+			}
+
+			Part.TimestampPosition = Index[(size_t)Part.FirstEntry].Position;
+
+			if ( Description.Kind != SessionStream::RawStream )
+			{
+				continue;
+			}
+
+			for( int Entry = Part.FirstEntry; Entry < Part.EndEntry; Entry++ )
+			{
+				// First frame line (counted in FramesBefore)
+				if ( FramesBefore[Stream][Entry+1] == FramesBefore[Stream][Entry] )
+				{
+					continue;
+				}
+
+				Part.FirstFrameNumber = Index[(size_t)Entry].FrameNumber;
+
+				// Other formats locate their frames with their own tables
+				if ( Description.RawFormat == ReadTimestampRawFile::PlainRawFileFormat )
+				{
+					int64_t FirstSubFrame = (int64_t)(Part.FirstFrameNumber - Description.StartingFrame);
+					if ( Description.Mode == ReadTimestampRawFile::SubFramesMode )
+					{
+						FirstSubFrame = Index.GetSubFrameOffset( (size_t)Entry );
+					}
+					Part.RawPosition = FirstSubFrame*(int64_t)Description.FrameSize;
+				}
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+/** @brief Open the readers of a shard, positioned on the first line of the shard. Can be called by
+ *		   several workers at the same time.
+ *
+ * @param Shard [in] The shard (see Plan).
+ * @param ShardReaders [out] Reader of each stream, created from the manifest.
+ * @param Ranges [out] Lines of each stream in the shard.
+ * @return False if an index is not available or does not match the shard.
+ */
+bool ShardPlanner::OpenShard( const SessionShard& Shard, vector< unique_ptr<ReadTimestamp> >& ShardReaders, vector<StreamRange>& Ranges ) const
+{
+	SessionIndexer Indexer( NumberOfThreads );
+	size_t Stream;
+
+	Ranges.clear();
+
+	if ( Shard.Streams.size() != Manifest.GetNumberOfStreams() )
+	{
+		return false;
+	}
+
+	Manifest.CreateReaders( ShardReaders );
+	for( Stream = 0; Stream < ShardReaders.size(); Stream++ )
+	{
+		Indexer.AddStream( ShardReaders[Stream].get() );
+	}
+	if ( Indexer.Run() == false )
+	{
+		return false;
+	}
+
+	for( Stream = 0; Stream < ShardReaders.size(); Stream++ )
+	{
+		ReadTimestamp * Reader = ShardReaders[Stream].get();
+		ReadTimestampRawFile * RawReader = nullptr;
+		const ShardStream& Part = Shard.Streams[Stream];
+
+		if ( Manifest.GetStream( Stream ).Kind == SessionStream::RawStream )
+		{
+			RawReader = (ReadTimestampRawFile*)Reader;
+		}
+
+		Ranges.push_back( StreamRange( Reader, RawReader, Part.FirstEntry, Part.EndEntry ) );
+
+		if ( Part.FirstEntry >= Part.EndEntry )
+		{
+			continue;
+		}
+
+		// The timestamp file changed since the planning
+		if ( Part.EndEntry > (int)Reader->Index.Size() || Reader->Index[(size_t)Part.FirstEntry].Position != Part.TimestampPosition )
+		{
+			Ranges.clear();
+			return false;
+		}
+
+		// One seek, the first line of the shard is read
+		if ( Reader->GoToIndexEntry( Part.FirstEntry ) == false )
+		{
+			Ranges.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** @brief Number of frames of all streams strictly before a timestamp.
+ *
+ * @param Timestamp [in] The timestamp.
+ */
+int64_t ShardPlanner::CountFramesBefore( const HighResTimestamp& Timestamp ) const
+{
+	int64_t NumberOfFrames = 0;
+
+	for( size_t Stream = 0; Stream < Readers.size(); Stream++ )
+	{
+		NumberOfFrames += FramesBefore[Stream][(size_t)GetFirstEntry( Stream, Timestamp )];
+	}
+
+	return NumberOfFrames;
+}
+
+/** @brief First entry of the index of a stream at or after a timestamp.
+ *
+ * @param Stream [in] Number of the stream.
+ * @param Timestamp [in] The timestamp.
+ * @return The entry, size of the index if none.
+ */
+int ShardPlanner::GetFirstEntry( size_t Stream, const HighResTimestamp& Timestamp ) const
+{
+	const TimestampIndex& Index = Readers[Stream]->Index;
+
+	return (int)TimestampIndex::LowerBound( [&Index]( size_t Entry ) -> const HighResTimestamp& { return Index[Entry].Timestamp; }, Index.Size(), Timestamp );
+}
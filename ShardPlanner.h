@@ -0,0 +1,147 @@
+/**
+ * @file ShardPlanner.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __SHARD_PLANNER_H__
+#define __SHARD_PLANNER_H__
+
+#include <inttypes.h>
+
+#include <vector>
+#include <memory>
+
+#include "TimestampTools.h"
+#include "SessionManifest.h"
+#include "TimeWindowQuery.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct ShardStream ShardPlanner.h
+ * @brief Part of a stream in a shard (see SessionShard). Entries are the ones of the index of the stream.
+ */
+struct ShardStream
+{
+	int FirstEntry;							/*!< @brief First entry of the stream in the shard. */
+	int EndEntry;							/*!< @brief Entry following the last entry of the stream in the shard. */
+	int64_t TimestampPosition;				/*!< @brief Position of the first line in the timestamp file, -1 if the stream has no line in the shard. */
+	int FirstFrameNumber;					/*!< @brief Frame number of the first frame line, -1 if none (timestamp streams). */
+	int64_t RawPosition;					/*!< @brief Position of the first frame in usual raw files, -1 otherwise (frames are located by the reader). */
+	int64_t NumberOfFrames;					/*!< @brief Number of frames of the stream in the shard (lines for timestamp streams). */
+
+	/** @brief Constructor. Create an empty part.
+	 */
+	ShardStream() : FirstEntry(0), EndEntry(0), TimestampPosition(-1), FirstFrameNumber(-1), RawPosition(-1), NumberOfFrames(0) {}
+};
+
+/**
+ * @struct SessionShard ShardPlanner.h
+ * @brief A time shard of a session (see ShardPlanner): all lines of all streams in [StartTimestamp, EndTimestamp[.
+ */
+struct SessionShard
+{
+	HighResTimestamp StartTimestamp;		/*!< @brief First timestamp of the shard. */
+	HighResTimestamp EndTimestamp;			/*!< @brief Timestamp following the shard (excluded), start of the next shard. */
+	int64_t NumberOfFrames;					/*!< @brief Number of frames of all streams in the shard. */
+	std::vector<ShardStream> Streams;		/*!< @brief Part of each stream (in the order of the manifest). */
+
+	/** @brief Constructor. Create an empty shard.
+	 */
+	SessionShard() : NumberOfFrames(0) {}
+};
+
+/**
+ * @class ShardPlanner ShardPlanner.cpp ShardPlanner.h
+ * @brief Split a session in consecutive time shards with balanced numbers of frames (frames of raw streams
+ *		  and lines of timestamp streams), in order to process them in parallel. Shard bounds are found by
+ *		  binary search on the indexes of the streams, lines with the same timestamp are in the same shard.
+ *		  Each shard gives, for each stream, its entries and the positions of its first line and frame.
+ *		  Workers open their shard with OpenShard: readers are created from the manifest (no probing),
+ *		  saved indexes are loaded and each reader goes directly to the first line of the shard (one seek),
+ *		  nothing before the shard is read. Example:
+ *		  @code
+		  SessionManifest Manifest( "/data/Session01" );
+		  Manifest.Load();
+
+		  ShardPlanner Planner( Manifest );
+		  std::vector<SessionShard> Shards;
+		  Planner.Plan( 32, Shards );
+
+		  // In each worker
+		  std::vector< std::unique_ptr<ReadTimestamp> > Readers;
+		  std::vector<StreamRange> Ranges;
+		  Planner.OpenShard( Shards[Worker], Readers, Ranges );
+
+		  FrameView Frame;
+		  while( Ranges[0].NextFrame( Frame ) )
+		  {
+			  ...
+		  }
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class ShardPlanner
+{
+public:
+	/** @brief Constructor.
+	 *
+	 * @param eManifest [in] Manifest of the session (copied).
+	 * @param eNumberOfThreads [in] Number of threads loading (or building) the indexes, 0 means number of hardware threads (default=0).
+	 */
+	ShardPlanner( const SessionManifest& eManifest, unsigned int eNumberOfThreads = 0 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~ShardPlanner() {}
+
+	/** @brief Get the manifest of the session.
+	 */
+	const SessionManifest& GetManifest() const { return Manifest; }
+
+	/** @brief Split the session in time shards with balanced numbers of frames. Shards may be empty if
+	 *		   many lines share the same timestamp.
+	 *
+	 * @param NumberOfShards [in] Number of shards.
+	 * @param Shards [out] The shards, in time order.
+	 * @return False if an index is not available.
+	 */
+	bool Plan( size_t NumberOfShards, std::vector<SessionShard>& Shards );
+
+	/** @brief Open the readers of a shard, positioned on the first line of the shard. Can be called by
+	 *		   several workers at the same time.
+	 *
+	 * @param Shard [in] The shard (see Plan).
+	 * @param ShardReaders [out] Reader of each stream, created from the manifest.
+	 * @param Ranges [out] Lines of each stream in the shard.
+	 * @return False if an index is not available or does not match the shard.
+	 */
+	bool OpenShard( const SessionShard& Shard, std::vector< std::unique_ptr<ReadTimestamp> >& ShardReaders, std::vector<StreamRange>& Ranges ) const;
+
+protected:
+	/** @brief Number of frames of all streams strictly before a timestamp.
+	 *
+	 * @param Timestamp [in] The timestamp.
+	 */
+	int64_t CountFramesBefore( const HighResTimestamp& Timestamp ) const;
+
+	/** @brief First entry of the index of a stream at or after a timestamp.
+	 *
+	 * @param Stream [in] Number of the stream.
+	 * @param Timestamp [in] The timestamp.
+	 * @return The entry, size of the index if none.
+	 */
+	int GetFirstEntry( size_t Stream, const HighResTimestamp& Timestamp ) const;
+
+	SessionManifest Manifest;							/*!< @brief Manifest of the session. */
+	unsigned int NumberOfThreads;						/*!< @brief Number of threads loading the indexes. */
+	std::vector< std::unique_ptr<ReadTimestamp> > Readers;	/*!< @brief Readers holding the indexes used by Plan. */
+	std::vector< std::vector<int64_t> > FramesBefore;	/*!< @brief For each stream, number of frames before each entry of its index (and in the whole index). */
+};
+
+} // namespace MobileRGBD
+
+#endif // __SHARD_PLANNER_H__
@@ -0,0 +1,213 @@
+/**
+ * @file SharedFrameReader.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "SharedFrameReader.h"
+
+#include <string.h>
+
+using namespace std;
+using namespace MobileRGBD;
+
+/** @brief Constructor.
+ *
+ * @param WorkingFile [in] Name of the timestamp file.
+ * @param RawFile [in] Name of the associated raw file.
+ * @param SizeOfFrame [in] Size of each frame (or subframe) in the raw file.
+ * @param SubFrames [in] Read the file in ReadTimestampRawFile::SubFramesMode (default=false).
+ * @param MaxNumberOfFreeBuffers [in] Maximum number of free buffers kept in the pool (default=FrameBufferPool::DefaultMaxNumberOfFreeBuffers).
+ */
+SharedFrameReader::SharedFrameReader( const string &WorkingFile, const string& RawFile, int SizeOfFrame, bool SubFrames /* = false */,
+	size_t MaxNumberOfFreeBuffers /* = FrameBufferPool::DefaultMaxNumberOfFreeBuffers */ )
+	: Reader( WorkingFile, RawFile, SizeOfFrame )
+{
+	Reader.Mode = SubFrames ? ReadTimestampRawFile::SubFramesMode : ReadTimestampRawFile::SimpleFrameMode;
+	Pool = make_shared<FrameBufferPool>( MaxNumberOfFreeBuffers );
+	NumberOfReads = 0;
+}
+
+/** @brief Get a frame, shared with other consumers of this frame. Thread-safe.
+ *
+ * @param FrameNumber [in] Frame number in the raw file.
+ * @param View [out] View on the frame, with its timestamp.
+ * @return True if the full frame is available.
+ */
+bool SharedFrameReader::GetFrame( int FrameNumber, FrameView& View )
+{
+	View.Reset();
+
+	unique_lock<mutex> Lock( Protect );
+
+	for(;;)
+	{
+		// Frame still used by another consumer
+		map<int, SharedFrame>::iterator It = Frames.find( FrameNumber );
+		if ( It != Frames.end() )
+		{
+			shared_ptr<const void> Holder = It->second.Holder.lock();
+			if ( Holder != nullptr )
+			{
+				View = It->second.View;
+				View.Holder = Holder;
+				return true;
+			}
+			Frames.erase( It );
+		}
+
+		if ( Loading.find( FrameNumber ) == Loading.end() )
+		{
+			break;
+		}
+
+		// Another thread reads this frame, wait for it
+		LoadingDone.wait( Lock );
+	}
+
+	Loading.insert( FrameNumber );
+	Lock.unlock();
+
+	FrameView NewView;
+	bool Result = ReadFrame( FrameNumber, NewView );
+
+	Lock.lock();
+	Loading.erase( FrameNumber );
+
+	if ( Result == true )
+	{
+		NumberOfReads++;
+
+		// Forget frames released by all consumers
+		for( map<int, SharedFrame>::iterator It = Frames.begin(); It != Frames.end(); )
+		{
+			if ( It->second.Holder.expired() == true )
+			{
+				It = Frames.erase( It );
+			}
+			else
+			{
+				++It;
+			}
+		}
+
+		SharedFrame& Frame = Frames[FrameNumber];
+		Frame.View = NewView;
+		Frame.View.Holder.reset();
+		Frame.Holder = NewView.Holder;
+
+		View = NewView;
+	}
+
+	// Waiting consumers share the frame (or try again if the read failed)
+	LoadingDone.notify_all();
+
+	return Result;
+}
+
+/** @brief Get the frame of a specific timestamp using the index and a match policy (see GetFrame). Thread-safe.
+ *
+ * @param RequestedTimestamp [in] Requested timestamp.
+ * @param View [out] View on the frame.
+ * @param Policy [in] How to match the timestamp (default=TimestampIndex::MatchFloor, see TimestampIndex::MatchPolicy).
+ * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return True if the full frame is available.
+ */
+bool SharedFrameReader::LoadFrame( const TimeB &RequestedTimestamp, FrameView& View, TimestampIndex::MatchPolicy Policy /* = TimestampIndex::MatchFloor */,
+	unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	int FrameNumber = -1;
+
+	View.Reset();
+
+	{
+		lock_guard<mutex> Lock( ReaderProtect );
+
+		if ( PrepareReader() == false )
+		{
+			return false;
+		}
+
+		int Entry = Reader.Index.Find( RequestedTimestamp, Policy, ToleranceInMs );
+		if ( Entry >= 0 )
+		{
+			FrameNumber = Reader.Index[(size_t)Entry].FrameNumber;
+		}
+	}
+
+	if ( FrameNumber < 0 )
+	{
+		return false;
+	}
+
+	return GetFrame( FrameNumber, View );
+}
+
+/** @brief Number of frames actually read from the raw file, i.e. not shared.
+ */
+uint64_t SharedFrameReader::GetNumberOfReads()
+{
+	lock_guard<mutex> Lock( Protect );
+
+	return NumberOfReads;
+}
+
+/** @brief Open the timestamp file (for the starting frame) and build its index, once. ReaderProtect must be locked.
+ *
+ * @return True if the reader is ready.
+ */
+bool SharedFrameReader::PrepareReader()
+{
+	if ( Reader.Index.IsEmpty() == false )
+	{
+		return true;
+	}
+
+	// The index gives the timestamps of the frames
+	Reader.Reinit();
+
+	return Reader.BuildIndex();
+}
+
+/** @brief Read a frame in a buffer of the pool. Only one thread uses Reader at a time.
+ *
+ * @param FrameNumber [in] Frame number in the raw file.
+ * @param View [out] View on the frame.
+ * @return True if the full frame was read.
+ */
+bool SharedFrameReader::ReadFrame( int FrameNumber, FrameView& View )
+{
+	lock_guard<mutex> Lock( ReaderProtect );
+
+	if ( PrepareReader() == false || Reader.GetFrame( FrameNumber ) == false )
+	{
+		return false;
+	}
+
+	int Entry = Reader.Index.FindFrameNumber( FrameNumber );
+	if ( Entry >= 0 )
+	{
+		View.Timestamp = Reader.Index[(size_t)Entry].Timestamp;
+	}
+
+	View.FrameIndex = FrameNumber - Reader.StartingFrame;
+	View.NumberOfSubFrames = Reader.NumberOfSubFrames;
+
+	size_t LoadSize = (size_t)Reader.FrameSize*(size_t)Reader.NumberOfSubFrames;
+	if ( LoadSize == 0 )
+	{
+		// Timestamp with empty data
+		return true;
+	}
+
+	// The reader reuses its own buffer, the frame is copied in a buffer owned by the views
+	shared_ptr< vector<unsigned char> > Buffer = Pool->Acquire( LoadSize );
+	memcpy( &(*Buffer)[0], Reader.FrameData, LoadSize );
+
+	View.Data = &(*Buffer)[0];
+	View.Size = LoadSize;
+	View.Holder = Buffer;
+
+	return true;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file SharedFrameReader.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __SHARED_FRAME_READER_H__
+#define __SHARED_FRAME_READER_H__
+
+#include <inttypes.h>
+
+#include <string>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+#include "ReadTimestampRawFile.h"
+#include "FrameBufferPool.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class SharedFrameReader SharedFrameReader.cpp SharedFrameReader.h
+ * @brief Thread-safe access to the frames of a raw file for several consumers. Frames are
+ *		  immutable and reference counted (see FrameView): while a frame is referenced, other
+ *		  requests for it share the same data, and concurrent requests for a frame being read
+ *		  wait for this read instead of reading it again. Frame buffers come from a FrameBufferPool
+ *		  and return to it when the last view is released. Example:
+ *		  @code
+		  SharedFrameReader Depth( "depth.timestamp", "depth.raw", 512*424*2 );
+
+		  // In each analysis thread
+		  FrameView Frame;
+		  if ( Depth.LoadFrame( Timestamp, Frame ) )
+		  {
+			  Process( (const uint16_t*)Frame.Data );
+		  }
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class SharedFrameReader
+{
+public:
+	/** @brief Constructor.
+	 *
+	 * @param WorkingFile [in] Name of the timestamp file.
+	 * @param RawFile [in] Name of the associated raw file.
+	 * @param SizeOfFrame [in] Size of each frame (or subframe) in the raw file.
+	 * @param SubFrames [in] Read the file in ReadTimestampRawFile::SubFramesMode (default=false).
+	 * @param MaxNumberOfFreeBuffers [in] Maximum number of free buffers kept in the pool (default=FrameBufferPool::DefaultMaxNumberOfFreeBuffers).
+	 */
+	SharedFrameReader( const std::string &WorkingFile, const std::string& RawFile, int SizeOfFrame, bool SubFrames = false,
+		size_t MaxNumberOfFreeBuffers = FrameBufferPool::DefaultMaxNumberOfFreeBuffers );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~SharedFrameReader() {}
+
+	/** @brief Get a frame, shared with other consumers of this frame. Thread-safe.
+	 *
+	 * @param FrameNumber [in] Frame number in the raw file.
+	 * @param View [out] View on the frame, with its timestamp.
+	 * @return True if the full frame is available.
+	 */
+	bool GetFrame( int FrameNumber, FrameView& View );
+
+	/** @brief Get the frame of a specific timestamp using the index and a match policy (see GetFrame). Thread-safe.
+	 *
+	 * @param RequestedTimestamp [in] Requested timestamp.
+	 * @param View [out] View on the frame.
+	 * @param Policy [in] How to match the timestamp (default=TimestampIndex::MatchFloor, see TimestampIndex::MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return True if the full frame is available.
+	 */
+	bool LoadFrame( const TimeB &RequestedTimestamp, FrameView& View, TimestampIndex::MatchPolicy Policy = TimestampIndex::MatchFloor,
+		unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
+	/** @brief Number of frames actually read from the raw file, i.e. not shared.
+	 */
+	uint64_t GetNumberOfReads();
+
+	/** @brief Pool of the frame buffers.
+	 */
+	const std::shared_ptr<FrameBufferPool>& GetBufferPool() const { return Pool; }
+
+protected:
+	/** @brief Open the timestamp file (for the starting frame) and build its index, once. ReaderProtect must be locked.
+	 *
+	 * @return True if the reader is ready.
+	 */
+	bool PrepareReader();
+
+	/** @brief Read a frame in a buffer of the pool. Only one thread uses Reader at a time.
+	 *
+	 * @param FrameNumber [in] Frame number in the raw file.
+	 * @param View [out] View on the frame.
+	 * @return True if the full frame was read.
+	 */
+	bool ReadFrame( int FrameNumber, FrameView& View );
+
+	/**
+	 * @struct SharedFrameReader::SharedFrame SharedFrameReader.h
+	 * @brief A frame referenced by consumers. The frame is not kept alive by the reader.
+	 */
+	struct SharedFrame
+	{
+		FrameView View;							/*!< @brief View on the frame, without holder. */
+		std::weak_ptr<const void> Holder;		/*!< @brief Holder of the data, expired when no consumer uses the frame. */
+	};
+
+	ReadTimestampRawFile Reader;				/*!< @brief Reader of the files, protected by ReaderProtect. */
+	std::mutex ReaderProtect;					/*!< @brief Only one read at a time. */
+	std::shared_ptr<FrameBufferPool> Pool;		/*!< @brief Buffers of the frames. */
+	std::map<int, SharedFrame> Frames;			/*!< @brief Frames that may still be referenced, by frame number. */
+	std::set<int> Loading;						/*!< @brief Frames being read. */
+	uint64_t NumberOfReads;						/*!< @brief Number of frames read from the raw file. */
+	std::mutex Protect;							/*!< @brief Protect Frames, Loading and NumberOfReads. */
+	std::condition_variable LoadingDone;		/*!< @brief Signaled when a read ends. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __SHARED_FRAME_READER_H__
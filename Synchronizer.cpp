@@ -0,0 +1,240 @@
+/**
+ * @file Synchronizer.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "Synchronizer.h"
+#include "SessionIndexer.h"
+
+#include <stdlib.h>
+
+using namespace std;
+using namespace MobileRGBD;
+
+/** @brief Constructor.
+ *
+ * @param eNumberOfThreads [in] Number of threads building the indexes, 0 means number of hardware threads (default=0).
+ */
+Synchronizer::Synchronizer( unsigned int eNumberOfThreads /* = 0 */ )
+{
+	MasterStream = 0;
+	MasterEntry = -1;
+	NumberOfThreads = eNumberOfThreads;
+}
+
+/** @brief Add a stream. The reader is not owned by the synchronizer, it must stay alive.
+ *		   The first stream is the master stream by default.
+ *
+ * @param Stream [in] Reader of the timestamp file.
+ * @param ToleranceInMs [in] Maximum distance between a line of this stream and a master line in tuples (default=ReadTimestamp::DefaultValidityTimeInMs).
+ * @return Number of the stream.
+ */
+size_t Synchronizer::AddStream( ReadTimestamp * Stream, unsigned int ToleranceInMs /* = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs */ )
+{
+	StreamState NewStream;
+
+	NewStream.Reader = Stream;
+	NewStream.ToleranceInNs = (int64_t)ToleranceInMs*HighResTimestamp::NanosecondsPerMillisecond;
+	NewStream.NextEntry = -1;
+	NewStream.TupleEntry = 0;
+
+	Streams.push_back( NewStream );
+
+	return Streams.size()-1;
+}
+
+/** @brief Select the stream giving the timestamps of the tuples (see GetNextTuple).
+ *
+ * @param Stream [in] Number of the stream.
+ * @return True if the stream exists.
+ */
+bool Synchronizer::SetMasterStream( size_t Stream )
+{
+	if ( Stream >= Streams.size() )
+	{
+		return false;
+	}
+
+	MasterStream = Stream;
+	return true;
+}
+
+/** @brief Build (or load) the indexes of the streams and start reading them.
+ *
+ * @param FirstTimestamp [in] Start at the first lines at or after this timestamp (default=beginning of the streams).
+ * @return True if all indexes are available.
+ */
+bool Synchronizer::Start( const HighResTimestamp& FirstTimestamp /* = HighResTimestamp() */ )
+{
+	SessionIndexer Indexer( NumberOfThreads );
+	size_t i;
+
+	NextTimestamps = priority_queue< HeapEntry, vector<HeapEntry>, greater<HeapEntry> >();
+	MasterEntry = -1;
+
+	if ( Streams.empty() )
+	{
+		return false;
+	}
+
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		Indexer.AddStream( Streams[i].Reader );
+	}
+	if ( Indexer.Run() == false )
+	{
+		return false;
+	}
+
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		StreamState& Stream = Streams[i];
+		const TimestampIndex& Index = Stream.Reader->Index;
+
+		Stream.NextEntry = Index.Find( FirstTimestamp, TimestampIndex::MatchCeil, -1 );
+		if ( Stream.NextEntry >= 0 )
+		{
+			NextTimestamps.push( HeapEntry( Index[(size_t)Stream.NextEntry].Timestamp, i ) );
+		}
+
+		Stream.TupleEntry = Index.Find( FirstTimestamp, TimestampIndex::MatchFloor, -1 );
+		if ( Stream.TupleEntry < 0 )
+		{
+			Stream.TupleEntry = 0;
+		}
+	}
+
+	MasterEntry = Streams[MasterStream].NextEntry;
+
+	return true;
+}
+
+/** @brief Get the next line of all streams in time order (lines with the same timestamp in stream order).
+ *		   The reader of the stream is on this line.
+ *
+ * @param NextEvent [out] The line.
+ * @return False at the end of all streams.
+ */
+bool Synchronizer::GetNextEvent( Event& NextEvent )
+{
+	if ( NextTimestamps.empty() )
+	{
+		return false;
+	}
+
+	HeapEntry Next = NextTimestamps.top();
+	NextTimestamps.pop();
+
+	StreamState& Stream = Streams[Next.second];
+	const TimestampIndex& Index = Stream.Reader->Index;
+
+	NextEvent.Stream = Next.second;
+	NextEvent.IndexEntry = Stream.NextEntry;
+	NextEvent.Timestamp = Next.first;
+
+	// Only one timestamp per stream in the heap
+	Stream.NextEntry++;
+	if ( Stream.NextEntry < (int)Index.Size() )
+	{
+		NextTimestamps.push( HeapEntry( Index[(size_t)Stream.NextEntry].Timestamp, Next.second ) );
+	}
+	else
+	{
+		Stream.NextEntry = -1;
+	}
+
+	return Stream.Reader->GoToIndexEntry( NextEvent.IndexEntry );
+}
+
+/** @brief Get the next line of the master stream and the nearest line of each other stream. Readers
+ *		   are on the lines of the tuple.
+ *
+ * @param Entries [out] Entry in the index of each stream, -1 if no line is within the tolerance of the stream.
+ * @param SkipIncomplete [in] Skip master lines without a line of each stream (default=true).
+ * @return False at the end of the master stream.
+ */
+bool Synchronizer::GetNextTuple( vector<int>& Entries, bool SkipIncomplete /* = true */ )
+{
+	size_t i;
+
+	Entries.assign( Streams.size(), -1 );
+
+	if ( Streams.empty() )
+	{
+		return false;
+	}
+
+	const TimestampIndex& MasterIndex = Streams[MasterStream].Reader->Index;
+
+	while( MasterEntry >= 0 && MasterEntry < (int)MasterIndex.Size() )
+	{
+		HighResTimestamp MasterTimestamp = MasterIndex[(size_t)MasterEntry].Timestamp;
+		bool Complete = true;
+
+		Entries[MasterStream] = MasterEntry++;
+
+		for( i = 0; i < Streams.size(); i++ )
+		{
+			StreamState& Stream = Streams[i];
+			const TimestampIndex& Index = Stream.Reader->Index;
+			int NumberOfEntries = (int)Index.Size();
+
+			if ( i == MasterStream )
+			{
+				continue;
+			}
+
+			if ( NumberOfEntries == 0 )
+			{
+				Complete = false;
+				continue;
+			}
+
+			// Master timestamps increase, the cursor only moves forward
+			while( Stream.TupleEntry+1 < NumberOfEntries && Index[(size_t)Stream.TupleEntry+1].Timestamp <= MasterTimestamp )
+			{
+				Stream.TupleEntry++;
+			}
+
+			// Nearest of the lines around the master timestamp
+			int Nearest = Stream.TupleEntry;
+			int64_t Distance = llabs( Index[(size_t)Nearest].Timestamp - MasterTimestamp );
+			if ( Nearest+1 < NumberOfEntries && llabs( Index[(size_t)Nearest+1].Timestamp - MasterTimestamp ) < Distance )
+			{
+				Nearest++;
+				Distance = llabs( Index[(size_t)Nearest].Timestamp - MasterTimestamp );
+			}
+
+			if ( Distance <= Stream.ToleranceInNs )
+			{
+				Entries[i] = Nearest;
+			}
+			else
+			{
+				Complete = false;
+			}
+		}
+
+		if ( Complete == false && SkipIncomplete == true )
+		{
+			Entries.assign( Streams.size(), -1 );
+			continue;
+		}
+
+		// Read the lines of the tuple
+		bool Result = true;
+		for( i = 0; i < Streams.size(); i++ )
+		{
+			if ( Entries[i] >= 0 )
+			{
+				Result = Streams[i].Reader->GoToIndexEntry( Entries[i] ) && Result;
+			}
+		}
+		return Result;
+	}
+
+	MasterEntry = -1;
+	return false;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file Synchronizer.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __SYNCHRONIZER_H__
+#define __SYNCHRONIZER_H__
+
+#include <inttypes.h>
+
+#include <vector>
+#include <queue>
+#include <utility>
+#include <functional>
+
+#include "ReadTimestamp.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class Synchronizer Synchronizer.cpp Synchronizer.h
+ * @brief Read several streams of a session together, like a ROS bag. Streams are merged using their
+ *		  indexes (built concurrently by Start, see SessionIndexer):
+ *		  - GetNextEvent gives the lines of all streams in time order. A heap of the next timestamp
+ *		    of each stream costs O(log N) per event for N streams.
+ *		  - GetNextTuple gives, for each line of a master stream, the nearest line of each other stream within
+ *		    its tolerance. Each stream keeps a cursor moving forward, there is no search per tuple.
+ *		  After each call, readers are on the returned lines (only these lines are read), frames can be loaded
+ *		  as usual. Example:
+ *		  @code
+		  Synchronizer Sync;
+		  size_t DepthStream = Sync.AddStream( &Depth );
+		  size_t RobotStream = Sync.AddStream( &Robot, 50 );
+		  Sync.SetMasterStream( DepthStream );
+		  Sync.Start();
+
+		  std::vector<int> Entries;
+		  while( Sync.GetNextTuple( Entries ) )
+		  {
+			  Depth.GetFrame( Depth.GetFrameNumber() );
+			  Process( Depth, Robot );
+		  }
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class Synchronizer
+{
+public:
+	/**
+	 * @struct Synchronizer::Event Synchronizer.h
+	 * @brief A line of a stream (see GetNextEvent).
+	 */
+	struct Event
+	{
+		size_t Stream;						/*!< @brief Stream of the line (as returned by AddStream). */
+		int IndexEntry;						/*!< @brief Entry of the line in the index of the stream. */
+		HighResTimestamp Timestamp;			/*!< @brief Timestamp of the line. */
+	};
+
+	/** @brief Constructor.
+	 *
+	 * @param eNumberOfThreads [in] Number of threads building the indexes, 0 means number of hardware threads (default=0).
+	 */
+	Synchronizer( unsigned int eNumberOfThreads = 0 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~Synchronizer() {}
+
+	/** @brief Add a stream. The reader is not owned by the synchronizer, it must stay alive.
+	 *		   The first stream is the master stream by default.
+	 *
+	 * @param Stream [in] Reader of the timestamp file.
+	 * @param ToleranceInMs [in] Maximum distance between a line of this stream and a master line in tuples (default=ReadTimestamp::DefaultValidityTimeInMs).
+	 * @return Number of the stream.
+	 */
+	size_t AddStream( ReadTimestamp * Stream, unsigned int ToleranceInMs = (unsigned int)ReadTimestamp::DefaultValidityTimeInMs );
+
+	/** @brief Number of streams.
+	 */
+	size_t GetNumberOfStreams() const { return Streams.size(); }
+
+	/** @brief Get the reader of a stream.
+	 *
+	 * @param Stream [in] Number of the stream.
+	 */
+	ReadTimestamp * GetStream( size_t Stream ) const { return Streams[Stream].Reader; }
+
+	/** @brief Select the stream giving the timestamps of the tuples (see GetNextTuple).
+	 *
+	 * @param Stream [in] Number of the stream.
+	 * @return True if the stream exists.
+	 */
+	bool SetMasterStream( size_t Stream );
+
+	/** @brief Build (or load) the indexes of the streams and start reading them.
+	 *
+	 * @param FirstTimestamp [in] Start at the first lines at or after this timestamp (default=beginning of the streams).
+	 * @return True if all indexes are available.
+	 */
+	bool Start( const HighResTimestamp& FirstTimestamp = HighResTimestamp() );
+
+	/** @brief Get the next line of all streams in time order (lines with the same timestamp in stream order).
+	 *		   The reader of the stream is on this line.
+	 *
+	 * @param NextEvent [out] The line.
+	 * @return False at the end of all streams.
+	 */
+	bool GetNextEvent( Event& NextEvent );
+
+	/** @brief Get the next line of the master stream and the nearest line of each other stream. Readers
+	 *		   are on the lines of the tuple.
+	 *
+	 * @param Entries [out] Entry in the index of each stream, -1 if no line is within the tolerance of the stream.
+	 * @param SkipIncomplete [in] Skip master lines without a line of each stream (default=true).
+	 * @return False at the end of the master stream.
+	 */
+	bool GetNextTuple( std::vector<int>& Entries, bool SkipIncomplete = true );
+
+protected:
+	/**
+	 * @struct Synchronizer::StreamState Synchronizer.h
+	 * @brief A stream and its reading state.
+	 */
+	struct StreamState
+	{
+		ReadTimestamp * Reader;				/*!< @brief Reader of the stream. */
+		int64_t ToleranceInNs;				/*!< @brief Maximum distance to the master line in tuples. */
+		int NextEntry;						/*!< @brief Next entry of the stream given by GetNextEvent (-1 at the end). */
+		int TupleEntry;						/*!< @brief Last entry at or before the master line in tuples (first entry otherwise). */
+	};
+
+	typedef std::pair<HighResTimestamp, size_t> HeapEntry;		/*!< @brief Next timestamp of a stream and the stream. */
+
+	std::vector<StreamState> Streams;		/*!< @brief Streams to read. */
+	size_t MasterStream;					/*!< @brief Stream giving the timestamps of the tuples. */
+	int MasterEntry;						/*!< @brief Next entry of the master stream in tuples (-1 at the end). */
+	std::priority_queue< HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry> > NextTimestamps;	/*!< @brief Streams by next timestamp (GetNextEvent). */
+	unsigned int NumberOfThreads;			/*!< @brief Number of threads building the indexes. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __SYNCHRONIZER_H__
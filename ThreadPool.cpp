@@ -0,0 +1,80 @@
+/**
+ * @file ThreadPool.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "ThreadPool.h"
+
+using namespace MobileRGBD;
+
+/** @brief Constructor. Start the worker threads.
+ *
+ * @param NumberOfThreads [in] Number of worker threads, 0 means number of hardware threads (default=0).
+ */
+ThreadPool::ThreadPool( unsigned int NumberOfThreads /* = 0 */ )
+{
+	Stopping = false;
+
+	if ( NumberOfThreads == 0 )
+	{
+		NumberOfThreads = std::thread::hardware_concurrency();
+		if ( NumberOfThreads == 0 )
+		{
+			// Unknown value
+			NumberOfThreads = 2;
+		}
+	}
+
+	for( unsigned int i = 0; i < NumberOfThreads; i++ )
+	{
+		Threads.push_back( std::thread( &ThreadPool::Worker, this ) );
+	}
+}
+
+/** @brief Virtual destructor, always. Wait for all pending tasks and stop the threads.
+ */
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> Lock( Protect );
+		Stopping = true;
+	}
+	NewTask.notify_all();
+
+	for( size_t i = 0; i < Threads.size(); i++ )
+	{
+		Threads[i].join();
+	}
+}
+
+/** @brief Main loop of worker threads.
+ */
+void ThreadPool::Worker()
+{
+	for(;;)
+	{
+		std::function<void()> Task;
+
+		{
+			std::unique_lock<std::mutex> Lock( Protect );
+			while( Stopping == false && Tasks.empty() )
+			{
+				NewTask.wait( Lock );
+			}
+
+			if ( Tasks.empty() )
+			{
+				// Stopping and nothing more to do
+				return;
+			}
+
+			Task = Tasks.front();
+			Tasks.pop_front();
+		}
+
+		// Exceptions are stored in the future by the packaged task
+		Task();
+	}
+}
@@ -0,0 +1,84 @@
+/**
+ * @file ThreadPool.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <future>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include <mutex>
+
+namespace MobileRGBD {
+
+/**
+ * @class ThreadPool ThreadPool.cpp ThreadPool.h
+ * @brief Simple pool of worker threads executing tasks in submission order. Results (or exceptions)
+ *		  of tasks are retrieved using std::future. A task must not wait for another task of the same
+ *		  pool (all workers could be waiting).
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class ThreadPool
+{
+public:
+	/** @brief Constructor. Start the worker threads.
+	 *
+	 * @param NumberOfThreads [in] Number of worker threads, 0 means number of hardware threads (default=0).
+	 */
+	ThreadPool( unsigned int NumberOfThreads = 0 );
+
+	/** @brief Virtual destructor, always. Wait for all pending tasks and stop the threads.
+	 */
+	virtual ~ThreadPool();
+
+	/** @brief Submit a task to the pool.
+	 *
+	 * @param Task [in] Callable object without parameter.
+	 * @return A future to retrieve the result of the task.
+	 */
+	template<typename Function>
+	std::future<typename std::result_of<Function()>::type> Submit( Function Task )
+	{
+		typedef typename std::result_of<Function()>::type ResultType;
+
+		// std::function must be copyable, share the packaged task
+		std::shared_ptr< std::packaged_task<ResultType()> > SharedTask = std::make_shared< std::packaged_task<ResultType()> >( Task );
+		std::future<ResultType> Result = SharedTask->get_future();
+
+		{
+			std::lock_guard<std::mutex> Lock( Protect );
+			Tasks.push_back( [SharedTask]() { (*SharedTask)(); } );
+		}
+		NewTask.notify_one();
+
+		return Result;
+	}
+
+	/** @brief Number of worker threads.
+	 */
+	unsigned int GetNumberOfThreads() const { return (unsigned int)Threads.size(); }
+
+protected:
+	/** @brief Main loop of worker threads.
+	 */
+	void Worker();
+
+	std::vector<std::thread> Threads;					/*!< @brief Worker threads. */
+	std::deque< std::function<void()> > Tasks;			/*!< @brief Pending tasks. */
+	std::mutex Protect;									/*!< @brief Protect access to Tasks and Stopping. */
+	std::condition_variable NewTask;					/*!< @brief Signal new tasks (or stop) to workers. */
+	bool Stopping;										/*!< @brief Ask workers to stop when no more task is pending. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __THREAD_POOL_H__
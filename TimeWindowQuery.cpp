@@ -0,0 +1,203 @@
+/**
+ * @file TimeWindowQuery.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "TimeWindowQuery.h"
+#include "SessionIndexer.h"
+
+using namespace std;
+using namespace MobileRGBD;
+
+/** @brief Constructor.
+ *
+ * @param eReader [in] Reader of the stream (default=nullptr, empty range).
+ * @param eRawReader [in] Same reader if this is a raw stream, nullptr otherwise (default=nullptr).
+ * @param eFirstEntry [in] First entry of the window in the index of the stream (default=0).
+ * @param eEndEntry [in] Entry following the last entry of the window (default=0).
+ */
+StreamRange::StreamRange( ReadTimestamp * eReader /* = nullptr */, ReadTimestampRawFile * eRawReader /* = nullptr */, int eFirstEntry /* = 0 */, int eEndEntry /* = 0 */ )
+{
+	Reader = eReader;
+	RawReader = eRawReader;
+	FirstEntry = eFirstEntry;
+	EndEntry = eEndEntry;
+	NextEntry = FirstEntry;
+}
+
+/** @brief Read the next line of the window. The reader is on this line (timestamp, data, frame number, ...).
+ *
+ * @return False at the end of the window.
+ */
+bool StreamRange::Next()
+{
+	if ( Reader == nullptr || NextEntry >= EndEntry )
+	{
+		return false;
+	}
+
+	return Reader->GoToIndexEntry( NextEntry++ );
+}
+
+/** @brief Get a view on the next frame of the window (raw streams only), without copy when the
+ *		   raw file can be mapped. Lines without frame are skipped. The reader is on the line of the frame.
+ *
+ * @param View [out] View on the frame.
+ * @return False at the end of the window (or on error).
+ */
+bool StreamRange::NextFrame( FrameView& View )
+{
+	View.Reset();
+
+	if ( RawReader == nullptr )
+	{
+		return false;
+	}
+
+	while( NextEntry < EndEntry && IsFrameEntry( NextEntry ) == false )
+	{
+		NextEntry++;
+	}
+
+	if ( NextEntry >= EndEntry || RawReader->GoToIndexEntry( NextEntry ) == false )
+	{
+		return false;
+	}
+
+	return RawReader->GetFrameView( RawReader->Index[(size_t)NextEntry++].FrameNumber, View );
+}
+
+/** @brief Get views on the next frames of the window (raw streams only), loaded with a single read
+ *		   (see ReadTimestampRawFile::GetFrames). The current line of the reader does not change.
+ *
+ * @param MaxNumberOfFrames [in] Maximum number of frames to load.
+ * @param Views [out] Views on the loaded frames, with their timestamps.
+ * @return False at the end of the window (or on error).
+ */
+bool StreamRange::NextFrames( int MaxNumberOfFrames, vector<FrameView>& Views )
+{
+	int FirstFrameEntry = -1;
+	int NumberOfFrames = 0;
+
+	Views.clear();
+
+	if ( RawReader == nullptr || MaxNumberOfFrames <= 0 )
+	{
+		return false;
+	}
+
+	// Frames of the batch, GetFrames must not load frames after the window
+	for( ; NextEntry < EndEntry && NumberOfFrames < MaxNumberOfFrames; NextEntry++ )
+	{
+		if ( IsFrameEntry( NextEntry ) == true )
+		{
+			if ( FirstFrameEntry < 0 )
+			{
+				FirstFrameEntry = NextEntry;
+			}
+			NumberOfFrames++;
+		}
+	}
+
+	if ( NumberOfFrames == 0 )
+	{
+		return false;
+	}
+
+	return RawReader->GetFrames( RawReader->Index[(size_t)FirstFrameEntry].FrameNumber, NumberOfFrames, Views );
+}
+
+/** @brief Check if an entry of the index of a raw stream is a frame line (see ReadTimestampRawFile::GetFrames).
+ *
+ * @param Entry [in] The entry.
+ */
+bool StreamRange::IsFrameEntry( int Entry ) const
+{
+	const TimestampIndexEntry& Line = RawReader->Index[(size_t)Entry];
+
+	return Line.FrameNumber >= 0 && (RawReader->Mode != ReadTimestampRawFile::SubFramesMode || Line.NumberOfSubFrames >= 0);
+}
+
+/** @brief Constructor.
+ *
+ * @param eNumberOfThreads [in] Number of threads building the indexes, 0 means number of hardware threads (default=0).
+ */
+TimeWindowQuery::TimeWindowQuery( unsigned int eNumberOfThreads /* = 0 */ )
+{
+	IndexesReady = false;
+	NumberOfThreads = eNumberOfThreads;
+}
+
+/** @brief Add a stream. The reader is not owned by the query, it must stay alive.
+ *
+ * @param Stream [in] Reader of the timestamp file.
+ * @return Number of the stream.
+ */
+size_t TimeWindowQuery::AddStream( ReadTimestamp * Stream )
+{
+	Streams.push_back( Stream );
+	RawStreams.push_back( nullptr );
+	IndexesReady = false;
+
+	return Streams.size()-1;
+}
+
+/** @brief Add a raw stream, its frames can be read from the ranges. The reader is not owned by the query, it must stay alive.
+ *
+ * @param Stream [in] Reader of the raw stream.
+ * @return Number of the stream.
+ */
+size_t TimeWindowQuery::AddStream( ReadTimestampRawFile * Stream )
+{
+	size_t NewStream = AddStream( (ReadTimestamp*)Stream );
+	RawStreams[NewStream] = Stream;
+
+	return NewStream;
+}
+
+/** @brief Get the range of each stream in a time window.
+ *
+ * @param StartTimestamp [in] First timestamp of the window.
+ * @param EndTimestamp [in] Last timestamp of the window (included).
+ * @param Ranges [out] Range of each stream (in the order of AddStream), empty if no line is in the window.
+ * @return False if an index is not available.
+ */
+bool TimeWindowQuery::Run( const HighResTimestamp& StartTimestamp, const HighResTimestamp& EndTimestamp, vector<StreamRange>& Ranges )
+{
+	size_t i;
+
+	Ranges.clear();
+
+	if ( IndexesReady == false )
+	{
+		// Only the first query pays for the indexes
+		SessionIndexer Indexer( NumberOfThreads );
+		for( i = 0; i < Streams.size(); i++ )
+		{
+			Indexer.AddStream( Streams[i] );
+		}
+		if ( Indexer.Run() == false )
+		{
+			return false;
+		}
+		IndexesReady = true;
+	}
+
+	for( i = 0; i < Streams.size(); i++ )
+	{
+		int FirstEntry, EndEntry;
+
+		if ( Streams[i]->IsInFollowMode() == true )
+		{
+			// Lines may have been written since
+			Streams[i]->UpdateIndex();
+		}
+
+		Streams[i]->Index.FindRange( StartTimestamp, EndTimestamp, FirstEntry, EndEntry );
+		Ranges.push_back( StreamRange( Streams[i], RawStreams[i], FirstEntry, EndEntry ) );
+	}
+
+	return true;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file TimeWindowQuery.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __TIME_WINDOW_QUERY_H__
+#define __TIME_WINDOW_QUERY_H__
+
+#include <vector>
+
+#include "FrameView.h"
+#include "ReadTimestamp.h"
+#include "ReadTimestampRawFile.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class StreamRange TimeWindowQuery.cpp TimeWindowQuery.h
+ * @brief Iterator over the lines of a stream in a time window (see TimeWindowQuery). Lines are
+ *		  located with the index of the stream, only lines of the window are read. Frames of raw
+ *		  streams are given as views, one by one (GetFrameView, no copy) or by batches (GetFrames,
+ *		  one read per batch).
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class StreamRange
+{
+public:
+	/** @brief Constructor.
+	 *
+	 * @param eReader [in] Reader of the stream (default=nullptr, empty range).
+	 * @param eRawReader [in] Same reader if this is a raw stream, nullptr otherwise (default=nullptr).
+	 * @param eFirstEntry [in] First entry of the window in the index of the stream (default=0).
+	 * @param eEndEntry [in] Entry following the last entry of the window (default=0).
+	 */
+	StreamRange( ReadTimestamp * eReader = nullptr, ReadTimestampRawFile * eRawReader = nullptr, int eFirstEntry = 0, int eEndEntry = 0 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~StreamRange() {}
+
+	/** @brief Return true if no line of the stream is in the window.
+	 */
+	bool IsEmpty() const { return (FirstEntry >= EndEntry); }
+
+	/** @brief Number of lines in the window.
+	 */
+	int GetNumberOfLines() const { return EndEntry - FirstEntry; }
+
+	/** @brief First entry of the window in the index of the stream.
+	 */
+	int GetFirstEntry() const { return FirstEntry; }
+
+	/** @brief Entry following the last entry of the window in the index of the stream.
+	 */
+	int GetEndEntry() const { return EndEntry; }
+
+	/** @brief Come back at the beginning of the window.
+	 */
+	void Rewind() { NextEntry = FirstEntry; }
+
+	/** @brief Read the next line of the window. The reader is on this line (timestamp, data, frame number, ...).
+	 *
+	 * @return False at the end of the window.
+	 */
+	bool Next();
+
+	/** @brief Get a view on the next frame of the window (raw streams only), without copy when the
+	 *		   raw file can be mapped. Lines without frame are skipped. The reader is on the line of the frame.
+	 *
+	 * @param View [out] View on the frame.
+	 * @return False at the end of the window (or on error).
+	 */
+	bool NextFrame( FrameView& View );
+
+	/** @brief Get views on the next frames of the window (raw streams only), loaded with a single read
+	 *		   (see ReadTimestampRawFile::GetFrames). The current line of the reader does not change.
+	 *
+	 * @param MaxNumberOfFrames [in] Maximum number of frames to load.
+	 * @param Views [out] Views on the loaded frames, with their timestamps.
+	 * @return False at the end of the window (or on error).
+	 */
+	bool NextFrames( int MaxNumberOfFrames, std::vector<FrameView>& Views );
+
+protected:
+	/** @brief Check if an entry of the index of a raw stream is a frame line (see ReadTimestampRawFile::GetFrames).
+	 *
+	 * @param Entry [in] The entry.
+	 */
+	bool IsFrameEntry( int Entry ) const;
+
+	ReadTimestamp * Reader;						/*!< @brief Reader of the stream. */
+	ReadTimestampRawFile * RawReader;			/*!< @brief Same reader for raw streams, nullptr otherwise. */
+	int FirstEntry;								/*!< @brief First entry of the window. */
+	int EndEntry;								/*!< @brief Entry following the last entry of the window. */
+	int NextEntry;								/*!< @brief Next entry given by the iterator. */
+};
+
+/**
+ * @class TimeWindowQuery TimeWindowQuery.cpp TimeWindowQuery.h
+ * @brief Get all lines of several streams in a time window, e.g. around an annotated event. Indexes are built
+ *		  (or loaded) concurrently by the first query (see SessionIndexer), each query then jumps to the
+ *		  window of each stream without reading lines outside of it. Example:
+ *		  @code
+		  TimeWindowQuery Query;
+		  Query.AddStream( &Depth );
+		  Query.AddStream( &Robot );
+
+		  std::vector<StreamRange> Ranges;
+		  Query.Run( EventTimestamp - 2*HighResTimestamp::NanosecondsPerSecond, EventTimestamp + 2*HighResTimestamp::NanosecondsPerSecond, Ranges );
+
+		  std::vector<FrameView> Frames;
+		  while( Ranges[0].NextFrames( 16, Frames ) )
+		  {
+			  ...
+		  }
+		  while( Ranges[1].Next() )
+		  {
+			  Robot.ProcessCurrent();
+		  }
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class TimeWindowQuery
+{
+public:
+	/** @brief Constructor.
+	 *
+	 * @param eNumberOfThreads [in] Number of threads building the indexes, 0 means number of hardware threads (default=0).
+	 */
+	TimeWindowQuery( unsigned int eNumberOfThreads = 0 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~TimeWindowQuery() {}
+
+	/** @brief Add a stream. The reader is not owned by the query, it must stay alive.
+	 *
+	 * @param Stream [in] Reader of the timestamp file.
+	 * @return Number of the stream.
+	 */
+	size_t AddStream( ReadTimestamp * Stream );
+
+	/** @brief Add a raw stream, its frames can be read from the ranges. The reader is not owned by the query, it must stay alive.
+	 *
+	 * @param Stream [in] Reader of the raw stream.
+	 * @return Number of the stream.
+	 */
+	size_t AddStream( ReadTimestampRawFile * Stream );
+
+	/** @brief Number of streams.
+	 */
+	size_t GetNumberOfStreams() const { return Streams.size(); }
+
+	/** @brief Get the range of each stream in a time window.
+	 *
+	 * @param StartTimestamp [in] First timestamp of the window.
+	 * @param EndTimestamp [in] Last timestamp of the window (included).
+	 * @param Ranges [out] Range of each stream (in the order of AddStream), empty if no line is in the window.
+	 * @return False if an index is not available.
+	 */
+	bool Run( const HighResTimestamp& StartTimestamp, const HighResTimestamp& EndTimestamp, std::vector<StreamRange>& Ranges );
+
+protected:
+	std::vector<ReadTimestamp*> Streams;			/*!< @brief Streams to query. */
+	std::vector<ReadTimestampRawFile*> RawStreams;	/*!< @brief Same readers for raw streams, nullptr otherwise. */
+	bool IndexesReady;								/*!< @brief Indexes of all streams are built. */
+	unsigned int NumberOfThreads;					/*!< @brief Number of threads building the indexes. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __TIME_WINDOW_QUERY_H__
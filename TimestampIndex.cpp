@@ -0,0 +1,714 @@
+/**
+ * @file TimestampIndex.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "TimestampIndex.h"
+#include "ThreadPool.h"
+
+#include <sys/stat.h>
+#include <stdlib.h>
+
+using namespace std;
+using namespace MobileRGBD;
+
+const int64_t TimestampIndex::MinimumChunkSize = 4*1024*1024;		/*!< @brief Minimum size of a chunk when parsing a file in parallel (4 MiB). */
+const char TimestampIndex::Magic[8] = { 'M', 'R', 'G', 'B', 'D', 'I', 'D', 'X' };	/*!< @brief Magic value at the beginning of index files ("MRGBDIDX"). */
+const uint32_t TimestampIndex::CurrentVersion = 2;									/*!< @brief Version of index files written by this code (2). */
+
+/**
+ * @struct TimestampIndexFileHeader TimestampIndex.cpp
+ * @brief Header of an index file, followed by the entries (native byte order).
+ */
+struct TimestampIndexFileHeader
+{
+	char Magic[8];					/*!< @brief Always "MRGBDIDX". */
+	uint32_t Version;				/*!< @brief Version of the format (2, entries with frame fields). */
+	uint32_t EntrySize;				/*!< @brief Size of one entry. */
+	uint64_t NumberOfEntries;		/*!< @brief Number of entries. */
+	int64_t SourceSize;				/*!< @brief Size of the indexed file when the index was saved. */
+	int64_t SourceModificationTime;	/*!< @brief Modification time of the indexed file when the index was saved. */
+};
+
+/** @brief Constructor. Create an empty index.
+ */
+TimestampIndex::TimestampIndex()
+{
+	IndexedSize = 0;
+	SubFrameOffsets.assign( 1, 0 );
+}
+
+/** @brief Build index reading the whole file (usual or compressed). Usual files can be split in
+ *		   chunks parsed in parallel.
+ *
+ * @param FileName [in] Name of the timestamp file.
+ * @param SizeOfLineBuffer [in] Size of buffer to read each line of the file.
+ * @param NumberOfThreads [in] Maximum number of threads to use, 0 for the number of hardware threads (default=1).
+ * @param CompleteLinesOnly [in] Ignore a last line without end of line, i.e. being written (default=false).
+ * @return True if the file was opened and parsed.
+ */
+bool TimestampIndex::Build( const string& FileName, size_t SizeOfLineBuffer, unsigned int NumberOfThreads /* = 1 */, bool CompleteLinesOnly /* = false */ )
+{
+	Clear();
+
+	if ( NumberOfThreads == 0 )
+	{
+		NumberOfThreads = thread::hardware_concurrency();
+	}
+
+	vector<int64_t> Chunks;
+	if ( NumberOfThreads > 1 )
+	{
+		Chunks = SplitInChunks( FileName, NumberOfThreads );
+	}
+
+	if ( Chunks.size() <= 2 )
+	{
+		// Compressed or small file, only one chunk: the whole file
+		vector< vector<TimestampIndexEntry> > ChunksEntries( 1 );
+		int64_t EndOfFile;
+		if ( BuildChunk( FileName, 0, INT64_MAX, SizeOfLineBuffer, ChunksEntries[0], &EndOfFile, CompleteLinesOnly ) == false )
+		{
+			return false;
+		}
+		Stitch( ChunksEntries, EndOfFile );
+		return true;
+	}
+
+	// Parse chunks in parallel
+	size_t NumberOfChunks = Chunks.size()-1;
+	vector< vector<TimestampIndexEntry> > ChunksEntries( NumberOfChunks );
+	vector< future<bool> > Results;
+	int64_t EndOfLastChunk = 0;
+	bool Result = true;
+	{
+		ThreadPool Workers( (unsigned int)NumberOfChunks );
+
+		for( size_t i = 0; i < NumberOfChunks; i++ )
+		{
+			vector<TimestampIndexEntry> * ChunkEntries = &ChunksEntries[i];
+			int64_t ChunkStart = Chunks[i];
+			int64_t ChunkEnd = Chunks[i+1];
+			int64_t * EndOfChunk = (i == NumberOfChunks-1) ? &EndOfLastChunk : nullptr;
+
+			Results.push_back( Workers.Submit( [=]() { return BuildChunk( FileName, ChunkStart, ChunkEnd, SizeOfLineBuffer, *ChunkEntries, EndOfChunk, CompleteLinesOnly ); } ) );
+		}
+
+		for( size_t i = 0; i < NumberOfChunks; i++ )
+		{
+			Result = Results[i].get() && Result;
+		}
+	}
+
+	if ( Result == true )
+	{
+		Stitch( ChunksEntries, EndOfLastChunk );
+	}
+
+	return Result;
+}
+
+/** @brief Add to the index the lines appended to the file after IndexedSize (see Build). Only
+ *		   complete lines are indexed. Used to follow files being recorded.
+ *
+ * @param FileName [in] Name of the timestamp file.
+ * @param SizeOfLineBuffer [in] Size of buffer to read each line of the file.
+ * @return True if new entries were added.
+ */
+bool TimestampIndex::Update( const string& FileName, size_t SizeOfLineBuffer )
+{
+	vector<TimestampIndexEntry> NewEntries;
+	int64_t EndOfFile;
+
+	if ( BuildChunk( FileName, IndexedSize, INT64_MAX, SizeOfLineBuffer, NewEntries, &EndOfFile, true ) == false )
+	{
+		return false;
+	}
+
+	IndexedSize = EndOfFile;
+	for( size_t i = 0; i < NewEntries.size(); i++ )
+	{
+		Append( NewEntries[i] );
+	}
+
+	return (NewEntries.empty() == false);
+}
+
+/** @brief Split a usual file in chunks to parse them in parallel. Chunks are not aligned on lines, BuildChunk
+ *		   takes care of it.
+ *
+ * @param FileName [in] Name of the timestamp file.
+ * @param MaximumNumberOfChunks [in] Maximum number of chunks.
+ * @return Boundaries of the chunks (number of chunks + 1 values), empty if the file is not a usual file.
+ */
+vector<int64_t> TimestampIndex::SplitInChunks( const string& FileName, unsigned int MaximumNumberOfChunks )
+{
+	vector<int64_t> Boundaries;
+	struct stat FileStat;
+
+	// Only usual files can be read from any position
+	if ( DataFile::OpenCompressedVersionFirst == true || stat( FileName.c_str(), &FileStat ) != 0 )
+	{
+		return Boundaries;
+	}
+
+	int64_t FileSize = (int64_t)FileStat.st_size;
+	int64_t NumberOfChunks = FileSize/MinimumChunkSize;
+	if ( NumberOfChunks > (int64_t)MaximumNumberOfChunks )
+	{
+		NumberOfChunks = (int64_t)MaximumNumberOfChunks;
+	}
+	if ( NumberOfChunks < 1 )
+	{
+		NumberOfChunks = 1;
+	}
+
+	for( int64_t i = 0; i < NumberOfChunks; i++ )
+	{
+		Boundaries.push_back( (FileSize*i)/NumberOfChunks );
+	}
+	Boundaries.push_back( FileSize );
+
+	return Boundaries;
+}
+
+/** @brief Parse the lines starting in a chunk of a usual file. The partial line at the beginning of the chunk belongs to the
+ *		   previous chunk, the last line may end after the chunk. Concatenated results of all chunks give the index.
+ *
+ * @param FileName [in] Name of the timestamp file.
+ * @param ChunkStart [in] First position of the chunk.
+ * @param ChunkEnd [in] Position after the last position of the chunk.
+ * @param SizeOfLineBuffer [in] Size of buffer to read each line of the file.
+ * @param ChunkEntries [out] Entries of the chunk.
+ * @param EndOfChunk [out] If not nullptr, position after the last line parsed (default=nullptr).
+ * @param CompleteLinesOnly [in] Ignore a last line without end of line, i.e. being written (default=false).
+ * @return True if the chunk was parsed.
+ */
+bool TimestampIndex::BuildChunk( const string& FileName, int64_t ChunkStart, int64_t ChunkEnd, size_t SizeOfLineBuffer, vector<TimestampIndexEntry> &ChunkEntries,
+	int64_t * EndOfChunk /* = nullptr */, bool CompleteLinesOnly /* = false */ )
+{
+	DataFile fIndex;
+
+	ChunkEntries.clear();
+
+	if ( fIndex.Open( FileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return false;
+	}
+
+	vector<char> LineBuffer( SizeOfLineBuffer );
+	int64_t Position = ChunkStart;
+
+	if ( ChunkStart > 0 )
+	{
+		// Lines starts after a '\n', check previous character
+		char PreviousCharacter;
+		if ( fIndex.Seek( ChunkStart-1, SEEK_SET ) != 0 || fIndex.Read( &PreviousCharacter, 1, 1 ) != 1 )
+		{
+			return false;
+		}
+
+		// Skip end of the line started in the previous chunk
+		while( PreviousCharacter != '\n' && fIndex.ReadLine( &LineBuffer[0], (int)SizeOfLineBuffer-1 ) != nullptr )
+		{
+			size_t Length = strlen( &LineBuffer[0] );
+			Position += (int64_t)Length;
+			PreviousCharacter = Length > 0 ? LineBuffer[Length-1] : '\0';
+		}
+	}
+
+	while( Position < ChunkEnd )
+	{
+		TimestampIndexEntry NewEntry;
+		int EndOfTimestampPosition;
+
+		// Position of the line we will read (fIndex.Tell() is not usable on pipes here)
+		NewEntry.Position = Position;
+
+		if ( fIndex.ReadLine( &LineBuffer[0], (int)SizeOfLineBuffer-1 ) == nullptr )
+		{
+			break;
+		}
+
+		size_t Length = strlen( &LineBuffer[0] );
+		if ( CompleteLinesOnly == true && (Length == 0 || LineBuffer[Length-1] != '\n') && Length < SizeOfLineBuffer-2 )
+		{
+			// Line is being written
+			break;
+		}
+		Position += (int64_t)Length;
+
+		// Lines without timestamp are ignored, as in ReadTimestamp::GetNextTimestamp
+		if ( HighResTimestamp::Parse( &LineBuffer[0], NewEntry.Timestamp, EndOfTimestampPosition ) == false )
+		{
+			continue;
+		}
+		ParseFrameFields( &LineBuffer[EndOfTimestampPosition], NewEntry );
+
+		ChunkEntries.push_back( NewEntry );
+	}
+
+	fIndex.Close();
+
+	if ( EndOfChunk != nullptr )
+	{
+		*EndOfChunk = Position;
+	}
+
+	return true;
+}
+
+/** @brief Set the index from the entries of consecutive chunks (see BuildChunk).
+ *
+ * @param ChunksEntries [in,out] Entries of each chunk, emptied by the call.
+ * @param EndOfLastChunk [in] Position after the last line parsed in the last chunk.
+ */
+void TimestampIndex::Stitch( vector< vector<TimestampIndexEntry> > &ChunksEntries, int64_t EndOfLastChunk )
+{
+	size_t NumberOfEntries = 0;
+
+	IndexedSize = EndOfLastChunk;
+
+	for( size_t i = 0; i < ChunksEntries.size(); i++ )
+	{
+		NumberOfEntries += ChunksEntries[i].size();
+	}
+
+	if ( ChunksEntries.size() == 1 )
+	{
+		// No copy
+		Entries.swap( ChunksEntries[0] );
+	}
+	else
+	{
+		Entries.clear();
+		Entries.reserve( NumberOfEntries );
+		for( size_t i = 0; i < ChunksEntries.size(); i++ )
+		{
+			Entries.insert( Entries.end(), ChunksEntries[i].begin(), ChunksEntries[i].end() );
+			vector<TimestampIndexEntry>().swap( ChunksEntries[i] );
+		}
+	}
+
+	ComputeSubFrameOffsets();
+}
+
+/** @brief Add an entry at the end of the index (the offset table of subframes is updated).
+ *
+ * @param NewEntry [in] Entry of a line after the last indexed one.
+ */
+void TimestampIndex::Append( const TimestampIndexEntry& NewEntry )
+{
+	Entries.push_back( NewEntry );
+	SubFrameOffsets.push_back( SubFrameOffsets.back() + (NewEntry.NumberOfSubFrames > 0 ? NewEntry.NumberOfSubFrames : 0) );
+}
+
+/** @brief Empty the index.
+ */
+void TimestampIndex::Clear()
+{
+	Entries.clear();
+	SubFrameOffsets.assign( 1, 0 );
+	IndexedSize = 0;
+}
+
+/** @brief Compute the offset table of subframes from the entries.
+ */
+void TimestampIndex::ComputeSubFrameOffsets()
+{
+	SubFrameOffsets.resize( Entries.size()+1 );
+	SubFrameOffsets[0] = 0;
+
+	for( size_t i = 0; i < Entries.size(); i++ )
+	{
+		// Lines without number of subframes have no data in the raw file
+		SubFrameOffsets[i+1] = SubFrameOffsets[i] + (Entries[i].NumberOfSubFrames > 0 ? Entries[i].NumberOfSubFrames : 0);
+	}
+}
+
+/** @brief Parse the frame number and the number of subframes at the beginning of the data part of a line,
+ *		   like sscanf with "%d" and "%*d, %d" (but faster). Missing values are set to -1.
+ *
+ * @param Data [in] Data part of the line, i.e. after the timestamp.
+ * @param Entry [in,out] Entry to fill.
+ */
+void TimestampIndex::ParseFrameFields( const char * Data, TimestampIndexEntry &Entry )
+{
+	char * EndOfValue;
+
+	Entry.FrameNumber = -1;
+	Entry.NumberOfSubFrames = -1;
+
+	long int Value = strtol( Data, &EndOfValue, 10 );
+	if ( EndOfValue == Data )
+	{
+		// No frame number
+		return;
+	}
+	if ( Value >= 0 && Value <= INT32_MAX )
+	{
+		Entry.FrameNumber = (int32_t)Value;
+	}
+
+	// Number of subframes follows the frame number and a comma
+	if ( *EndOfValue != ',' )
+	{
+		return;
+	}
+	Data = EndOfValue + 1;
+
+	// Second value of usual frames is not a number of subframes but a large device timestamp
+	Value = strtol( Data, &EndOfValue, 10 );
+	if ( EndOfValue != Data && Value >= 0 && Value <= INT32_MAX )
+	{
+		Entry.NumberOfSubFrames = (int32_t)Value;
+	}
+}
+
+/** @brief Get size and modification time of a timestamp file (or of its 7z version).
+ *
+ * @param SourceFileName [in] Name of the timestamp file.
+ * @param Size [out] Size of the file.
+ * @param ModificationTime [out] Modification time of the file.
+ * @return True if the file exists.
+ */
+bool TimestampIndex::GetSourceSignature( const string& SourceFileName, int64_t &Size, int64_t &ModificationTime )
+{
+	struct stat FileStat;
+
+	if ( stat( SourceFileName.c_str(), &FileStat ) != 0 )
+	{
+		string CompressedFileName = SourceFileName + ".7z";
+		if ( stat( CompressedFileName.c_str(), &FileStat ) != 0 )
+		{
+			return false;
+		}
+	}
+
+	Size = (int64_t)FileStat.st_size;
+	ModificationTime = (int64_t)FileStat.st_mtime;
+	return true;
+}
+
+/** @brief Save the index in a binary file, with the size and modification time of the timestamp file
+ *		   in order to detect stale indexes.
+ *
+ * @param IndexFileName [in] Name of the index file to write.
+ * @param SourceFileName [in] Name of the indexed timestamp file.
+ * @return True if the index has been saved.
+ */
+bool TimestampIndex::Save( const string& IndexFileName, const string& SourceFileName ) const
+{
+	TimestampIndexFileHeader Header;
+
+	memset( &Header, 0, sizeof(Header) );
+	memcpy( Header.Magic, Magic, sizeof(Header.Magic) );
+	Header.Version = CurrentVersion;
+	Header.EntrySize = (uint32_t)sizeof(TimestampIndexEntry);
+	Header.NumberOfEntries = (uint64_t)Entries.size();
+
+	if ( GetSourceSignature( SourceFileName, Header.SourceSize, Header.SourceModificationTime ) == false )
+	{
+		return false;
+	}
+
+	DataFile fOut;
+	if ( fOut.Open( IndexFileName.c_str(), DataFile::WRITE_MODE ) == false )
+	{
+		return false;
+	}
+
+	bool Result = (fOut.Write( &Header, sizeof(Header), 1 ) == 1);
+	if ( Result == true && Entries.empty() == false )
+	{
+		Result = (fOut.Write( &Entries[0], sizeof(TimestampIndexEntry), Entries.size() ) == Entries.size());
+	}
+
+	fOut.Close();
+
+	return Result;
+}
+
+/** @brief Load an index saved with Save. The index is rejected if the timestamp file changed since.
+ *
+ * @param IndexFileName [in] Name of the index file to read.
+ * @param SourceFileName [in] Name of the indexed timestamp file.
+ * @return True if the index has been loaded.
+ */
+bool TimestampIndex::Load( const string& IndexFileName, const string& SourceFileName )
+{
+	TimestampIndexFileHeader Header;
+	int64_t SourceSize, SourceModificationTime;
+
+	Clear();
+
+	// Do not try to open a 7z version of the index
+	if ( DataFile::FileOrFolderExists( IndexFileName.c_str() ) == false ||
+		 GetSourceSignature( SourceFileName, SourceSize, SourceModificationTime ) == false )
+	{
+		return false;
+	}
+
+	DataFile fIn;
+	if ( fIn.Open( IndexFileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return false;
+	}
+
+	if ( fIn.Read( &Header, sizeof(Header), 1 ) != 1 ||
+		 memcmp( Header.Magic, Magic, sizeof(Magic) ) != 0 || Header.Version != CurrentVersion ||
+		 Header.EntrySize != (uint32_t)sizeof(TimestampIndexEntry) )
+	{
+		fprintf( stderr, "'%s' is not a valid index file.\n", IndexFileName.c_str() );
+		return false;
+	}
+
+	if ( Header.SourceSize != SourceSize || Header.SourceModificationTime != SourceModificationTime )
+	{
+		// Stale index, the caller will rebuild it
+		return false;
+	}
+
+	Entries.resize( (size_t)Header.NumberOfEntries );
+	if ( Entries.empty() == false && fIn.Read( &Entries[0], sizeof(TimestampIndexEntry), Entries.size() ) != Entries.size() )
+	{
+		Clear();
+		return false;
+	}
+	IndexedSize = Header.SourceSize;
+	ComputeSubFrameOffsets();
+
+	return true;
+}
+
+/** @brief Read the first and last timestamps of a file without reading the whole file. The end of usual files
+ *		   is read backward. Compressed (7z) files can not be read backward, false is returned in this case.
+ *
+ * @param FileName [in] Name of the timestamp file.
+ * @param FirstTimestamp [out] First timestamp of the file.
+ * @param LastTimestamp [out] Last timestamp of the file.
+ * @return True if both timestamps have been found.
+ */
+bool TimestampIndex::ReadTimeRange( const string& FileName, HighResTimestamp &FirstTimestamp, HighResTimestamp &LastTimestamp )
+{
+	DataFile fRange;
+	vector<char> Buffer( 64*1024 );
+	int EndOfTimestampPosition;
+
+	if ( fRange.Open( FileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return false;
+	}
+
+	// First timestamp
+	bool Found = false;
+	while( Found == false && fRange.ReadLine( &Buffer[0], (int)Buffer.size()-1 ) != nullptr )
+	{
+		Found = HighResTimestamp::Parse( &Buffer[0], FirstTimestamp, EndOfTimestampPosition );
+	}
+
+	// Go to the end, impossible with pipes
+	if ( Found == false || fRange.Seek( 0, SEEK_END ) != 0 )
+	{
+		return false;
+	}
+	int64_t FileSize = fRange.Tell();
+
+	// Read bigger and bigger blocks from the end until a complete line with a timestamp is found
+	for( int64_t BlockSize = 4096; ; BlockSize *= 2 )
+	{
+		int64_t BlockStart = FileSize > BlockSize ? FileSize - BlockSize : 0;
+		size_t Length = (size_t)(FileSize - BlockStart);
+
+		Buffer.resize( Length+1 );
+		if ( fRange.Seek( BlockStart, SEEK_SET ) != 0 || fRange.Read( &Buffer[0], Length, 1 ) != 1 )
+		{
+			return false;
+		}
+		Buffer[Length] = '\0';
+
+		// Check lines from the last one, a line is complete if it starts after a '\n' or at the beginning of the file
+		size_t EndOfLine = Length;
+		while( EndOfLine > 0 )
+		{
+			size_t StartOfLine = EndOfLine - 1;
+			while( StartOfLine > 0 && Buffer[StartOfLine-1] != '\n' )
+			{
+				StartOfLine--;
+			}
+
+			if ( StartOfLine == 0 && BlockStart != 0 )
+			{
+				// Incomplete line, read a bigger block
+				break;
+			}
+
+			Buffer[EndOfLine] = '\0';
+			if ( HighResTimestamp::Parse( &Buffer[StartOfLine], LastTimestamp, EndOfTimestampPosition ) == true )
+			{
+				return true;
+			}
+			EndOfLine = StartOfLine;
+		}
+
+		if ( BlockStart == 0 )
+		{
+			// Whole file has been checked
+			return false;
+		}
+	}
+}
+
+/** @brief Search for the entry matching a timestamp.
+ *
+ * @param RequestedTimestamp [in] Timestamp to search for.
+ * @param Policy [in] How to match the timestamp (see MatchPolicy).
+ * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps.
+ * @return The entry number or -1 if no entry matches.
+ */
+int TimestampIndex::Find( const TimeB &RequestedTimestamp, MatchPolicy Policy, unsigned int ToleranceInMs ) const
+{
+	int64_t ToleranceInNs = -1;
+
+	if ( ToleranceInMs != UnboundedTolerance )
+	{
+		ToleranceInNs = (int64_t)ToleranceInMs*HighResTimestamp::NanosecondsPerMillisecond;
+	}
+
+	return Find( HighResTimestamp(RequestedTimestamp), Policy, ToleranceInNs );
+}
+
+/** @brief Search for the entry matching a high resolution timestamp.
+ *
+ * @param RequestedTimestamp [in] Timestamp to search for.
+ * @param Policy [in] How to match the timestamp (see MatchPolicy).
+ * @param ToleranceInNs [in] Maximum distance between the requested and the found timestamps in nanoseconds (negative for unbounded).
+ * @return The entry number or -1 if no entry matches.
+ */
+int TimestampIndex::Find( const HighResTimestamp &RequestedTimestamp, MatchPolicy Policy, int64_t ToleranceInNs ) const
+{
+	return FindTimestamp( EntryTimestamp(this), Entries.size(), RequestedTimestamp, Policy, ToleranceInNs );
+}
+
+/** @brief Search for the entries in a time window.
+ *
+ * @param StartTimestamp [in] First timestamp of the window.
+ * @param EndTimestamp [in] Last timestamp of the window (included).
+ * @param FirstEntry [out] First entry in the window.
+ * @param EndEntry [out] Entry following the last entry in the window.
+ * @return True if at least one entry is in the window.
+ */
+bool TimestampIndex::FindRange( const HighResTimestamp &StartTimestamp, const HighResTimestamp &EndTimestamp, int &FirstEntry, int &EndEntry ) const
+{
+	FirstEntry = EndEntry = 0;
+
+	if ( EndTimestamp < StartTimestamp )
+	{
+		return false;
+	}
+
+	// Lines with the same timestamp as the bounds are all in the window
+	FirstEntry = (int)LowerBound( EntryTimestamp(this), Entries.size(), StartTimestamp );
+	EndEntry = (int)LowerBound( EntryTimestamp(this), Entries.size(), EndTimestamp + (int64_t)1 );
+
+	return (FirstEntry < EndEntry);
+}
+
+/** @brief Search for the 2 entries surrounding a timestamp in order to interpolate data.
+ *
+ * @param RequestedTimestamp [in] Timestamp to search for.
+ * @param Before [out] Entry at or before RequestedTimestamp.
+ * @param After [out] Entry after RequestedTimestamp (equals to Before if timestamps are identical).
+ * @param Alpha [out] Interpolation weight of the After entry in [0, 1].
+ * @return True if RequestedTimestamp lies between 2 entries of the index.
+ */
+bool TimestampIndex::FindBracket( const HighResTimestamp &RequestedTimestamp, int &Before, int &After, float &Alpha ) const
+{
+	return FindTimestampBracket( EntryTimestamp(this), Entries.size(), RequestedTimestamp, Before, After, Alpha );
+}
+
+/** @brief Search for the entry of a line using its position in the file.
+ *
+ * @param Position [in] Position of the beginning of the line in the file.
+ * @param Hint [in] Probable entry number, checked first (default=-1, no hint).
+ * @return The entry number or -1 if no line starts at this position.
+ */
+int TimestampIndex::FindPosition( int64_t Position, int Hint /* = -1 */ ) const
+{
+	// Usual case, sequential reading
+	if ( Hint >= 0 && Hint < (int)Entries.size() && Entries[Hint].Position == Position )
+	{
+		return Hint;
+	}
+
+	// Positions are ordered, use binary search
+	size_t First = 0;
+	size_t Count = Entries.size();
+
+	while( Count > 0 )
+	{
+		size_t Step = Count/2;
+		size_t Middle = First + Step;
+
+		if ( Entries[Middle].Position < Position )
+		{
+			First = Middle + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+
+	if ( First < Entries.size() && Entries[First].Position == Position )
+	{
+		return (int)First;
+	}
+
+	return -1;
+}
+
+/** @brief Search for the entry of a frame using its frame number. Frame numbers must be ordered in the file.
+ *
+ * @param FrameNumber [in] Frame number in the raw file.
+ * @param Hint [in] Probable entry number, checked first (default=-1, no hint).
+ * @return The entry number or -1 if no line has this frame number.
+ */
+int TimestampIndex::FindFrameNumber( int FrameNumber, int Hint /* = -1 */ ) const
+{
+	// Usual case, sequential reading
+	if ( Hint >= 0 && Hint < (int)Entries.size() && Entries[Hint].FrameNumber == FrameNumber )
+	{
+		return Hint;
+	}
+
+	// Frame numbers are ordered, use binary search
+	size_t First = 0;
+	size_t Count = Entries.size();
+
+	while( Count > 0 )
+	{
+		size_t Step = Count/2;
+		size_t Middle = First + Step;
+
+		if ( Entries[Middle].FrameNumber < FrameNumber )
+		{
+			First = Middle + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+
+	if ( First < Entries.size() && Entries[First].FrameNumber == FrameNumber )
+	{
+		return (int)First;
+	}
+
+	return -1;
+}
@@ -0,0 +1,458 @@
+/**
+ * @file TimestampIndex.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __TIMESTAMP_INDEX_H__
+#define __TIMESTAMP_INDEX_H__
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
+
+#include <string>
+#include <vector>
+
+#include "DataFile.h"
+#include "TimestampTools.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct TimestampIndexEntry TimestampIndex.h
+ * @brief One entry of a TimestampIndex: a timestamp and the position of its line in the file. For
+ *		  timestamp files of raw files, the frame number and the number of subframes are kept
+ *		  too (see ReadTimestampRawFile).
+ */
+struct TimestampIndexEntry
+{
+	HighResTimestamp Timestamp;	/*!< @brief Timestamp of the line (with all digits of the file). */
+	int64_t Position;		/*!< @brief Position of the beginning of the line in the file. */
+	int32_t FrameNumber;		/*!< @brief First integer after the timestamp ("%d"), i.e. frame number, -1 if none. */
+	int32_t NumberOfSubFrames;	/*!< @brief Integer after the frame number ("%*d, %d"), i.e. number of subframes, -1 if none. */
+};
+
+/**
+ * @class TimestampIndex TimestampIndex.cpp TimestampIndex.h
+ * @brief In memory index of a timestamp file. Each valid line of the file (i.e. starting with a timestamp)
+ *		  is stored with its position in the file. Queries are done using binary search and
+ *		  a MatchPolicy, without reading lines from the file.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class TimestampIndex
+{
+public:
+	/** @enum TimestampIndex::MatchPolicy
+	 *  @brief Define how a requested timestamp is matched against timestamps of the index.
+	 */
+	enum MatchPolicy
+	{
+		MatchExact = 0,				/*!< @brief Only a line with exactly the requested timestamp. */
+		MatchFloor = 1,				/*!< @brief Last line at or before the requested timestamp (within tolerance). */
+		MatchCeil = 2,				/*!< @brief First line at or after the requested timestamp (within tolerance). */
+		MatchNearest = 3,			/*!< @brief Nearest line, whatever the distance (tolerance is ignored). */
+		MatchWindow = 4,			/*!< @brief Nearest line in a symmetric window of +/- tolerance around the requested timestamp. */
+		MatchInterpolated = 5		/*!< @brief Last line before the requested timestamp when the next one is after it, i.e. the requested timestamp can be interpolated (gap between lines within tolerance). */
+	};
+
+	static const unsigned int UnboundedTolerance = UINT_MAX;	/*!< @brief Use this tolerance to accept any distance between timestamps. */
+
+	/** @brief Constructor. Create an empty index.
+	 */
+	TimestampIndex();
+
+	/** @brief virtual destructor (always).
+	 */
+	virtual ~TimestampIndex() {}
+
+	static const int64_t MinimumChunkSize;		/*!< @brief Minimum size of a chunk when parsing a file in parallel (4 MiB). */
+
+	/** @brief Build index reading the whole file (usual or compressed). Usual files can be split in
+	 *		   chunks parsed in parallel.
+	 *
+	 * @param FileName [in] Name of the timestamp file.
+	 * @param SizeOfLineBuffer [in] Size of buffer to read each line of the file.
+	 * @param NumberOfThreads [in] Maximum number of threads to use, 0 for the number of hardware threads (default=1).
+	 * @param CompleteLinesOnly [in] Ignore a last line without end of line, i.e. being written (default=false).
+	 * @return True if the file was opened and parsed.
+	 */
+	bool Build( const std::string& FileName, size_t SizeOfLineBuffer, unsigned int NumberOfThreads = 1, bool CompleteLinesOnly = false );
+
+	/** @brief Add to the index the lines appended to the file after IndexedSize (see Build). Only
+	 *		   complete lines are indexed. Used to follow files being recorded.
+	 *
+	 * @param FileName [in] Name of the timestamp file.
+	 * @param SizeOfLineBuffer [in] Size of buffer to read each line of the file.
+	 * @return True if new entries were added.
+	 */
+	bool Update( const std::string& FileName, size_t SizeOfLineBuffer );
+
+	/** @brief Split a usual file in chunks to parse them in parallel. Chunks are not aligned on lines, BuildChunk
+	 *		   takes care of it.
+	 *
+	 * @param FileName [in] Name of the timestamp file.
+	 * @param MaximumNumberOfChunks [in] Maximum number of chunks.
+	 * @return Boundaries of the chunks (number of chunks + 1 values), empty if the file is not a usual file.
+	 */
+	static std::vector<int64_t> SplitInChunks( const std::string& FileName, unsigned int MaximumNumberOfChunks );
+
+	/** @brief Parse the lines starting in a chunk of a usual file. The partial line at the beginning of the chunk belongs to the
+	 *		   previous chunk, the last line may end after the chunk. Concatenated results of all chunks give the index.
+	 *
+	 * @param FileName [in] Name of the timestamp file.
+	 * @param ChunkStart [in] First position of the chunk.
+	 * @param ChunkEnd [in] Position after the last position of the chunk.
+	 * @param SizeOfLineBuffer [in] Size of buffer to read each line of the file.
+	 * @param ChunkEntries [out] Entries of the chunk.
+	 * @param EndOfChunk [out] If not nullptr, position after the last line parsed (default=nullptr).
+	 * @param CompleteLinesOnly [in] Ignore a last line without end of line, i.e. being written (default=false).
+	 * @return True if the chunk was parsed.
+	 */
+	static bool BuildChunk( const std::string& FileName, int64_t ChunkStart, int64_t ChunkEnd, size_t SizeOfLineBuffer, std::vector<TimestampIndexEntry> &ChunkEntries,
+		int64_t * EndOfChunk = nullptr, bool CompleteLinesOnly = false );
+
+	/** @brief Set the index from the entries of consecutive chunks (see BuildChunk).
+	 *
+	 * @param ChunksEntries [in,out] Entries of each chunk, emptied by the call.
+	 * @param EndOfLastChunk [in] Position after the last line parsed in the last chunk.
+	 */
+	void Stitch( std::vector< std::vector<TimestampIndexEntry> > &ChunksEntries, int64_t EndOfLastChunk );
+
+	/** @brief Add an entry at the end of the index (the offset table of subframes is updated).
+	 *
+	 * @param NewEntry [in] Entry of a line after the last indexed one.
+	 */
+	void Append( const TimestampIndexEntry& NewEntry );
+
+	/** @brief Empty the index.
+	 */
+	void Clear();
+
+	/** @brief Parse the frame number and the number of subframes at the beginning of the data part of a line,
+	 *		   like sscanf with "%d" and "%*d, %d" (but faster). Missing values are set to -1.
+	 *
+	 * @param Data [in] Data part of the line, i.e. after the timestamp.
+	 * @param Entry [in,out] Entry to fill.
+	 */
+	static void ParseFrameFields( const char * Data, TimestampIndexEntry &Entry );
+
+	/** @brief Save the index in a binary file, with the size and modification time of the timestamp file
+	 *		   in order to detect stale indexes.
+	 *
+	 * @param IndexFileName [in] Name of the index file to write.
+	 * @param SourceFileName [in] Name of the indexed timestamp file.
+	 * @return True if the index has been saved.
+	 */
+	bool Save( const std::string& IndexFileName, const std::string& SourceFileName ) const;
+
+	/** @brief Load an index saved with Save. The index is rejected if the timestamp file changed since.
+	 *
+	 * @param IndexFileName [in] Name of the index file to read.
+	 * @param SourceFileName [in] Name of the indexed timestamp file.
+	 * @return True if the index has been loaded.
+	 */
+	bool Load( const std::string& IndexFileName, const std::string& SourceFileName );
+
+	/** @brief Default name of the index file of a timestamp file, i.e. FileName followed by ".idx".
+	 *
+	 * @param FileName [in] Name of the timestamp file.
+	 */
+	static std::string DefaultIndexFileName( const std::string& FileName ) { return FileName + ".idx"; }
+
+	/** @brief Read the first and last timestamps of a file without reading the whole file. The end of usual files
+	 *		   is read backward. Compressed (7z) files can not be read backward, false is returned in this case.
+	 *
+	 * @param FileName [in] Name of the timestamp file.
+	 * @param FirstTimestamp [out] First timestamp of the file.
+	 * @param LastTimestamp [out] Last timestamp of the file.
+	 * @return True if both timestamps have been found.
+	 */
+	static bool ReadTimeRange( const std::string& FileName, HighResTimestamp &FirstTimestamp, HighResTimestamp &LastTimestamp );
+
+	/** @brief Number of entries in the index.
+	 */
+	size_t Size() const { return Entries.size(); }
+
+	/** @brief Return true if the index contains no entry.
+	 */
+	bool IsEmpty() const { return Entries.empty(); }
+
+	/** @brief Access to a specific entry.
+	 *
+	 * @param Entry [in] Entry number (zero based).
+	 */
+	const TimestampIndexEntry& operator[]( size_t Entry ) const { return Entries[Entry]; }
+
+	/** @brief Search for the entry matching a timestamp.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Policy [in] How to match the timestamp (see MatchPolicy).
+	 * @param ToleranceInMs [in] Maximum distance between the requested and the found timestamps.
+	 * @return The entry number or -1 if no entry matches.
+	 */
+	int Find( const TimeB &RequestedTimestamp, MatchPolicy Policy, unsigned int ToleranceInMs ) const;
+
+	/** @brief Search for the entry matching a high resolution timestamp.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Policy [in] How to match the timestamp (see MatchPolicy).
+	 * @param ToleranceInNs [in] Maximum distance between the requested and the found timestamps in nanoseconds (negative for unbounded).
+	 * @return The entry number or -1 if no entry matches.
+	 */
+	int Find( const HighResTimestamp &RequestedTimestamp, MatchPolicy Policy, int64_t ToleranceInNs ) const;
+
+	/** @brief Search for the entries in a time window.
+	 *
+	 * @param StartTimestamp [in] First timestamp of the window.
+	 * @param EndTimestamp [in] Last timestamp of the window (included).
+	 * @param FirstEntry [out] First entry in the window.
+	 * @param EndEntry [out] Entry following the last entry in the window.
+	 * @return True if at least one entry is in the window.
+	 */
+	bool FindRange( const HighResTimestamp &StartTimestamp, const HighResTimestamp &EndTimestamp, int &FirstEntry, int &EndEntry ) const;
+
+	/** @brief Search for the 2 entries surrounding a timestamp in order to interpolate data.
+	 *
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Before [out] Entry at or before RequestedTimestamp.
+	 * @param After [out] Entry after RequestedTimestamp (equals to Before if timestamps are identical).
+	 * @param Alpha [out] Interpolation weight of the After entry in [0, 1].
+	 * @return True if RequestedTimestamp lies between 2 entries of the index.
+	 */
+	bool FindBracket( const HighResTimestamp &RequestedTimestamp, int &Before, int &After, float &Alpha ) const;
+
+	/** @brief Search for the entry of a line using its position in the file.
+	 *
+	 * @param Position [in] Position of the beginning of the line in the file.
+	 * @param Hint [in] Probable entry number, checked first (default=-1, no hint).
+	 * @return The entry number or -1 if no line starts at this position.
+	 */
+	int FindPosition( int64_t Position, int Hint = -1 ) const;
+
+	/** @brief Search for the entry of a frame using its frame number. Frame numbers must be ordered in the file.
+	 *
+	 * @param FrameNumber [in] Frame number in the raw file.
+	 * @param Hint [in] Probable entry number, checked first (default=-1, no hint).
+	 * @return The entry number or -1 if no line has this frame number.
+	 */
+	int FindFrameNumber( int FrameNumber, int Hint = -1 ) const;
+
+	/** @brief Number of subframes stored in the raw file before the ones of an entry, i.e. sum of
+	 *		   NumberOfSubFrames of all previous entries.
+	 *
+	 * @param Entry [in] Entry number (zero based, Size() gives the total number of subframes).
+	 */
+	int64_t GetSubFrameOffset( size_t Entry ) const { return SubFrameOffsets[Entry]; }
+
+	int64_t IndexedSize;						/*!< @brief Size of the beginning of the file covered by the index. */
+
+	/** @brief Compute position of the first timestamp not before the requested one (like std::lower_bound)
+	 *		   in any ordered list of timestamps.
+	 *
+	 * @param GetTimestamp [in] Functor returning the HighResTimestamp of an element from its number.
+	 * @param NumberOfElements [in] Number of elements in the list.
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @return First element not before RequestedTimestamp, NumberOfElements if none.
+	 */
+	template<typename TimestampAccessor>
+	static size_t LowerBound( const TimestampAccessor &GetTimestamp, size_t NumberOfElements, const HighResTimestamp &RequestedTimestamp )
+	{
+		size_t First = 0;
+		size_t Count = NumberOfElements;
+
+		while( Count > 0 )
+		{
+			size_t Step = Count/2;
+			size_t Middle = First + Step;
+
+			if ( GetTimestamp( Middle ) < RequestedTimestamp )
+			{
+				First = Middle + 1;
+				Count -= Step + 1;
+			}
+			else
+			{
+				Count = Step;
+			}
+		}
+
+		return First;
+	}
+
+	/** @brief Search for the element matching a timestamp in any ordered list of timestamps.
+	 *
+	 * @param GetTimestamp [in] Functor returning the HighResTimestamp of an element from its number.
+	 * @param NumberOfElements [in] Number of elements in the list.
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Policy [in] How to match the timestamp (see MatchPolicy).
+	 * @param ToleranceInNs [in] Maximum distance between the requested and the found timestamps in nanoseconds (negative for unbounded).
+	 * @return The element number or -1 if no element matches.
+	 */
+	template<typename TimestampAccessor>
+	static int FindTimestamp( const TimestampAccessor &GetTimestamp, size_t NumberOfElements, const HighResTimestamp &RequestedTimestamp, MatchPolicy Policy, int64_t ToleranceInNs )
+	{
+		if ( NumberOfElements == 0 )
+		{
+			return -1;
+		}
+
+		size_t Ceil = LowerBound( GetTimestamp, NumberOfElements, RequestedTimestamp );
+
+		// Distance to the elements around the requested timestamp, -1 if there is no such element
+		int64_t DistanceToCeil = -1;
+		int64_t DistanceToFloor = -1;
+		size_t Floor = Ceil;
+
+		if ( Ceil < NumberOfElements )
+		{
+			DistanceToCeil = GetTimestamp( Ceil ) - RequestedTimestamp;
+		}
+
+		if ( DistanceToCeil == 0 )
+		{
+			// Exact match is the answer for all policies
+			return (int)Ceil;
+		}
+
+		if ( Ceil > 0 )
+		{
+			Floor = Ceil - 1;
+			DistanceToFloor = RequestedTimestamp - GetTimestamp( Floor );
+		}
+
+		if ( ToleranceInNs < 0 || Policy == MatchNearest )
+		{
+			ToleranceInNs = INT64_MAX;
+		}
+
+		switch( Policy )
+		{
+			case MatchFloor:
+				if ( DistanceToFloor >= 0 && DistanceToFloor <= ToleranceInNs )
+				{
+					return (int)Floor;
+				}
+				return -1;
+
+			case MatchCeil:
+				if ( DistanceToCeil >= 0 && DistanceToCeil <= ToleranceInNs )
+				{
+					return (int)Ceil;
+				}
+				return -1;
+
+			case MatchNearest:
+			case MatchWindow:
+				// In case of equality, prefer the previous data
+				if ( DistanceToFloor >= 0 && (DistanceToCeil < 0 || DistanceToFloor <= DistanceToCeil) )
+				{
+					if ( DistanceToFloor <= ToleranceInNs )
+					{
+						return (int)Floor;
+					}
+					return -1;
+				}
+				if ( DistanceToCeil >= 0 && DistanceToCeil <= ToleranceInNs )
+				{
+					return (int)Ceil;
+				}
+				return -1;
+
+			case MatchInterpolated:
+				if ( DistanceToFloor >= 0 && DistanceToCeil >= 0 && (DistanceToFloor + DistanceToCeil) <= ToleranceInNs )
+				{
+					return (int)Floor;
+				}
+				return -1;
+
+			case MatchExact:
+			default:
+				return -1;
+		}
+	}
+
+	/** @brief Search for the 2 elements surrounding a timestamp in any ordered list of timestamps.
+	 *
+	 * @param GetTimestamp [in] Functor returning the HighResTimestamp of an element from its number.
+	 * @param NumberOfElements [in] Number of elements in the list.
+	 * @param RequestedTimestamp [in] Timestamp to search for.
+	 * @param Before [out] Element at or before RequestedTimestamp.
+	 * @param After [out] Element after RequestedTimestamp (equals to Before if timestamps are identical).
+	 * @param Alpha [out] Interpolation weight of the After element in [0, 1].
+	 * @return True if RequestedTimestamp lies between 2 elements.
+	 */
+	template<typename TimestampAccessor>
+	static bool FindTimestampBracket( const TimestampAccessor &GetTimestamp, size_t NumberOfElements, const HighResTimestamp &RequestedTimestamp, int &Before, int &After, float &Alpha )
+	{
+		Before = After = -1;
+		Alpha = 0.0f;
+
+		size_t Ceil = LowerBound( GetTimestamp, NumberOfElements, RequestedTimestamp );
+		if ( Ceil >= NumberOfElements )
+		{
+			// After the last element
+			return false;
+		}
+
+		if ( GetTimestamp( Ceil ) == RequestedTimestamp )
+		{
+			Before = After = (int)Ceil;
+			return true;
+		}
+
+		if ( Ceil == 0 )
+		{
+			// Before the first element
+			return false;
+		}
+
+		Before = (int)Ceil - 1;
+		After = (int)Ceil;
+
+		int64_t Gap = GetTimestamp( After ) - GetTimestamp( Before );
+		if ( Gap > 0 )
+		{
+			Alpha = (float)((double)(RequestedTimestamp - GetTimestamp( Before ))/(double)Gap);
+		}
+
+		return true;
+	}
+
+protected:
+	static const char Magic[8];		/*!< @brief Magic value at the beginning of index files ("MRGBDIDX"). */
+	static const uint32_t CurrentVersion;	/*!< @brief Version of index files written by this code (2). */
+
+	/** @brief Compute the offset table of subframes from the entries.
+	 */
+	void ComputeSubFrameOffsets();
+
+	std::vector<TimestampIndexEntry> Entries;	/*!< @brief Ordered list of entries, read with operator[]. Only changed by Append, Build, Update and Load (SubFrameOffsets follows). */
+	std::vector<int64_t> SubFrameOffsets;	/*!< @brief Prefix sums of NumberOfSubFrames (Size()+1 values, the first one is 0). */
+
+	/** @brief Get size and modification time of a timestamp file (or of its 7z version).
+	 *
+	 * @param SourceFileName [in] Name of the timestamp file.
+	 * @param Size [out] Size of the file.
+	 * @param ModificationTime [out] Modification time of the file.
+	 * @return True if the file exists.
+	 */
+	static bool GetSourceSignature( const std::string& SourceFileName, int64_t &Size, int64_t &ModificationTime );
+
+	/**
+	 * @struct TimestampIndex::EntryTimestamp TimestampIndex.h
+	 * @brief Functor to access timestamps of the entries in the search functions.
+	 */
+	struct EntryTimestamp
+	{
+		EntryTimestamp( const TimestampIndex * eIndex ) : Index(eIndex) {}
+		const HighResTimestamp& operator()( size_t Entry ) const { return Index->Entries[Entry].Timestamp; }
+		const TimestampIndex * Index;
+	};
+};
+
+} // namespace MobileRGBD
+
+#endif // __TIMESTAMP_INDEX_H__
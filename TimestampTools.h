@@ -12,6 +12,8 @@
 #include <sys/timeb.h>
 
 #include <stdio.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <string>
 
 #if defined WIN32 || defined WIN64
@@ -27,75 +29,253 @@
 	#endif
 #endif
 
-inline void operator-=(TimeB &TimeToModify, int Milliseconds );
+/** @brief Floor division of 2 integers without branching (usual '/' rounds toward zero).
+ *
+ * @param Value [in] Value to divide.
+ * @param Divisor [in] Strictly positive divisor.
+ * @return floor(Value/Divisor).
+ */
+inline int64_t FloorDivide( int64_t Value, int64_t Divisor )
+{
+	// Remove 1 from the quotient if the remainder is negative (the arithmetic shift gives 0 or -1)
+	return Value/Divisor + ((Value%Divisor) >> 63);
+}
 
-/** @brief Add Milliseconds to a specified TimeB. This is a non cascadable += operator.
+/**
+ * @class HighResTimestamp TimestampTools.h
+ * @brief Timestamp stored as a 64 bits integer number of nanoseconds since origin (usually epoch time),
+ *		  i.e. more than 292 years around origin. All arithmetic and comparisons are done on a single
+ *		  integer, without branches. Durations are expressed as int64_t nanoseconds.
  *
- * @param TimeToModify [in, out] The time to change.
- * @param Milliseconds [in] the time in ms to add.
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
  */
-inline void operator+=(TimeB &TimeToModify, int Milliseconds )
+class HighResTimestamp
 {
-	if ( Milliseconds < 0 )
+public:
+	static constexpr int64_t NanosecondsPerMicrosecond = 1000LL;				/*!< @brief Number of nanoseconds in one microsecond. */
+	static constexpr int64_t NanosecondsPerMillisecond = 1000LL*1000LL;			/*!< @brief Number of nanoseconds in one millisecond. */
+	static constexpr int64_t NanosecondsPerSecond = 1000LL*1000LL*1000LL;		/*!< @brief Number of nanoseconds in one second. */
+
+	/** @brief Constructor, timestamp at origin.
+	 */
+	constexpr HighResTimestamp() : Nanoseconds(0) {}
+
+	/** @brief Constructor from a number of nanoseconds since origin.
+	 *
+	 * @param NanosecondsSinceOrigin [in] Number of nanoseconds.
+	 */
+	explicit constexpr HighResTimestamp( int64_t NanosecondsSinceOrigin ) : Nanoseconds(NanosecondsSinceOrigin) {}
+
+	/** @brief Conversion constructor from a TimeB (millisecond precision).
+	 *
+	 * @param Timestamp [in] The TimeB to convert.
+	 */
+	constexpr HighResTimestamp( const TimeB &Timestamp ) : Nanoseconds( (int64_t)Timestamp.time*NanosecondsPerSecond + (int64_t)Timestamp.millitm*NanosecondsPerMillisecond ) {}
+
+	/** @brief Create a timestamp from a number of microseconds since origin.
+	 */
+	static constexpr HighResTimestamp FromMicroseconds( int64_t Microseconds ) { return HighResTimestamp( Microseconds*NanosecondsPerMicrosecond ); }
+
+	/** @brief Create a timestamp from a number of milliseconds since origin.
+	 */
+	static constexpr HighResTimestamp FromMilliseconds( int64_t Milliseconds ) { return HighResTimestamp( Milliseconds*NanosecondsPerMillisecond ); }
+
+	/** @brief Create a timestamp from a number of seconds since origin.
+	 */
+	static constexpr HighResTimestamp FromSeconds( int64_t Seconds ) { return HighResTimestamp( Seconds*NanosecondsPerSecond ); }
+
+	/** @brief Number of nanoseconds since origin.
+	 */
+	constexpr int64_t ToNanoseconds() const { return Nanoseconds; }
+
+	/** @brief Number of microseconds since origin (rounded toward zero).
+	 */
+	constexpr int64_t ToMicroseconds() const { return Nanoseconds/NanosecondsPerMicrosecond; }
+
+	/** @brief Number of milliseconds since origin (rounded toward zero).
+	 */
+	constexpr int64_t ToMilliseconds() const { return Nanoseconds/NanosecondsPerMillisecond; }
+
+	/** @brief Number of seconds since origin as a double.
+	 */
+	constexpr double ToSeconds() const { return (double)Nanoseconds/(double)NanosecondsPerSecond; }
+
+	/** @brief Convert to a TimeB. Sub-millisecond digits are truncated.
+	 */
+	TimeB ToTimeB() const
 	{
-		TimeToModify -= -Milliseconds ;
-		return;
-	}
+		TimeB Result;
+		int64_t Milliseconds = FloorDivide( Nanoseconds, NanosecondsPerMillisecond );
+		int64_t Seconds = FloorDivide( Milliseconds, 1000 );
 
-	int SecondsToAdd = Milliseconds/1000;
-	int MillisecondsToAdd = Milliseconds%1000;
+		Result.time = (time_t)Seconds;
+		Result.millitm = (unsigned short)(Milliseconds - Seconds*1000);
+		Result.timezone = 0;
+		Result.dstflag = 0;
+		return Result;
+	}
 
-	TimeToModify.millitm += MillisecondsToAdd;
-	if ( TimeToModify.millitm >= 1000 )
+	/** @brief Parse a timestamp at the beginning of a line, i.e. seconds dot fraction of seconds. All digits
+	 *         of the fraction are kept up to the nanosecond ("1433341728.727" or "1433341728.727312").
+	 *		   Following spaces or tabs are skipped.
+	 *
+	 * @param Line [in] The line to parse.
+	 * @param Timestamp [out] The parsed timestamp.
+	 * @param EndOfTimestampPosition [out] Position of the first character after the timestamp and the following spaces.
+	 * @return True if a timestamp was found at the beginning of the line.
+	 */
+	static bool Parse( const char * Line, HighResTimestamp &Timestamp, int &EndOfTimestampPosition )
 	{
-		SecondsToAdd += TimeToModify.millitm/1000;
-		TimeToModify.millitm = TimeToModify.millitm%1000;
+		const char * Current = Line;
+		int64_t Sign = 1;
+		int64_t Seconds = 0;
+		int64_t Fraction = 0;
+		int64_t FractionScale = NanosecondsPerSecond;
+
+		while( *Current == ' ' || *Current == '\t' )
+		{
+			Current++;
+		}
+
+		if ( *Current == '-' )
+		{
+			Sign = -1;
+			Current++;
+		}
+
+		if ( *Current < '0' || *Current > '9' )
+		{
+			return false;
+		}
+
+		while( *Current >= '0' && *Current <= '9' )
+		{
+			Seconds = Seconds*10 + (*Current - '0');
+			Current++;
+		}
+
+		// Timestamp must have a fraction part
+		if ( *Current != '.' || Current[1] < '0' || Current[1] > '9' )
+		{
+			return false;
+		}
+		Current++;
+
+		while( *Current >= '0' && *Current <= '9' )
+		{
+			// Digits after the nanosecond are ignored
+			if ( FractionScale > 1 )
+			{
+				FractionScale /= 10;
+				Fraction += (*Current - '0')*FractionScale;
+			}
+			Current++;
+		}
+
+		while( *Current == ' ' || *Current == '\t' )
+		{
+			Current++;
+		}
+
+		Timestamp.Nanoseconds = Sign*(Seconds*NanosecondsPerSecond + Fraction);
+		EndOfTimestampPosition = (int)(Current - Line);
+
+		return true;
 	}
-	
-	TimeToModify.time += SecondsToAdd;
+
+	// Branch free arithmetic, durations are in nanoseconds
+	HighResTimestamp& operator+=( int64_t DurationInNs ) { Nanoseconds += DurationInNs; return *this; }		/*!< @brief Add a duration in nanoseconds. */
+	HighResTimestamp& operator-=( int64_t DurationInNs ) { Nanoseconds -= DurationInNs; return *this; }		/*!< @brief Remove a duration in nanoseconds. */
+	constexpr HighResTimestamp operator+( int64_t DurationInNs ) const { return HighResTimestamp( Nanoseconds + DurationInNs ); }	/*!< @brief Timestamp plus a duration in nanoseconds. */
+	constexpr HighResTimestamp operator-( int64_t DurationInNs ) const { return HighResTimestamp( Nanoseconds - DurationInNs ); }	/*!< @brief Timestamp minus a duration in nanoseconds. */
+	constexpr int64_t operator-( const HighResTimestamp &Other ) const { return Nanoseconds - Other.Nanoseconds; }					/*!< @brief Duration in nanoseconds between 2 timestamps. */
+
+	// Comparisons are done on one integer
+	constexpr bool operator==( const HighResTimestamp &Other ) const { return Nanoseconds == Other.Nanoseconds; }
+	constexpr bool operator!=( const HighResTimestamp &Other ) const { return Nanoseconds != Other.Nanoseconds; }
+	constexpr bool operator<( const HighResTimestamp &Other ) const { return Nanoseconds < Other.Nanoseconds; }
+	constexpr bool operator<=( const HighResTimestamp &Other ) const { return Nanoseconds <= Other.Nanoseconds; }
+	constexpr bool operator>( const HighResTimestamp &Other ) const { return Nanoseconds > Other.Nanoseconds; }
+	constexpr bool operator>=( const HighResTimestamp &Other ) const { return Nanoseconds >= Other.Nanoseconds; }
+
+	int64_t Nanoseconds;		/*!< @brief Number of nanoseconds since origin. */
+};
+
+/** @brief Add Milliseconds to a specified TimeB. This is a non cascadable += operator.
+ *
+ * @param TimeToModify [in, out] The time to change.
+ * @param Milliseconds [in] the time in ms to add (can be negative).
+ */
+inline void operator+=(TimeB &TimeToModify, int Milliseconds )
+{
+	// Compute on a single integer, no branch
+	int64_t TotalMilliseconds = (int64_t)TimeToModify.time*1000 + (int64_t)TimeToModify.millitm + (int64_t)Milliseconds;
+	int64_t Seconds = FloorDivide( TotalMilliseconds, 1000 );
+
+	TimeToModify.time = (time_t)Seconds;
+	TimeToModify.millitm = (unsigned short)(TotalMilliseconds - Seconds*1000);
 }
 
 /** @brief Remove Milliseconds to a specified TimeB. This is a non cascadable -= operator.
  *
  * @param TimeToModify [in, out] The time to change.
- * @param Milliseconds [in] the time in ms to remove.
+ * @param Milliseconds [in] the time in ms to remove (can be negative).
  */
 inline void operator-=( TimeB &TimeToModify, int Milliseconds )
 {
-	if ( Milliseconds < 0 )
-	{
-		TimeToModify += -Milliseconds;
-		return;
-	}
-
-	int SecondsToMin = Milliseconds/1000;
-	int MillisecondsToMin = Milliseconds%1000;
+	TimeToModify += -Milliseconds;
+}
 
-	if ( MillisecondsToMin > TimeToModify.millitm )
-	{
-		int tmp = (int)TimeToModify.millitm - MillisecondsToMin;
-		SecondsToMin += 1;
-		TimeToModify.millitm = 1000+tmp%1000;
-	}
-	else
-	{
-		TimeToModify.millitm -= MillisecondsToMin;
-	}
-	
-	TimeToModify.time -= SecondsToMin;
+/** @brief Difference in milliseconds between 2 TimeB, without overflow.
+ *
+ * @param t1 [in] First time.
+ * @param t2 [in] Second time.
+ * @return t1 - t2 in milliseconds.
+ */
+inline int64_t DiffTime( const TimeB &t1, const TimeB &t2 )
+{
+	return ((int64_t)t1.time - (int64_t)t2.time)*1000 + ((int64_t)t1.millitm - (int64_t)t2.millitm);
 }
 
 /** @brief Compare 2 TimeB. Return values are :
  *         - <0 if t1 is less than t2
  *         - >0 if t1 is greater than t2
  *         - 0 if t1 equals t2
+ *		   The absolute value is the difference in ms, saturated to INT_MAX (use DiffTime for large gaps).
  *
- * @param TimeToModify [in] The time to change.
- * @param Milliseconds [in] the time in ms to remove.
+ * @param t1 [in] First time.
+ * @param t2 [in] Second time.
  */
 inline int CompareTime( const TimeB &t1, const TimeB &t2 )
 {
-	return (int)((t1.time - t2.time)*1000 + (t1.millitm-t2.millitm));
+	int64_t Difference = DiffTime( t1, t2 );
+
+	// Saturate instead of overflowing for gaps over ~24 days
+	Difference = Difference > (int64_t)INT_MAX ? (int64_t)INT_MAX : Difference;
+	Difference = Difference < -(int64_t)INT_MAX ? -(int64_t)INT_MAX : Difference;
+
+	return (int)Difference;
+}
+
+/** @brief Parse a timestamp at the beginning of a line, i.e. seconds dot milliseconds followed
+ *         by spaces or tabs. Sub-millisecond digits are truncated (see HighResTimestamp::Parse).
+ *
+ * @param Line [in] The line to parse.
+ * @param Timestamp [out] The parsed timestamp.
+ * @param EndOfTimestampPosition [out] Position of the first character after the timestamp and the following spaces.
+ * @return True if a timestamp was found at the beginning of the line.
+ */
+inline bool ParseTimestamp( const char * Line, TimeB &Timestamp, int &EndOfTimestampPosition )
+{
+	HighResTimestamp lTimestamp;
+
+	if ( HighResTimestamp::Parse( Line, lTimestamp, EndOfTimestampPosition ) == false )
+	{
+		return false;
+	}
+
+	Timestamp = lTimestamp.ToTimeB();
+	return true;
 }
 
 #endif // __TIMESTAMP_TOOLS_H__
\ No newline at end of file
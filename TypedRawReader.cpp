@@ -0,0 +1,9 @@
+/**
+ * @file TypedRawReader.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+// Only for Makefile
+#include "TypedRawReader.h"
@@ -0,0 +1,103 @@
+/**
+ * @file TypedRawReader.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __TYPED_RAW_READER_H__
+#define __TYPED_RAW_READER_H__
+
+#include "ReadTimestampRawFile.h"
+#include "RawFrameFormat.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class TypedRawReader TypedRawReader.h
+ * @brief ReadTimestampRawFile with a compile time frame format (see RawFrameFormat). Frame size and
+ *		  reading mode come from the format, frame data are accessed with their actual type. Example:
+ *		  @code
+		  TypedRawReader<Kinect2DepthFormat> Depth( "depth.timestamp", "depth.raw" );
+		  std::vector<float> Meters( Kinect2DepthFormat::NumberOfValues );
+
+		  if ( Depth.LoadFrame( Timestamp ) )
+		  {
+			  uint16_t Center = Depth.GetValue( 256, 212 );
+			  ConvertDepthToMeters<Kinect2DepthFormat>( Depth.GetData(), &Meters[0] );
+		  }
+		  @endcode
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<typename Format>
+class TypedRawReader : public ReadTimestampRawFile
+{
+public:
+	typedef typename Format::ElementType ElementType;		/*!< @brief Type of the values of the frames. */
+
+	/** @brief Constructor. Create a reader using specific files (timestamp + raw).
+	 *
+	 * @param WorkingFile [in] Name of the timestamp file to open.
+	 * @param RawFile [in] Name of the associated raw file.
+	 */
+	TypedRawReader( const std::string &WorkingFile, const std::string& RawFile )
+		: ReadTimestampRawFile( WorkingFile, RawFile, Format::FrameSize )
+	{
+		Mode = Format::IsSubFrames ? SubFramesMode : SimpleFrameMode;
+	}
+
+	/** @brief virtual destructor (always).
+	 */
+	virtual ~TypedRawReader() {}
+
+	/** @brief Data of the current frame (valid until the next loading).
+	 */
+	const ElementType * GetData() const { return (const ElementType*)FrameData; }
+
+	/** @brief A value of the current frame (not checked).
+	 *
+	 * @param x [in] Column.
+	 * @param y [in] Row.
+	 * @param Channel [in] Channel (default=0).
+	 */
+	const ElementType& GetValue( int x, int y, int Channel = 0 ) const { return GetData()[Format::Offset( x, y, Channel )]; }
+
+	/** @brief A subframe of the current timestamp in SubFramesMode (not checked).
+	 *
+	 * @param SubFrame [in] Subframe number, lower than NumberOfSubFrames.
+	 */
+	const ElementType * GetSubFrame( int SubFrame ) const { return GetData() + (size_t)SubFrame*(size_t)Format::NumberOfValues; }
+
+	using ReadTimestampRawFile::GetFrameROI;
+
+	/** @brief Get a region of a frame, reading only its rows (see ReadTimestampRawFile::GetFrameROI).
+	 *
+	 * @param WantedIndex [in] Frame number in the raw file.
+	 * @param ROI [in] Region in pixels, inside the frame.
+	 * @param Output [out] ROI.Width*ROI.Height*Format::Channels values, rows of the region one after the other.
+	 * @return True if the full region was read.
+	 */
+	bool GetFrameROI( int WantedIndex, const FrameROI& ROI, ElementType * Output )
+	{
+		return GetFrameROI( WantedIndex, ROI, Format::Width, Format::Channels*(int)sizeof(ElementType), (void*)Output );
+	}
+
+	/** @brief Data of a frame view with the type of the format.
+	 *
+	 * @param View [in] A view of a frame of this format.
+	 * @return Pointer on the values or nullptr if the view is too small.
+	 */
+	static const ElementType * GetData( const FrameView& View )
+	{
+		if ( View.IsValid() == false || View.Size < (size_t)Format::FrameSize )
+		{
+			return nullptr;
+		}
+		return (const ElementType*)View.Data;
+	}
+};
+
+} // namespace MobileRGBD
+
+#endif // __TYPED_RAW_READER_H__
@@ -0,0 +1,354 @@
+/**
+ * @file VariableSizeRawFile.cpp
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "VariableSizeRawFile.h"
+#include "CompressedRawFile.h"
+
+#include <string.h>
+
+using namespace std;
+using namespace MobileRGBD;
+
+const char VariableSizeRawFile::Magic[8] = { 'M', 'R', 'G', 'B', 'D', 'F', 'O', 'T' };	/*!< @brief Magic value at the beginning of the offset table ("MRGBDFOT"). */
+const uint32_t VariableSizeRawFile::CurrentVersion = 1;									/*!< @brief Version of the format written by this code (1). */
+
+/** @brief Decoder of payloads stored as is (the default one).
+ */
+bool MobileRGBD::DecodeStoredFrame( const unsigned char * Payload, size_t PayloadSize, unsigned char * Frame, size_t FrameSize )
+{
+	if ( PayloadSize != FrameSize )
+	{
+		return false;
+	}
+
+	memcpy( Frame, Payload, FrameSize );
+	return true;
+}
+
+/** @brief Decoder of payloads compressed with CompressedRawFile::EncodeFrame (lossless depth, infrared).
+ *
+ * @param Width [in] Width used to encode the frames (0 if unknown).
+ */
+FrameDecoder MobileRGBD::MakeCompressedFrameDecoder( unsigned int Width )
+{
+	return [Width]( const unsigned char * Payload, size_t PayloadSize, unsigned char * Frame, size_t FrameSize )
+	{
+		return CompressedRawFile::DecodeFrame( Payload, PayloadSize, FrameSize, Width, Frame );
+	};
+}
+
+/** @brief Constructor. No file is opened.
+ */
+VariableSizeRawFile::VariableSizeRawFile()
+{
+	FrameSize = 0;
+	Decoder = DecodeStoredFrame;
+	NumberOfThreads = 0;
+}
+
+/** @brief Check if a raw file has an offset table, i.e. contains variable size frames.
+ *
+ * @param RawFileName [in] Name of the raw file.
+ */
+bool VariableSizeRawFile::IsVariableSizeRawFile( const string& RawFileName )
+{
+	string TableFileName = GetOffsetTableFileName( RawFileName );
+
+	// The table may be compressed with 7z, like the raw file
+	return DataFile::FileOrFolderExists( TableFileName.c_str() ) || DataFile::FileOrFolderExists( (TableFileName + ".7z").c_str() );
+}
+
+/** @brief Open a raw file and load its offset table.
+ *
+ * @param RawFileName [in] Name of the raw file (usual or compressed with 7z).
+ * @param eFrameSize [in] Size of decoded frames.
+ * @return True if the file is opened.
+ */
+bool VariableSizeRawFile::Open( const string& RawFileName, int eFrameSize )
+{
+	Close();
+
+	string TableFileName = GetOffsetTableFileName( RawFileName );
+	FrameOffsetTableHeader Header;
+
+	if ( eFrameSize <= 0 || fTable.Open( TableFileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		return false;
+	}
+
+	if ( fTable.ReadAt( &Header, sizeof(Header), 0 ) != sizeof(Header) || memcmp( Header.Magic, Magic, sizeof(Magic) ) != 0 || Header.Version != CurrentVersion )
+	{
+		fprintf( stderr, "'%s' is not a frame offset table (or has an unsupported version).\n", TableFileName.c_str() );
+		Close();
+		return false;
+	}
+
+	if ( fRaw.Open( RawFileName.c_str(), DataFile::READ_MODE ) == false )
+	{
+		Close();
+		return false;
+	}
+
+	FrameSize = eFrameSize;
+
+	return UpdateTable();
+}
+
+/** @brief Close the files.
+ */
+void VariableSizeRawFile::Close()
+{
+	fRaw.Close();
+	fTable.Close();
+	Entries.clear();
+}
+
+/** @brief Load entries appended to the offset table since the last loading.
+ *
+ * @return True if the table was read.
+ */
+bool VariableSizeRawFile::UpdateTable()
+{
+	FrameOffsetEntry NewEntries[1024];
+
+	if ( fTable.IsOpen() == false )
+	{
+		return false;
+	}
+
+	for(;;)
+	{
+		int64_t Position = (int64_t)sizeof(FrameOffsetTableHeader) + (int64_t)Entries.size()*(int64_t)sizeof(FrameOffsetEntry);
+		size_t NbRead = fTable.ReadAt( NewEntries, sizeof(NewEntries), Position );
+
+		// An entry being written is loaded next time
+		Entries.insert( Entries.end(), NewEntries, NewEntries + NbRead/sizeof(FrameOffsetEntry) );
+
+		if ( NbRead < sizeof(NewEntries) )
+		{
+			return true;
+		}
+	}
+}
+
+/** @brief Use worker threads to decode several frames at once (see DecodeFrames).
+ *
+ * @param eNumberOfThreads [in] Number of threads, 0 for the number of hardware threads (default), 1 to decode in the calling thread.
+ */
+void VariableSizeRawFile::SetNumberOfThreads( unsigned int eNumberOfThreads )
+{
+	Workers.reset();
+	NumberOfThreads = eNumberOfThreads;
+}
+
+/** @brief Read and decode consecutive frames. Payloads are read by the calling thread (in one read if they
+ *		   are contiguous) and decoded in parallel.
+ *
+ * @param FirstFrame [in] Zero based index of the first frame.
+ * @param NumberOfFrames [in] Number of frames.
+ * @param Output [out] Buffer of NumberOfFrames*FrameSize bytes.
+ * @return True if all frames were decoded.
+ */
+bool VariableSizeRawFile::DecodeFrames( int64_t FirstFrame, int64_t NumberOfFrames, unsigned char * Output )
+{
+	vector<size_t> Positions;
+
+	if ( IsOpen() == false || FirstFrame < 0 || NumberOfFrames < 0 )
+	{
+		return false;
+	}
+
+	if ( NumberOfFrames == 0 )
+	{
+		return true;
+	}
+
+	if ( FirstFrame + NumberOfFrames > (int64_t)Entries.size() )
+	{
+		// Frames may have been written since
+		if ( UpdateTable() == false || FirstFrame + NumberOfFrames > (int64_t)Entries.size() )
+		{
+			return false;
+		}
+	}
+
+	if ( ReadPayloads( FirstFrame, NumberOfFrames, Positions ) == false )
+	{
+		return false;
+	}
+
+	if ( NumberOfFrames <= 1 || NumberOfThreads == 1 )
+	{
+		for( int64_t i = 0; i < NumberOfFrames; i++ )
+		{
+			if ( Decoder( &Payloads[Positions[i]], (size_t)Entries[FirstFrame+i].Size, Output + i*(int64_t)FrameSize, (size_t)FrameSize ) == false )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Frames are independent, decode them in parallel
+	if ( Workers == nullptr )
+	{
+		Workers.reset( new ThreadPool( NumberOfThreads ) );
+	}
+
+	vector< future<bool> > Results;
+	for( int64_t i = 0; i < NumberOfFrames; i++ )
+	{
+		const unsigned char * Payload = &Payloads[Positions[i]];
+		size_t PayloadSize = (size_t)Entries[FirstFrame+i].Size;
+		unsigned char * FrameOutput = Output + i*(int64_t)FrameSize;
+
+		Results.push_back( Workers->Submit( [=]() { return Decoder( Payload, PayloadSize, FrameOutput, (size_t)FrameSize ); } ) );
+	}
+
+	bool Result = true;
+	for( size_t i = 0; i < Results.size(); i++ )
+	{
+		Result = Results[i].get() && Result;
+	}
+
+	return Result;
+}
+
+/** @brief Read the payloads of consecutive frames in Payloads.
+ *
+ * @param FirstFrame [in] Zero based index of the first frame.
+ * @param NumberOfFrames [in] Number of frames.
+ * @param Positions [out] Position of each payload in Payloads.
+ * @return True if all payloads were read.
+ */
+bool VariableSizeRawFile::ReadPayloads( int64_t FirstFrame, int64_t NumberOfFrames, vector<size_t>& Positions )
+{
+	size_t TotalSize = 0;
+	bool Contiguous = true;
+	int64_t End = Entries[(size_t)FirstFrame].Offset;
+
+	Positions.resize( (size_t)NumberOfFrames );
+	for( int64_t i = 0; i < NumberOfFrames; i++ )
+	{
+		const FrameOffsetEntry& Entry = Entries[(size_t)(FirstFrame+i)];
+		if ( Entry.Offset < 0 || Entry.Size < 0 )
+		{
+			return false;
+		}
+
+		Contiguous = Contiguous && (Entry.Offset == End);
+		End = Entry.Offset + Entry.Size;
+
+		Positions[(size_t)i] = TotalSize;
+		TotalSize += (size_t)Entry.Size;
+	}
+
+	// Never empty, payloads may all be empty
+	Payloads.resize( TotalSize + 1 );
+
+	if ( Contiguous == true )
+	{
+		// Frames written one after the other, one read for all of them
+		return (fRaw.ReadAt( &Payloads[0], TotalSize, Entries[(size_t)FirstFrame].Offset ) == TotalSize);
+	}
+
+	for( int64_t i = 0; i < NumberOfFrames; i++ )
+	{
+		const FrameOffsetEntry& Entry = Entries[(size_t)(FirstFrame+i)];
+		if ( fRaw.ReadAt( &Payloads[Positions[(size_t)i]], (size_t)Entry.Size, Entry.Offset ) != (size_t)Entry.Size )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** @brief Create a new raw file and its offset table.
+ *
+ * @param RawFileName [in] Name of the raw file.
+ * @return True if the files have been created.
+ */
+bool VariableSizeRawFileWriter::Create( const string& RawFileName )
+{
+	FrameOffsetTableHeader Header;
+
+	Close();
+
+	memset( &Header, 0, sizeof(Header) );
+	memcpy( Header.Magic, VariableSizeRawFile::Magic, sizeof(Header.Magic) );
+	Header.Version = VariableSizeRawFile::CurrentVersion;
+
+	if ( fRaw.Open( RawFileName.c_str(), DataFile::WRITE_MODE ) == false )
+	{
+		return false;
+	}
+
+	if ( fTable.Open( VariableSizeRawFile::GetOffsetTableFileName( RawFileName ).c_str(), DataFile::WRITE_MODE ) == false ||
+		 fTable.Write( &Header, sizeof(Header), 1 ) != 1 )
+	{
+		Close();
+		return false;
+	}
+
+	Position = 0;
+	fTable.Flush();
+
+	return true;
+}
+
+/** @brief Append a frame payload at the end of the file.
+ *
+ * @param Payload [in] Pointer on the payload.
+ * @param PayloadSize [in] Size of the payload.
+ * @return True if the frame has been added.
+ */
+bool VariableSizeRawFileWriter::Append( const void * Payload, size_t PayloadSize )
+{
+	FrameOffsetEntry Entry;
+
+	if ( fRaw.IsOpen() == false || fTable.IsOpen() == false )
+	{
+		return false;
+	}
+
+	if ( PayloadSize > 0 && fRaw.Write( Payload, PayloadSize, 1 ) != 1 )
+	{
+		return false;
+	}
+
+	Entry.Offset = Position;
+	Entry.Size = (int64_t)PayloadSize;
+	Position += (int64_t)PayloadSize;
+
+	// The payload is in the file before its entry, readers never see an incomplete frame
+	fRaw.Flush();
+	if ( fTable.Write( &Entry, sizeof(Entry), 1 ) != 1 )
+	{
+		return false;
+	}
+	fTable.Flush();
+
+	return true;
+}
+
+/** @brief Close the files.
+ *
+ * @return True if the files were closed.
+ */
+bool VariableSizeRawFileWriter::Close()
+{
+	if ( fRaw.IsOpen() == false && fTable.IsOpen() == false )
+	{
+		return false;
+	}
+
+	bool Result = (fRaw.Close() == 0);
+	Result = (fTable.Close() == 0) && Result;
+
+	return Result;
+}
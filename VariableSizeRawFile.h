@@ -0,0 +1,213 @@
+/**
+ * @file VariableSizeRawFile.h
+ * @ingroup DataManagement
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __VARIABLE_SIZE_RAW_FILE_H__
+#define __VARIABLE_SIZE_RAW_FILE_H__
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "DataFile.h"
+#include "ThreadPool.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct FrameOffsetTableHeader VariableSizeRawFile.h
+ * @brief Header (16 bytes) at the beginning of a frame offset table. Values are stored in the native
+ *		  byte order of the machine which created the file.
+ */
+struct FrameOffsetTableHeader
+{
+	char Magic[8];					/*!< @brief Always "MRGBDFOT". */
+	uint32_t Version;				/*!< @brief Version of the format (1). */
+	uint32_t Reserved;				/*!< @brief Reserved for future use, set to 0. */
+};
+
+/**
+ * @struct FrameOffsetEntry VariableSizeRawFile.h
+ * @brief Location of a frame (or subframe) payload in the raw file. Entries follow the header of the table.
+ */
+struct FrameOffsetEntry
+{
+	int64_t Offset;					/*!< @brief Position of the payload in the raw file. */
+	int64_t Size;					/*!< @brief Size of the payload. */
+};
+
+/** @brief Decode a frame payload (JPEG, PNG, compressed depth, ...) in a frame of FrameSize bytes.
+ *		   Decoders are called from several threads at the same time.
+ */
+typedef std::function<bool( const unsigned char * Payload, size_t PayloadSize, unsigned char * Frame, size_t FrameSize )> FrameDecoder;
+
+/** @brief Decoder of payloads stored as is (the default one).
+ */
+bool DecodeStoredFrame( const unsigned char * Payload, size_t PayloadSize, unsigned char * Frame, size_t FrameSize );
+
+/** @brief Decoder of payloads compressed with CompressedRawFile::EncodeFrame (lossless depth, infrared).
+ *
+ * @param Width [in] Width used to encode the frames (0 if unknown).
+ */
+FrameDecoder MakeCompressedFrameDecoder( unsigned int Width );
+
+/**
+ * @class VariableSizeRawFile VariableSizeRawFile.cpp VariableSizeRawFile.h
+ * @brief Raw file where each frame is stored as a payload of its own size (encoded image, compressed frame, ...),
+ *		  located by a sidecar offset table (see GetOffsetTableFileName) giving the position and the size of
+ *		  each payload. Timestamp lines are unchanged. Payloads are decoded on demand with a FrameDecoder,
+ *		  several frames are decoded in parallel by worker threads. The table may grow while reading,
+ *		  new entries are loaded when needed. ReadTimestampRawFile reads these files transparently.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class VariableSizeRawFile
+{
+public:
+	static const char Magic[8];				/*!< @brief Magic value at the beginning of the offset table ("MRGBDFOT"). */
+	static const uint32_t CurrentVersion;	/*!< @brief Version of the format written by this code (1). */
+
+	/** @brief Constructor. No file is opened.
+	 */
+	VariableSizeRawFile();
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~VariableSizeRawFile() {}
+
+	/** @brief Name of the offset table of a raw file (the raw file name followed by ".offsets").
+	 *
+	 * @param RawFileName [in] Name of the raw file.
+	 */
+	static std::string GetOffsetTableFileName( const std::string& RawFileName ) { return RawFileName + ".offsets"; }
+
+	/** @brief Check if a raw file has an offset table, i.e. contains variable size frames.
+	 *
+	 * @param RawFileName [in] Name of the raw file.
+	 */
+	static bool IsVariableSizeRawFile( const std::string& RawFileName );
+
+	/** @brief Open a raw file and load its offset table.
+	 *
+	 * @param RawFileName [in] Name of the raw file (usual or compressed with 7z).
+	 * @param eFrameSize [in] Size of decoded frames.
+	 * @return True if the file is opened.
+	 */
+	bool Open( const std::string& RawFileName, int eFrameSize );
+
+	/** @brief Close the files.
+	 */
+	void Close();
+
+	/** @brief Return true if the file is opened.
+	 */
+	bool IsOpen() { return fRaw.IsOpen(); }
+
+	/** @brief Number of frames (or subframes) in the offset table.
+	 */
+	size_t GetNumberOfFrames() const { return Entries.size(); }
+
+	/** @brief Load entries appended to the offset table since the last loading.
+	 *
+	 * @return True if the table was read.
+	 */
+	bool UpdateTable();
+
+	/** @brief Set the decoder of the payloads (default=DecodeStoredFrame).
+	 *
+	 * @param NewDecoder [in] The decoder.
+	 */
+	void SetDecoder( const FrameDecoder& NewDecoder ) { Decoder = NewDecoder; }
+
+	/** @brief Use worker threads to decode several frames at once (see DecodeFrames).
+	 *
+	 * @param eNumberOfThreads [in] Number of threads, 0 for the number of hardware threads (default), 1 to decode in the calling thread.
+	 */
+	void SetNumberOfThreads( unsigned int eNumberOfThreads );
+
+	/** @brief Read and decode consecutive frames. Payloads are read by the calling thread (in one read if they
+	 *		   are contiguous) and decoded in parallel.
+	 *
+	 * @param FirstFrame [in] Zero based index of the first frame.
+	 * @param NumberOfFrames [in] Number of frames.
+	 * @param Output [out] Buffer of NumberOfFrames*FrameSize bytes.
+	 * @return True if all frames were decoded.
+	 */
+	bool DecodeFrames( int64_t FirstFrame, int64_t NumberOfFrames, unsigned char * Output );
+
+protected:
+	/** @brief Read the payloads of consecutive frames in Payloads.
+	 *
+	 * @param FirstFrame [in] Zero based index of the first frame.
+	 * @param NumberOfFrames [in] Number of frames.
+	 * @param Positions [out] Position of each payload in Payloads.
+	 * @return True if all payloads were read.
+	 */
+	bool ReadPayloads( int64_t FirstFrame, int64_t NumberOfFrames, std::vector<size_t>& Positions );
+
+	DataFile fRaw;								/*!< @brief Raw file containing the payloads. */
+	DataFile fTable;							/*!< @brief Offset table. */
+	std::vector<FrameOffsetEntry> Entries;		/*!< @brief Loaded entries of the offset table. */
+	std::vector<unsigned char> Payloads;		/*!< @brief Payloads read by the last call to DecodeFrames. */
+	int FrameSize;								/*!< @brief Size of decoded frames. */
+	FrameDecoder Decoder;						/*!< @brief Decoder of the payloads. */
+	unsigned int NumberOfThreads;				/*!< @brief Number of threads decoding frames (see SetNumberOfThreads). */
+	std::unique_ptr<ThreadPool> Workers;		/*!< @brief Threads decoding frames in parallel, created when needed. */
+};
+
+/**
+ * @class VariableSizeRawFileWriter VariableSizeRawFile.cpp VariableSizeRawFile.h
+ * @brief Write a raw file with variable size frames and its offset table (see VariableSizeRawFile).
+ *		  Payloads are encoded by the caller. The table is written after each frame, the file can
+ *		  be read while it is recorded.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class VariableSizeRawFileWriter
+{
+public:
+	/** @brief Constructor. No file is opened.
+	 */
+	VariableSizeRawFileWriter() : Position(0) {}
+
+	/** @brief Virtual destructor, always. Close the files if needed.
+	 */
+	virtual ~VariableSizeRawFileWriter() { Close(); }
+
+	/** @brief Create a new raw file and its offset table.
+	 *
+	 * @param RawFileName [in] Name of the raw file.
+	 * @return True if the files have been created.
+	 */
+	bool Create( const std::string& RawFileName );
+
+	/** @brief Append a frame payload at the end of the file.
+	 *
+	 * @param Payload [in] Pointer on the payload.
+	 * @param PayloadSize [in] Size of the payload.
+	 * @return True if the frame has been added.
+	 */
+	bool Append( const void * Payload, size_t PayloadSize );
+
+	/** @brief Close the files.
+	 *
+	 * @return True if the files were closed.
+	 */
+	bool Close();
+
+protected:
+	DataFile fRaw;						/*!< @brief Raw file. */
+	DataFile fTable;					/*!< @brief Offset table. */
+	int64_t Position;					/*!< @brief Position of the next payload. */
+};
+
+} // namespace MobileRGBD
+
+#endif // __VARIABLE_SIZE_RAW_FILE_H__